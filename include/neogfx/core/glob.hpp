@@ -0,0 +1,133 @@
+// glob.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <string_view>
+
+namespace neogfx
+{
+    namespace detail
+    {
+        inline std::size_t glob_utf8_length(std::string_view const& aText, std::size_t aPosition)
+        {
+            auto const lead = static_cast<uint8_t>(aText[aPosition]);
+            std::size_t length = (lead < 0x80u ? 1u : lead < 0xE0u ? 2u : lead < 0xF0u ? 3u : 4u);
+            return std::min(length, aText.size() - aPosition);
+        }
+
+        // Matches the character class starting at aPattern[aPosition] ('[') against aCharacter and returns the
+        // position after the closing ']'; an unterminated class is treated as a literal '['.
+        inline std::size_t glob_match_class(std::string_view const& aPattern, std::size_t aPosition, char aCharacter, bool& aMatched)
+        {
+            auto p = aPosition + 1u;
+            bool const negated = (p < aPattern.size() && (aPattern[p] == '!' || aPattern[p] == '^'));
+            if (negated)
+                ++p;
+            bool matched = false;
+            bool first = true;
+            while (p < aPattern.size() && (aPattern[p] != ']' || first))
+            {
+                first = false;
+                auto low = aPattern[p];
+                if (low == '\\' && p + 1u < aPattern.size())
+                    low = aPattern[++p];
+                auto high = low;
+                if (p + 2u < aPattern.size() && aPattern[p + 1u] == '-' && aPattern[p + 2u] != ']')
+                {
+                    high = aPattern[p + 2u];
+                    p += 2u;
+                }
+                if (static_cast<uint8_t>(aCharacter) >= static_cast<uint8_t>(low) && static_cast<uint8_t>(aCharacter) <= static_cast<uint8_t>(high))
+                    matched = true;
+                ++p;
+            }
+            if (p >= aPattern.size())
+            {
+                aMatched = (aCharacter == '[');
+                return aPosition + 1u;
+            }
+            aMatched = (matched != negated);
+            return p + 1u;
+        }
+    }
+
+    // Shell style wildcard match of the whole of aText: '*' matches any sequence, '?' any single (UTF-8)
+    // character, "[...]" any character in the set ("[!...]" or "[^...]" negates) and '\' escapes the
+    // following pattern character. Runs in O(pattern * text) worst case without allocating.
+    inline bool glob_match(std::string_view const& aPattern, std::string_view const& aText)
+    {
+        std::size_t p = 0u;
+        std::size_t t = 0u;
+        std::size_t starPattern = std::string_view::npos;
+        std::size_t starText = 0u;
+        while (t < aText.size())
+        {
+            if (p < aPattern.size())
+            {
+                auto const patternChar = aPattern[p];
+                if (patternChar == '*')
+                {
+                    starPattern = p++;
+                    starText = t;
+                    continue;
+                }
+                if (patternChar == '?')
+                {
+                    ++p;
+                    t += detail::glob_utf8_length(aText, t);
+                    continue;
+                }
+                if (patternChar == '[')
+                {
+                    bool matched = false;
+                    auto const next = detail::glob_match_class(aPattern, p, aText[t], matched);
+                    if (matched)
+                    {
+                        t += (next == p + 1u ? 1u : detail::glob_utf8_length(aText, t));
+                        p = next;
+                        continue;
+                    }
+                }
+                else
+                {
+                    auto literal = patternChar;
+                    auto next = p + 1u;
+                    if (literal == '\\' && next < aPattern.size())
+                        literal = aPattern[next++];
+                    if (literal == aText[t])
+                    {
+                        p = next;
+                        ++t;
+                        continue;
+                    }
+                }
+            }
+            if (starPattern == std::string_view::npos)
+                return false;
+            // backtrack: let the last '*' swallow one more character
+            p = starPattern + 1u;
+            t = (starText += detail::glob_utf8_length(aText, starText));
+        }
+        while (p < aPattern.size() && aPattern[p] == '*')
+            ++p;
+        return p == aPattern.size();
+    }
+}
\ No newline at end of file
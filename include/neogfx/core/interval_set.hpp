@@ -0,0 +1,382 @@
+// interval_set.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <vector>
+#include <optional>
+#include <limits>
+#include <algorithm>
+
+namespace neogfx
+{
+    // A set of disjoint, non-adjacent closed intervals of positions (e.g. the selected rows of a view), each
+    // carrying a value, supporting interval insert and erase along with the insertion and removal of positions
+    // (which moves every later interval) all in O(log n) in the number of intervals. Implemented as an implicit
+    // treap whose nodes record the gap since the end of the previous interval and their own length rather than
+    // absolute positions, so intervals after an inserted or removed position are never re-keyed.
+    template <typename Position, typename T>
+    class interval_set
+    {
+    public:
+        typedef Position position_type;
+        typedef T value_type;
+        typedef std::size_t size_type;
+        struct interval
+        {
+            position_type first;
+            position_type last;
+            value_type value;
+        };
+    private:
+        typedef uint32_t node_index;
+        static constexpr node_index Nil = ~node_index{};
+        struct node
+        {
+            position_type gap;
+            position_type length;
+            value_type value;
+            position_type span;
+            uint32_t priority;
+            uint32_t count;
+            node_index left;
+            node_index right;
+        };
+        typedef std::vector<node> node_list;
+    public:
+        interval_set() :
+            iRoot{ Nil }, iFreeList{ Nil }, iSeed{ 0x9E3779B9u }
+        {
+        }
+    public:
+        size_type size() const
+        {
+            return count(iRoot);
+        }
+        bool empty() const
+        {
+            return iRoot == Nil;
+        }
+        void clear()
+        {
+            iNodes.clear();
+            iRoot = Nil;
+            iFreeList = Nil;
+        }
+        // The interval containing aPosition, if any.
+        std::optional<interval> find(position_type aPosition) const
+        {
+            position_type offset{};
+            auto n = iRoot;
+            while (n != Nil)
+            {
+                auto const& current = iNodes[n];
+                auto const leftEnd = offset + span(current.left);
+                auto const start = leftEnd + current.gap;
+                if (aPosition < leftEnd)
+                    n = current.left;
+                else if (aPosition < start)
+                    break;
+                else if (aPosition < start + current.length)
+                    return interval{ start, start + current.length - 1u, current.value };
+                else
+                {
+                    offset = start + current.length;
+                    n = current.right;
+                }
+            }
+            return {};
+        }
+        // Adds [aFirst, aLast]; intervals it overlaps or adjoins are absorbed and their values combined with
+        // std::max.
+        void insert(position_type aFirst, position_type aLast, value_type aValue)
+        {
+            auto [before, after] = split_before(iRoot, aFirst, 0u);
+            auto const afterBase = span(before);
+            if (before != Nil && afterBase >= aFirst)
+            {
+                auto const [rest, last] = split(before, count(before) - 1u);
+                aFirst = afterBase - iNodes[last].length;
+                aLast = std::max(aLast, afterBase - 1u);
+                aValue = std::max(aValue, iNodes[last].value);
+                deallocate(last);
+                before = rest;
+            }
+            auto const [absorbed, rest] = split_before(after, aLast + 2u, afterBase);
+            auto const restBase = afterBase + span(absorbed);
+            if (absorbed != Nil)
+            {
+                aLast = std::max(aLast, restBase - 1u);
+                release(absorbed, [&](value_type const& aAbsorbed) { aValue = std::max(aValue, aAbsorbed); });
+            }
+            iRoot = join(before, allocate(aFirst - span(before), aLast - aFirst + 1u, aValue), rest, restBase);
+        }
+        // Removes [aFirst, aLast] from the intervals, splitting any that straddle it.
+        void erase(position_type aFirst, position_type aLast)
+        {
+            auto [before, after] = split_before(iRoot, aFirst, 0u);
+            auto const afterBase = span(before);
+            std::optional<interval> remainder;
+            if (before != Nil && afterBase > aFirst)
+            {
+                auto const& last = iNodes[rightmost(before)];
+                if (afterBase - 1u > aLast)
+                    remainder = interval{ aLast + 1u, afterBase - 1u, last.value };
+                set_last_length(before, last.length - (afterBase - aFirst));
+            }
+            auto const [erased, rest] = split_before(after, aLast + 1u, afterBase);
+            auto const restBase = afterBase + span(erased);
+            if (erased != Nil)
+            {
+                auto const& last = iNodes[rightmost(erased)];
+                if (restBase - 1u > aLast)
+                    remainder = interval{ aLast + 1u, restBase - 1u, last.value };
+                release(erased, [](value_type const&) {});
+            }
+            auto const middle = remainder ?
+                allocate(remainder->first - span(before), remainder->last - remainder->first + 1u, remainder->value) : Nil;
+            iRoot = join(before, middle, rest, restBase);
+        }
+        // Inserts aCount positions before aPosition moving later intervals up; the new positions are outside of
+        // any interval so an interval containing aPosition (other than at its start) is split in two.
+        void insert_positions(position_type aPosition, position_type aCount)
+        {
+            if (aCount == 0u)
+                return;
+            auto const [before, after] = split_before(iRoot, aPosition, 0u);
+            auto const afterBase = span(before);
+            node_index middle = Nil;
+            if (before != Nil && afterBase > aPosition)
+            {
+                auto const& last = iNodes[rightmost(before)];
+                auto const moved = afterBase - aPosition;
+                auto const value = last.value;
+                set_last_length(before, last.length - moved);
+                middle = allocate(aCount, moved, value);
+            }
+            iRoot = join(before, middle, after, afterBase + aCount);
+        }
+        // Removes [aPosition, aPosition + aCount) moving later intervals down; intervals brought together are
+        // combined.
+        void erase_positions(position_type aPosition, position_type aCount)
+        {
+            if (aCount == 0u)
+                return;
+            erase(aPosition, aPosition + aCount - 1u);
+            auto [before, after] = split_before(iRoot, aPosition, 0u);
+            if (after != Nil && before != Nil && first_gap(after) == aCount)
+            {
+                auto const [first, rest] = split(after, 1u);
+                auto const& last = iNodes[rightmost(before)];
+                auto const value = std::max(last.value, iNodes[first].value);
+                set_last_length(before, last.length + iNodes[first].length);
+                set_last_value(before, value);
+                deallocate(first);
+                after = rest;
+            }
+            else if (after != Nil)
+                set_first_gap(after, first_gap(after) - aCount);
+            iRoot = merge(before, after);
+        }
+        // Calls aVisitor with each interval overlapping [aFirst, aLast] in order.
+        template <typename Visitor>
+        void visit(position_type aFirst, position_type aLast, Visitor aVisitor) const
+        {
+            visit(iRoot, 0u, aFirst, aLast, aVisitor);
+        }
+        template <typename Visitor>
+        void visit(Visitor aVisitor) const
+        {
+            visit(iRoot, 0u, 0u, std::numeric_limits<position_type>::max(), aVisitor);
+        }
+    private:
+        uint32_t count(node_index aNode) const
+        {
+            return aNode != Nil ? iNodes[aNode].count : 0u;
+        }
+        // the number of positions up to the end of the last interval of the subtree
+        position_type span(node_index aNode) const
+        {
+            return aNode != Nil ? iNodes[aNode].span : position_type{};
+        }
+        void update(node_index aNode)
+        {
+            auto& n = iNodes[aNode];
+            n.count = count(n.left) + count(n.right) + 1u;
+            n.span = span(n.left) + n.gap + n.length + span(n.right);
+        }
+        uint32_t next_priority()
+        {
+            // xorshift32
+            iSeed ^= iSeed << 13;
+            iSeed ^= iSeed >> 17;
+            iSeed ^= iSeed << 5;
+            return iSeed;
+        }
+        node_index allocate(position_type aGap, position_type aLength, value_type const& aValue)
+        {
+            node const newNode{ aGap, aLength, aValue, aGap + aLength, next_priority(), 1u, Nil, Nil };
+            if (iFreeList != Nil)
+            {
+                auto const n = iFreeList;
+                iFreeList = iNodes[n].right;
+                iNodes[n] = newNode;
+                return n;
+            }
+            iNodes.push_back(newNode);
+            return static_cast<node_index>(iNodes.size() - 1u);
+        }
+        void deallocate(node_index aNode)
+        {
+            iNodes[aNode].right = iFreeList;
+            iFreeList = aNode;
+        }
+        template <typename Visitor>
+        void release(node_index aNode, Visitor aVisitor)
+        {
+            if (aNode == Nil)
+                return;
+            auto const left = iNodes[aNode].left;
+            auto const right = iNodes[aNode].right;
+            aVisitor(iNodes[aNode].value);
+            deallocate(aNode);
+            release(left, aVisitor);
+            release(right, aVisitor);
+        }
+        node_index rightmost(node_index aNode) const
+        {
+            while (iNodes[aNode].right != Nil)
+                aNode = iNodes[aNode].right;
+            return aNode;
+        }
+        position_type first_gap(node_index aNode) const
+        {
+            while (iNodes[aNode].left != Nil)
+                aNode = iNodes[aNode].left;
+            return iNodes[aNode].gap;
+        }
+        void set_first_gap(node_index aNode, position_type aGap)
+        {
+            if (iNodes[aNode].left != Nil)
+                set_first_gap(iNodes[aNode].left, aGap);
+            else
+                iNodes[aNode].gap = aGap;
+            update(aNode);
+        }
+        void set_last_length(node_index aNode, position_type aLength)
+        {
+            if (iNodes[aNode].right != Nil)
+                set_last_length(iNodes[aNode].right, aLength);
+            else
+                iNodes[aNode].length = aLength;
+            update(aNode);
+        }
+        void set_last_value(node_index aNode, value_type const& aValue)
+        {
+            iNodes[rightmost(aNode)].value = aValue;
+        }
+        template <typename Visitor>
+        void visit(node_index aNode, position_type aOffset, position_type aFirst, position_type aLast, Visitor& aVisitor) const
+        {
+            if (aNode == Nil)
+                return;
+            auto const& current = iNodes[aNode];
+            auto const leftEnd = aOffset + span(current.left);
+            auto const start = leftEnd + current.gap;
+            auto const last = start + current.length - 1u;
+            if (aFirst < leftEnd)
+                visit(current.left, aOffset, aFirst, aLast, aVisitor);
+            if (start > aLast)
+                return;
+            if (last >= aFirst)
+                aVisitor(interval{ start, last, current.value });
+            if (last < aLast)
+                visit(current.right, last + 1u, aFirst, aLast, aVisitor);
+        }
+        // intervals starting before aPosition go left, the remainder right; aOffset is the position the
+        // subtree's gaps are relative to
+        std::pair<node_index, node_index> split_before(node_index aNode, position_type aPosition, position_type aOffset)
+        {
+            if (aNode == Nil)
+                return { Nil, Nil };
+            auto const start = aOffset + span(iNodes[aNode].left) + iNodes[aNode].gap;
+            if (start < aPosition)
+            {
+                auto const [left, right] = split_before(iNodes[aNode].right, aPosition, start + iNodes[aNode].length);
+                iNodes[aNode].right = left;
+                update(aNode);
+                return { aNode, right };
+            }
+            auto const [left, right] = split_before(iNodes[aNode].left, aPosition, aOffset);
+            iNodes[aNode].left = right;
+            update(aNode);
+            return { left, aNode };
+        }
+        // first aCount intervals go left, the remainder right
+        std::pair<node_index, node_index> split(node_index aNode, size_type aCount)
+        {
+            if (aNode == Nil)
+                return { Nil, Nil };
+            auto const leftCount = count(iNodes[aNode].left);
+            if (aCount <= leftCount)
+            {
+                auto const [left, right] = split(iNodes[aNode].left, aCount);
+                iNodes[aNode].left = right;
+                update(aNode);
+                return { left, aNode };
+            }
+            auto const [left, right] = split(iNodes[aNode].right, aCount - leftCount - 1u);
+            iNodes[aNode].right = left;
+            update(aNode);
+            return { aNode, right };
+        }
+        node_index merge(node_index aLeft, node_index aRight)
+        {
+            if (aLeft == Nil)
+                return aRight;
+            if (aRight == Nil)
+                return aLeft;
+            if (iNodes[aLeft].priority > iNodes[aRight].priority)
+            {
+                auto const right = merge(iNodes[aLeft].right, aRight);
+                iNodes[aLeft].right = right;
+                update(aLeft);
+                return aLeft;
+            }
+            auto const left = merge(aLeft, iNodes[aRight].left);
+            iNodes[aRight].left = left;
+            update(aRight);
+            return aRight;
+        }
+        // merges aLeft, aMiddle (whose gap is relative to the end of aLeft) and aRight, whose first interval
+        // starts at aRightBase plus its gap
+        node_index join(node_index aLeft, node_index aMiddle, node_index aRight, position_type aRightBase)
+        {
+            if (aRight != Nil)
+                set_first_gap(aRight, aRightBase + first_gap(aRight) - (span(aLeft) + span(aMiddle)));
+            return merge(merge(aLeft, aMiddle), aRight);
+        }
+    private:
+        node_list iNodes;
+        node_index iRoot;
+        node_index iFreeList;
+        uint32_t iSeed;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+// parallel.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <functional>
+#include <algorithm>
+
+namespace neogfx
+{
+    // Data parallel helpers for CPU bound engine subsystems (physics, collision detection, item
+    // model sorting/filtering); work is run on neolib's default thread pool.
+
+    typedef std::function<void(std::size_t aBegin, std::size_t aEnd, std::size_t aSlot)> parallel_range_job;
+
+    // maximum number of slots a parallel_for() can use (pool threads plus the calling thread)
+    std::size_t parallel_concurrency();
+    // Calls aJob with consecutive sub-ranges of [0, aCount) no larger than aGrainSize; idle slots
+    // claim the next sub-range so uneven sub-ranges balance themselves. aSlot is unique to the
+    // participating thread for the duration of the call (0 is the calling thread) and is less
+    // than the effective concurrency so it can index per-thread result buffers. Blocks until
+    // all sub-ranges have completed; the first exception thrown by aJob is rethrown. The calling
+    // thread never waits on pool tasks that have not started so nested use cannot deadlock.
+    void parallel_for(std::size_t aCount, std::size_t aGrainSize, parallel_range_job const& aJob, std::size_t aMaxConcurrency = 0u);
+    // Sorts sub-ranges of at least aGrainSize elements concurrently and then merges adjacent sorted
+    // sub-ranges pairwise (each round of merges also running concurrently). Not stable.
+    template <typename RandomIt, typename Compare>
+    inline void parallel_sort(RandomIt aFirst, RandomIt aLast, Compare aLess, std::size_t aGrainSize)
+    {
+        auto const count = static_cast<std::size_t>(std::distance(aFirst, aLast));
+        auto const chunks = std::min(parallel_concurrency(), count / std::max<std::size_t>(aGrainSize, 1u));
+        if (chunks <= 1u)
+        {
+            std::sort(aFirst, aLast, aLess);
+            return;
+        }
+        auto const chunkSize = (count + chunks - 1u) / chunks;
+        parallel_for(chunks, 1u, [&](std::size_t aBegin, std::size_t aEnd, std::size_t)
+        {
+            for (auto chunk = aBegin; chunk != aEnd; ++chunk)
+                std::sort(aFirst + chunk * chunkSize, aFirst + std::min(count, (chunk + 1u) * chunkSize), aLess);
+        });
+        for (auto width = chunkSize; width < count; width *= 2u)
+        {
+            auto const merges = (count + width * 2u - 1u) / (width * 2u);
+            parallel_for(merges, 1u, [&](std::size_t aBegin, std::size_t aEnd, std::size_t)
+            {
+                for (auto merge = aBegin; merge != aEnd; ++merge)
+                {
+                    auto const first = merge * width * 2u;
+                    auto const middle = std::min(count, first + width);
+                    auto const last = std::min(count, first + width * 2u);
+                    if (middle < last)
+                        std::inplace_merge(aFirst + first, aFirst + middle, aFirst + last, aLess);
+                }
+            });
+        }
+    }
+}
\ No newline at end of file
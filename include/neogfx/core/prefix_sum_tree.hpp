@@ -0,0 +1,322 @@
+// prefix_sum_tree.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <vector>
+
+namespace neogfx
+{
+    // A sequence of values (e.g. row heights) supporting positional insert, erase and update,
+    // prefix sums and search by cumulative value all in O(log n). Implemented as an implicit treap
+    // (keyed by position) whose nodes record subtree sums; a Fenwick tree would be smaller but cannot
+    // insert or erase without an O(n) rebuild. Elements can be marked stale so that a caller which
+    // cannot recompute a value when it is invalidated can find and refresh it later.
+    template <typename T>
+    class prefix_sum_tree
+    {
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+    private:
+        typedef uint32_t node_index;
+        static constexpr node_index Nil = ~node_index{};
+        struct node
+        {
+            value_type value;
+            value_type sum;
+            uint32_t priority;
+            uint32_t count;
+            uint32_t staleCount;
+            bool stale;
+            node_index left;
+            node_index right;
+        };
+        typedef std::vector<node> node_list;
+    public:
+        prefix_sum_tree() :
+            iRoot{ Nil }, iFreeList{ Nil }, iSeed{ 0x9E3779B9u }
+        {
+        }
+    public:
+        size_type size() const
+        {
+            return count(iRoot);
+        }
+        bool empty() const
+        {
+            return iRoot == Nil;
+        }
+        void clear()
+        {
+            iNodes.clear();
+            iRoot = Nil;
+            iFreeList = Nil;
+        }
+        // Builds a balanced tree from [aFirst, aLast) in O(n).
+        template <typename InputIterator>
+        void assign(InputIterator aFirst, InputIterator aLast)
+        {
+            clear();
+            thread_local std::vector<node_index> spine;
+            spine.clear();
+            for (; aFirst != aLast; ++aFirst)
+            {
+                auto const n = allocate(*aFirst, false);
+                node_index last = Nil;
+                while (!spine.empty() && iNodes[spine.back()].priority < iNodes[n].priority)
+                {
+                    last = spine.back();
+                    spine.pop_back();
+                    update(last);
+                }
+                iNodes[n].left = last;
+                if (!spine.empty())
+                    iNodes[spine.back()].right = n;
+                spine.push_back(n);
+            }
+            if (!spine.empty())
+                iRoot = spine.front();
+            while (!spine.empty())
+            {
+                update(spine.back());
+                spine.pop_back();
+            }
+        }
+        void insert(size_type aPosition, value_type aValue, bool aStale = false)
+        {
+            auto const [left, right] = split(iRoot, aPosition);
+            iRoot = merge(merge(left, allocate(aValue, aStale)), right);
+        }
+        void erase(size_type aPosition)
+        {
+            auto const [left, rest] = split(iRoot, aPosition);
+            auto const [middle, right] = split(rest, 1u);
+            if (middle != Nil)
+                deallocate(middle);
+            iRoot = merge(left, right);
+        }
+        value_type value(size_type aPosition) const
+        {
+            return iNodes[find_node(aPosition)].value;
+        }
+        bool stale(size_type aPosition) const
+        {
+            return iNodes[find_node(aPosition)].stale;
+        }
+        void set_value(size_type aPosition, value_type aValue)
+        {
+            modify(iRoot, aPosition, [aValue](node& aNode) { aNode.value = aValue; aNode.stale = false; });
+        }
+        void invalidate(size_type aPosition)
+        {
+            modify(iRoot, aPosition, [](node& aNode) { aNode.stale = true; });
+        }
+        size_type stale_count() const
+        {
+            return iRoot != Nil ? iNodes[iRoot].staleCount : 0u;
+        }
+        // Position of the first stale element; size() if there is none.
+        size_type first_stale() const
+        {
+            size_type position = 0u;
+            auto n = iRoot;
+            while (n != Nil && iNodes[n].staleCount != 0u)
+            {
+                auto const& current = iNodes[n];
+                if (current.left != Nil && iNodes[current.left].staleCount != 0u)
+                    n = current.left;
+                else if (current.stale)
+                    return position + count(current.left);
+                else
+                {
+                    position += count(current.left) + 1u;
+                    n = current.right;
+                }
+            }
+            return size();
+        }
+        value_type total() const
+        {
+            return sum(iRoot);
+        }
+        // Sum of the values in [0, aPosition).
+        value_type prefix_sum(size_type aPosition) const
+        {
+            value_type result{};
+            auto n = iRoot;
+            while (n != Nil)
+            {
+                auto const& current = iNodes[n];
+                auto const leftCount = count(current.left);
+                if (aPosition <= leftCount)
+                    n = current.left;
+                else
+                {
+                    result += sum(current.left) + current.value;
+                    aPosition -= leftCount + 1u;
+                    n = current.right;
+                }
+            }
+            return result;
+        }
+        // Position of the element whose extent [prefix_sum(p), prefix_sum(p) + value(p)) contains aSum
+        // together with prefix_sum(p); aSum before the first element yields the first element and aSum
+        // after the last element yields the last element. The tree must not be empty.
+        std::pair<size_type, value_type> find(value_type aSum) const
+        {
+            size_type position = 0u;
+            value_type start{};
+            auto n = iRoot;
+            for (;;)
+            {
+                auto const& current = iNodes[n];
+                auto const leftSum = sum(current.left);
+                if (current.left != Nil && aSum < start + leftSum)
+                    n = current.left;
+                else if (aSum < start + leftSum + current.value || current.right == Nil)
+                    return { position + count(current.left), start + leftSum };
+                else
+                {
+                    start += leftSum + current.value;
+                    position += count(current.left) + 1u;
+                    n = current.right;
+                }
+            }
+        }
+    private:
+        uint32_t count(node_index aNode) const
+        {
+            return aNode != Nil ? iNodes[aNode].count : 0u;
+        }
+        value_type sum(node_index aNode) const
+        {
+            return aNode != Nil ? iNodes[aNode].sum : value_type{};
+        }
+        uint32_t stale_count(node_index aNode) const
+        {
+            return aNode != Nil ? iNodes[aNode].staleCount : 0u;
+        }
+        void update(node_index aNode)
+        {
+            auto& n = iNodes[aNode];
+            n.count = count(n.left) + count(n.right) + 1u;
+            n.sum = sum(n.left) + n.value + sum(n.right);
+            n.staleCount = stale_count(n.left) + stale_count(n.right) + (n.stale ? 1u : 0u);
+        }
+        uint32_t next_priority()
+        {
+            // xorshift32
+            iSeed ^= iSeed << 13;
+            iSeed ^= iSeed >> 17;
+            iSeed ^= iSeed << 5;
+            return iSeed;
+        }
+        node_index allocate(value_type aValue, bool aStale)
+        {
+            node const newNode{ aValue, aValue, next_priority(), 1u, aStale ? 1u : 0u, aStale, Nil, Nil };
+            if (iFreeList != Nil)
+            {
+                auto const n = iFreeList;
+                iFreeList = iNodes[n].right;
+                iNodes[n] = newNode;
+                return n;
+            }
+            iNodes.push_back(newNode);
+            return static_cast<node_index>(iNodes.size() - 1u);
+        }
+        void deallocate(node_index aNode)
+        {
+            iNodes[aNode].right = iFreeList;
+            iFreeList = aNode;
+        }
+        node_index find_node(size_type aPosition) const
+        {
+            auto n = iRoot;
+            for (;;)
+            {
+                auto const& current = iNodes[n];
+                auto const leftCount = count(current.left);
+                if (aPosition < leftCount)
+                    n = current.left;
+                else if (aPosition == leftCount)
+                    return n;
+                else
+                {
+                    aPosition -= leftCount + 1u;
+                    n = current.right;
+                }
+            }
+        }
+        template <typename Modifier>
+        void modify(node_index aNode, size_type aPosition, Modifier aModifier)
+        {
+            auto const leftCount = count(iNodes[aNode].left);
+            if (aPosition < leftCount)
+                modify(iNodes[aNode].left, aPosition, aModifier);
+            else if (aPosition == leftCount)
+                aModifier(iNodes[aNode]);
+            else
+                modify(iNodes[aNode].right, aPosition - leftCount - 1u, aModifier);
+            update(aNode);
+        }
+        // first aCount elements go left, the remainder right
+        std::pair<node_index, node_index> split(node_index aNode, size_type aCount)
+        {
+            if (aNode == Nil)
+                return { Nil, Nil };
+            auto const leftCount = count(iNodes[aNode].left);
+            if (aCount <= leftCount)
+            {
+                auto const [left, right] = split(iNodes[aNode].left, aCount);
+                iNodes[aNode].left = right;
+                update(aNode);
+                return { left, aNode };
+            }
+            auto const [left, right] = split(iNodes[aNode].right, aCount - leftCount - 1u);
+            iNodes[aNode].right = left;
+            update(aNode);
+            return { aNode, right };
+        }
+        node_index merge(node_index aLeft, node_index aRight)
+        {
+            if (aLeft == Nil)
+                return aRight;
+            if (aRight == Nil)
+                return aLeft;
+            if (iNodes[aLeft].priority > iNodes[aRight].priority)
+            {
+                auto const right = merge(iNodes[aLeft].right, aRight);
+                iNodes[aLeft].right = right;
+                update(aLeft);
+                return aLeft;
+            }
+            auto const left = merge(aLeft, iNodes[aRight].left);
+            iNodes[aRight].left = left;
+            update(aRight);
+            return aRight;
+        }
+    private:
+        node_list iNodes;
+        node_index iRoot;
+        node_index iFreeList;
+        uint32_t iSeed;
+    };
+}
\ No newline at end of file
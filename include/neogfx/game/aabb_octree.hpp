@@ -20,6 +20,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <unordered_map>
 #include <boost/pool/pool_alloc.hpp>
 #include <neolib/core/vecarray.hpp>
 #include <neolib/core/lifetime.hpp>
@@ -39,6 +40,8 @@ namespace neogfx::game
         typedef typename allocator_type::const_pointer const_pointer;
         typedef typename allocator_type::reference reference;
         typedef typename allocator_type::const_reference const_reference;
+    public:
+        static constexpr scalar DefaultFatMargin = 4.0;
     public:
         typedef const void* const_iterator; // todo
         typedef void* iterator; // todo
@@ -182,6 +185,58 @@ namespace neogfx::game
                 if (aabb_intersects(previousAabb, iAabb))
                     remove_entity(aEntity, aCollider, previousAabb);
             }
+            void insert_entity(entity_id aEntity, const neogfx::aabb& aAabb)
+            {
+                iTree.iDepth = std::max(iTree.iDepth, iDepth);
+                if (is_split())
+                {
+                    if (aabb_intersects(iOctants[0][0][0], aAabb))
+                        child<0, 0, 0>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[0][1][0], aAabb))
+                        child<0, 1, 0>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[1][0][0], aAabb))
+                        child<1, 0, 0>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[1][1][0], aAabb))
+                        child<1, 1, 0>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[0][0][1], aAabb))
+                        child<0, 0, 1>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[0][1][1], aAabb))
+                        child<0, 1, 1>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[1][0][1], aAabb))
+                        child<1, 0, 1>().insert_entity(aEntity, aAabb);
+                    if (aabb_intersects(iOctants[1][1][1], aAabb))
+                        child<1, 1, 1>().insert_entity(aEntity, aAabb);
+                }
+                else
+                {
+                    iEntities.push_back(aEntity);
+                    if (iEntities.size() > BucketSize && (iAabb.max - iAabb.min).min() > iTree.minimum_octant_size())
+                        split();
+                }
+            }
+            void erase_entity(entity_id aEntity, const neogfx::aabb& aAabb)
+            {
+                auto existing = std::find(iEntities.begin(), iEntities.end(), aEntity);
+                if (existing != iEntities.end())
+                    iEntities.erase(existing);
+                if (has_child<0, 0, 0>() && aabb_intersects(iOctants[0][0][0], aAabb))
+                    child<0, 0, 0>().erase_entity(aEntity, aAabb);
+                if (has_child<0, 1, 0>() && aabb_intersects(iOctants[0][1][0], aAabb))
+                    child<0, 1, 0>().erase_entity(aEntity, aAabb);
+                if (has_child<1, 0, 0>() && aabb_intersects(iOctants[1][0][0], aAabb))
+                    child<1, 0, 0>().erase_entity(aEntity, aAabb);
+                if (has_child<1, 1, 0>() && aabb_intersects(iOctants[1][1][0], aAabb))
+                    child<1, 1, 0>().erase_entity(aEntity, aAabb);
+                if (has_child<0, 0, 1>() && aabb_intersects(iOctants[0][0][1], aAabb))
+                    child<0, 0, 1>().erase_entity(aEntity, aAabb);
+                if (has_child<0, 1, 1>() && aabb_intersects(iOctants[0][1][1], aAabb))
+                    child<0, 1, 1>().erase_entity(aEntity, aAabb);
+                if (has_child<1, 0, 1>() && aabb_intersects(iOctants[1][0][1], aAabb))
+                    child<1, 0, 1>().erase_entity(aEntity, aAabb);
+                if (has_child<1, 1, 1>() && aabb_intersects(iOctants[1][1][1], aAabb))
+                    child<1, 1, 1>().erase_entity(aEntity, aAabb);
+                prune();
+            }
             bool empty() const
             {
                 bool result = iEntities.empty();
@@ -227,7 +282,7 @@ namespace neogfx::game
             void visit(const neogfx::aabb& aAabb, const Visitor& aVisitor) const
             {
                 for (auto e : entities())
-                    if (aabb_intersects(aAabb, iTree.iEcs.component<collider_type>().entity_record(e).currentAabb))
+                    if (aabb_intersects(aAabb, iTree.iEcs.component<collider_type>().entity_record_no_lock(e).currentAabb))
                         aVisitor(e);
                 if (has_child<0, 0, 0>() && aabb_intersects(iOctants[0][0][0], aAabb))
                     child<0, 0, 0>().visit(aAabb, aVisitor);
@@ -250,8 +305,8 @@ namespace neogfx::game
             void visit(const neogfx::aabb_2d& aAabb, const Visitor& aVisitor) const
             {
                 for (auto e : entities())
-                    if (iTree.iEcs.component<collider_type>().entity_record(e).currentAabb &&
-                        aabb_intersects(aAabb, aabb_2d{ *iTree.iEcs.component<collider_type>().entity_record(e).currentAabb }))
+                    if (iTree.iEcs.component<collider_type>().entity_record_no_lock(e).currentAabb &&
+                        aabb_intersects(aAabb, aabb_2d{ *iTree.iEcs.component<collider_type>().entity_record_no_lock(e).currentAabb }))
                         aVisitor(e);
                 if (has_child<0, 0, 0>() && aabb_intersects(iOctants2d[0][0][0], aAabb))
                     child<0, 0, 0>().visit(aAabb, aVisitor);
@@ -368,6 +423,37 @@ namespace neogfx::game
                 }
                 return false;
             }
+            // destroy children left empty by an erase so that incremental maintenance does not leave
+            // a trail of empty nodes behind moving entities; children not on the erase path cannot
+            // be empty as they would have been pruned when they became so
+            void prune()
+            {
+                if (!is_split())
+                    return;
+                prune_child<0, 0, 0>();
+                prune_child<0, 1, 0>();
+                prune_child<1, 0, 0>();
+                prune_child<1, 1, 0>();
+                prune_child<0, 0, 1>();
+                prune_child<0, 1, 1>();
+                prune_child<1, 0, 1>();
+                prune_child<1, 1, 1>();
+                if (!has_child<0, 0, 0>() && !has_child<0, 1, 0>() && !has_child<1, 0, 0>() && !has_child<1, 1, 0>() &&
+                    !has_child<0, 0, 1>() && !has_child<0, 1, 1>() && !has_child<1, 0, 1>() && !has_child<1, 1, 1>())
+                    iChildren = std::nullopt;
+            }
+            template <std::size_t X, std::size_t Y, std::size_t Z>
+            void prune_child()
+            {
+                if (!has_child<X, Y, Z>())
+                    return;
+                auto n = (*iChildren)[X][Y][Z];
+                if (!n->iEntities.empty() || n->is_split())
+                    return;
+                (*iChildren)[X][Y][Z] = nullptr;
+                n->iParent = nullptr; // we are unlinking it ourselves
+                iTree.destroy_node(*n);
+            }
             bool is_split() const
             {
                 return iChildren != std::nullopt;
@@ -376,23 +462,25 @@ namespace neogfx::game
             {
                 for (auto e : entities())
                 {
-                    auto const& collider = iTree.iEcs.component<collider_type>().entity_record(e);
-                    if (aabb_intersects(iOctants[0][0][0], collider.currentAabb))
-                        child<0, 0, 0>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[0][0][1], collider.currentAabb))
-                        child<0, 0, 1>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[0][1][0], collider.currentAabb))
-                        child<0, 1, 0>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[0][1][1], collider.currentAabb))
-                        child<0, 1, 1>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[1][0][0], collider.currentAabb))
-                        child<1, 0, 0>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[1][0][1], collider.currentAabb))
-                        child<1, 0, 1>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[1][1][0], collider.currentAabb))
-                        child<1, 1, 0>().add_entity(e, collider);
-                    if (aabb_intersects(iOctants[1][1][1], collider.currentAabb))
-                        child<1, 1, 1>().add_entity(e, collider);
+                    auto const placement = iTree.placement(e);
+                    if (!placement)
+                        continue;
+                    if (aabb_intersects(iOctants[0][0][0], *placement))
+                        child<0, 0, 0>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[0][0][1], *placement))
+                        child<0, 0, 1>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[0][1][0], *placement))
+                        child<0, 1, 0>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[0][1][1], *placement))
+                        child<0, 1, 1>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[1][0][0], *placement))
+                        child<1, 0, 0>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[1][0][1], *placement))
+                        child<1, 0, 1>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[1][1][0], *placement))
+                        child<1, 1, 0>().insert_entity(e, *placement);
+                    if (aabb_intersects(iOctants[1][1][1], *placement))
+                        child<1, 1, 1>().insert_entity(e, *placement);
                 }
                 iEntities.clear();
             }
@@ -440,7 +528,8 @@ namespace neogfx::game
             iDepth{ 0 },
             iRootNode{ *this, aRootAabb },
             iMinimumOctantSize{ aMinimumOctantSize },
-            iCollisionUpdateId{ 0 }
+            iCollisionUpdateId{ 0 },
+            iFatMargin{ DefaultFatMargin }
         {
         }
     public:
@@ -448,11 +537,72 @@ namespace neogfx::game
         {
             return iMinimumOctantSize;
         }
-        void full_update()
+        scalar fat_margin() const
+        {
+            return iFatMargin;
+        }
+        void set_fat_margin(scalar aFatMargin)
+        {
+            iFatMargin = aFatMargin;
+        }
+        // incremental maintenance: an entity is placed using its current AABB inflated by the fat
+        // margin and is only re-inserted once its current AABB escapes that placement
+        bool update_entity(entity_id aEntity, const collider_type& aCollider)
+        {
+            if (!aCollider.currentAabb)
+            {
+                remove_entity(aEntity);
+                return false;
+            }
+            auto existing = iPlacements.find(aEntity);
+            if (existing != iPlacements.end())
+            {
+                if (contains(existing->second, *aCollider.currentAabb))
+                    return false;
+                iRootNode.erase_entity(aEntity, existing->second);
+                existing->second = inflate(*aCollider.currentAabb, iFatMargin);
+            }
+            else
+                existing = iPlacements.emplace(aEntity, inflate(*aCollider.currentAabb, iFatMargin)).first;
+            iRootNode.insert_entity(aEntity, existing->second);
+            return true;
+        }
+        void remove_entity(entity_id aEntity)
+        {
+            auto existing = iPlacements.find(aEntity);
+            if (existing == iPlacements.end())
+                return;
+            iRootNode.erase_entity(aEntity, existing->second);
+            iPlacements.erase(existing);
+        }
+        template <typename Predicate>
+        void remove_entities_if(Predicate aPredicate)
+        {
+            for (auto existing = iPlacements.begin(); existing != iPlacements.end();)
+            {
+                if (aPredicate(existing->first))
+                {
+                    iRootNode.erase_entity(existing->first, existing->second);
+                    existing = iPlacements.erase(existing);
+                }
+                else
+                    ++existing;
+            }
+        }
+        std::size_t placement_count() const
+        {
+            return iPlacements.size();
+        }
+        void clear()
         {
+            iPlacements.clear();
             iDepth = 0;
             iRootNode.~node();
             new(&iRootNode) node{ *this, iRootAabb };
+        }
+        void full_update()
+        {
+            clear();
             for (auto entity : iEcs.component<collider_type>().entities())
             {
                 auto& collider = iEcs.component<collider_type>().entity_record(entity);
@@ -498,6 +648,39 @@ namespace neogfx::game
                 });
             }
         }
+        std::size_t collision_candidate_count() const
+        {
+            return iEcs.component<collider_type>().entities().size();
+        }
+        // Reports colliding pairs for candidates [aBegin, aEnd) without updating collider state so
+        // that disjoint ranges can be processed concurrently; as an entity can occupy more than one
+        // leaf the same pair may be reported more than once so callers must deduplicate. The caller
+        // must hold the collider component lock for the duration and aLive (a snapshot of live
+        // entities taken under that lock) is used so that no locks are taken from worker threads.
+        template <typename LiveEntityFilter, typename CollisionAction>
+        void collisions(std::size_t aBegin, std::size_t aEnd, const LiveEntityFilter& aLive, CollisionAction aCollisionAction) const
+        {
+            auto const& colliders = iEcs.component<collider_type>();
+            auto const& candidates = colliders.entities();
+            for (auto index = aBegin; index != aEnd; ++index)
+            {
+                auto const candidate = candidates[index];
+                if (!aLive(candidate))
+                    continue;
+                auto const& candidateCollider = colliders.entity_record_no_lock(candidate);
+                iRootNode.visit(candidateCollider, [&](entity_id aHit)
+                {
+                    if (candidate < aHit)
+                    {
+                        if (!aLive(aHit))
+                            return;
+                        auto const& hitCollider = colliders.entity_record_no_lock(aHit);
+                        if ((candidateCollider.mask & hitCollider.mask) == 0)
+                            aCollisionAction(candidate, aHit);
+                    }
+                });
+            }
+        }
         template <typename ResultContainer>
         void pick(const vec3& aPoint, ResultContainer& aResult, std::function<bool(entity_id aMatch, const vec3& aPoint)> aColliderPredicate = [](entity_id, const vec3&) { return true; }) const
         {
@@ -547,6 +730,22 @@ namespace neogfx::game
             return iRootNode;
         }
     private:
+        std::optional<aabb> placement(entity_id aEntity) const
+        {
+            auto existing = iPlacements.find(aEntity);
+            if (existing != iPlacements.end())
+                return existing->second;
+            return iEcs.component<collider_type>().entity_record(aEntity).currentAabb;
+        }
+        static bool contains(const aabb& aOuter, const aabb& aInner)
+        {
+            return aOuter.min.x <= aInner.min.x && aOuter.min.y <= aInner.min.y && aOuter.min.z <= aInner.min.z &&
+                aOuter.max.x >= aInner.max.x && aOuter.max.y >= aInner.max.y && aOuter.max.z >= aInner.max.z;
+        }
+        static aabb inflate(const aabb& aAabb, scalar aMargin)
+        {
+            return aabb{ aAabb.min - vec3{ aMargin, aMargin, aMargin }, aAabb.max + vec3{ aMargin, aMargin, aMargin } };
+        }
         node* create_node(const node& aParent, const aabb& aAabb)
         {
             ++iCount;
@@ -572,5 +771,7 @@ namespace neogfx::game
         mutable uint32_t iDepth;
         node iRootNode;
         mutable uint32_t iCollisionUpdateId;
+        scalar iFatMargin;
+        std::unordered_map<entity_id, aabb> iPlacements;
     };
 }
\ No newline at end of file
@@ -0,0 +1,483 @@
+// aabb_tree.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <unordered_map>
+#include <neogfx/core/numerical.hpp>
+#include <neogfx/game/i_ecs.hpp>
+#include <neogfx/game/entity_info.hpp>
+
+namespace neogfx::game
+{
+    // Dynamic bounding volume hierarchy broadphase (for either box_collider or box_collider_2d);
+    // unlike aabb_quadtree/aabb_octree each entity occupies exactly one leaf regardless of its
+    // size and leaves cache the collider's AABB and mask so queries do not touch the ECS.
+    template <typename Collider>
+    class aabb_tree
+    {
+    public:
+        typedef Collider collider_type;
+        typedef typename decltype(collider_type::currentAabb)::value_type aabb_type;
+        typedef decltype(aabb_type::min) vec_type;
+    public:
+        static constexpr scalar DefaultFatMargin = 4.0;
+    private:
+        typedef int32_t node_index;
+        static constexpr node_index NullNode = -1;
+        struct node
+        {
+            aabb_type fatAabb;
+            aabb_type aabb;
+            uint64_t mask;
+            entity_id entity;
+            node_index parent; // next free node if on the free list
+            node_index child1;
+            node_index child2;
+            int32_t height; // leaf = 0, free = -1
+
+            bool is_leaf() const
+            {
+                return child1 == NullNode;
+            }
+        };
+        typedef std::vector<node> node_list;
+    public:
+        aabb_tree(i_ecs& aEcs) :
+            iEcs{ aEcs },
+            iRoot{ NullNode },
+            iFreeList{ NullNode },
+            iCount{ 0 },
+            iFatMargin{ DefaultFatMargin }
+        {
+        }
+    public:
+        scalar fat_margin() const
+        {
+            return iFatMargin;
+        }
+        void set_fat_margin(scalar aFatMargin)
+        {
+            iFatMargin = aFatMargin;
+        }
+        void clear()
+        {
+            iNodes.clear();
+            iLeaves.clear();
+            iRoot = NullNode;
+            iFreeList = NullNode;
+            iCount = 0;
+        }
+        void full_update()
+        {
+            clear();
+            for (auto entity : iEcs.component<collider_type>().entities())
+            {
+                auto const& info = iEcs.component<entity_info>().entity_record(entity);
+                if (info.destroyed)
+                    continue;
+                update_entity(entity, iEcs.component<collider_type>().entity_record(entity));
+            }
+        }
+        bool update_entity(entity_id aEntity, const collider_type& aCollider)
+        {
+            if (!aCollider.currentAabb)
+            {
+                remove_entity(aEntity);
+                return false;
+            }
+            auto existing = iLeaves.find(aEntity);
+            if (existing != iLeaves.end())
+            {
+                auto& leaf = iNodes[existing->second];
+                leaf.aabb = *aCollider.currentAabb;
+                leaf.mask = aCollider.mask;
+                if (contains(leaf.fatAabb, leaf.aabb))
+                    return false;
+                remove_leaf(existing->second);
+                leaf.fatAabb = inflate(leaf.aabb, iFatMargin);
+                insert_leaf(existing->second);
+                return true;
+            }
+            auto const newLeaf = allocate_node();
+            auto& leaf = iNodes[newLeaf];
+            leaf.aabb = *aCollider.currentAabb;
+            leaf.fatAabb = inflate(leaf.aabb, iFatMargin);
+            leaf.mask = aCollider.mask;
+            leaf.entity = aEntity;
+            leaf.height = 0;
+            iLeaves.emplace(aEntity, newLeaf);
+            insert_leaf(newLeaf);
+            return true;
+        }
+        void remove_entity(entity_id aEntity)
+        {
+            auto existing = iLeaves.find(aEntity);
+            if (existing == iLeaves.end())
+                return;
+            remove_leaf(existing->second);
+            free_node(existing->second);
+            iLeaves.erase(existing);
+        }
+        template <typename Predicate>
+        void remove_entities_if(Predicate aPredicate)
+        {
+            for (auto existing = iLeaves.begin(); existing != iLeaves.end();)
+            {
+                if (aPredicate(existing->first))
+                {
+                    remove_leaf(existing->second);
+                    free_node(existing->second);
+                    existing = iLeaves.erase(existing);
+                }
+                else
+                    ++existing;
+            }
+        }
+        std::size_t placement_count() const
+        {
+            return iLeaves.size();
+        }
+        template <typename Visitor>
+        void visit(const aabb_type& aAabb, const Visitor& aVisitor) const
+        {
+            query(aAabb, [&](const node& aLeaf) { aVisitor(aLeaf.entity); });
+        }
+        template <typename CollisionAction>
+        void collisions(CollisionAction aCollisionAction) const
+        {
+            auto const& infos = iEcs.component<entity_info>();
+            collisions(0u, collision_candidate_count(), [&](entity_id aEntity) { return !infos.entity_record_no_lock(aEntity).destroyed; }, aCollisionAction);
+        }
+        std::size_t collision_candidate_count() const
+        {
+            return iNodes.size();
+        }
+        // Reports colliding pairs for candidates [aBegin, aEnd); disjoint ranges can be processed
+        // concurrently and each pair is reported exactly once. aLive is a snapshot of live entities
+        // taken under the caller's component lock so that no locks are taken from worker threads.
+        template <typename LiveEntityFilter, typename CollisionAction>
+        void collisions(std::size_t aBegin, std::size_t aEnd, const LiveEntityFilter& aLive, CollisionAction aCollisionAction) const
+        {
+            for (auto index = aBegin; index != aEnd; ++index)
+            {
+                auto const& candidate = iNodes[index];
+                if (candidate.height != 0)
+                    continue;
+                if (!aLive(candidate.entity))
+                    continue;
+                query(candidate.aabb, [&](const node& aHit)
+                {
+                    if (candidate.entity < aHit.entity && (candidate.mask & aHit.mask) == 0 && aLive(aHit.entity))
+                        aCollisionAction(candidate.entity, aHit.entity);
+                });
+            }
+        }
+        template <typename ResultContainer>
+        void pick(const vec_type& aPoint, ResultContainer& aResult, std::function<bool(entity_id aMatch, const vec_type& aPoint)> aColliderPredicate = [](entity_id, const vec_type&) { return true; }) const
+        {
+            visit(aabb_type{ aPoint, aPoint }, [&](entity_id aMatch)
+            {
+                auto const& matchInfo = iEcs.component<entity_info>().entity_record(aMatch);
+                if (!matchInfo.destroyed && aColliderPredicate(aMatch, aPoint))
+                    aResult.insert(aResult.end(), aMatch);
+            });
+        }
+        template <typename Visitor>
+        void visit_aabbs(const Visitor& aVisitor) const
+        {
+            for (auto const& n : iNodes)
+                if (n.height >= 0)
+                    aVisitor(n.fatAabb);
+        }
+    public:
+        uint32_t count() const
+        {
+            return iCount;
+        }
+        uint32_t depth() const
+        {
+            return iRoot == NullNode ? 0u : static_cast<uint32_t>(iNodes[iRoot].height + 1);
+        }
+    private:
+        template <typename Visitor>
+        void query(const aabb_type& aAabb, const Visitor& aVisitor) const
+        {
+            if (iRoot == NullNode)
+                return;
+            thread_local std::vector<node_index> stack;
+            auto const base = stack.size();
+            stack.push_back(iRoot);
+            while (stack.size() > base)
+            {
+                auto const& n = iNodes[stack.back()];
+                stack.pop_back();
+                if (!aabb_intersects(n.fatAabb, aAabb))
+                    continue;
+                if (n.is_leaf())
+                {
+                    if (aabb_intersects(n.aabb, aAabb))
+                        aVisitor(n);
+                }
+                else
+                {
+                    stack.push_back(n.child1);
+                    stack.push_back(n.child2);
+                }
+            }
+        }
+        node_index allocate_node()
+        {
+            ++iCount;
+            node_index result;
+            if (iFreeList != NullNode)
+            {
+                result = iFreeList;
+                iFreeList = iNodes[result].parent;
+            }
+            else
+            {
+                result = static_cast<node_index>(iNodes.size());
+                iNodes.emplace_back();
+            }
+            auto& n = iNodes[result];
+            n.parent = NullNode;
+            n.child1 = NullNode;
+            n.child2 = NullNode;
+            n.height = 0;
+            n.mask = 0u;
+            return result;
+        }
+        void free_node(node_index aNode)
+        {
+            --iCount;
+            iNodes[aNode].parent = iFreeList;
+            iNodes[aNode].height = -1;
+            iFreeList = aNode;
+        }
+        void insert_leaf(node_index aLeaf)
+        {
+            if (iRoot == NullNode)
+            {
+                iRoot = aLeaf;
+                iNodes[aLeaf].parent = NullNode;
+                return;
+            }
+            // choose the sibling that minimizes the surface area heuristic cost of the resulting tree
+            auto const leafAabb = iNodes[aLeaf].fatAabb;
+            auto index = iRoot;
+            while (!iNodes[index].is_leaf())
+            {
+                auto const& current = iNodes[index];
+                auto const area = cost(current.fatAabb);
+                auto const combinedArea = cost(aabb_union(current.fatAabb, leafAabb));
+                auto const siblingCost = 2.0 * combinedArea;
+                auto const inheritanceCost = 2.0 * (combinedArea - area);
+                auto const descendCost = [&](node_index aChild)
+                {
+                    auto const& child = iNodes[aChild];
+                    auto const combined = cost(aabb_union(leafAabb, child.fatAabb));
+                    return (child.is_leaf() ? combined : combined - cost(child.fatAabb)) + inheritanceCost;
+                };
+                auto const cost1 = descendCost(current.child1);
+                auto const cost2 = descendCost(current.child2);
+                if (siblingCost < cost1 && siblingCost < cost2)
+                    break;
+                index = (cost1 < cost2 ? current.child1 : current.child2);
+            }
+            auto const sibling = index;
+            auto const oldParent = iNodes[sibling].parent;
+            auto const newParent = allocate_node();
+            iNodes[newParent].parent = oldParent;
+            iNodes[newParent].fatAabb = aabb_union(leafAabb, iNodes[sibling].fatAabb);
+            iNodes[newParent].height = iNodes[sibling].height + 1;
+            iNodes[newParent].child1 = sibling;
+            iNodes[newParent].child2 = aLeaf;
+            iNodes[sibling].parent = newParent;
+            iNodes[aLeaf].parent = newParent;
+            if (oldParent != NullNode)
+            {
+                if (iNodes[oldParent].child1 == sibling)
+                    iNodes[oldParent].child1 = newParent;
+                else
+                    iNodes[oldParent].child2 = newParent;
+            }
+            else
+                iRoot = newParent;
+            refit(iNodes[aLeaf].parent);
+        }
+        void remove_leaf(node_index aLeaf)
+        {
+            if (aLeaf == iRoot)
+            {
+                iRoot = NullNode;
+                return;
+            }
+            auto const parent = iNodes[aLeaf].parent;
+            auto const grandParent = iNodes[parent].parent;
+            auto const sibling = (iNodes[parent].child1 == aLeaf ? iNodes[parent].child2 : iNodes[parent].child1);
+            if (grandParent != NullNode)
+            {
+                if (iNodes[grandParent].child1 == parent)
+                    iNodes[grandParent].child1 = sibling;
+                else
+                    iNodes[grandParent].child2 = sibling;
+                iNodes[sibling].parent = grandParent;
+                free_node(parent);
+                refit(grandParent);
+            }
+            else
+            {
+                iRoot = sibling;
+                iNodes[sibling].parent = NullNode;
+                free_node(parent);
+            }
+            iNodes[aLeaf].parent = NullNode;
+        }
+        void refit(node_index aNode)
+        {
+            for (auto index = aNode; index != NullNode; index = iNodes[index].parent)
+            {
+                index = balance(index);
+                auto& n = iNodes[index];
+                n.height = 1 + std::max(iNodes[n.child1].height, iNodes[n.child2].height);
+                n.fatAabb = aabb_union(iNodes[n.child1].fatAabb, iNodes[n.child2].fatAabb);
+            }
+        }
+        // rotate a grandchild up if the subtree heights differ by more than one; returns the new subtree root
+        node_index balance(node_index aA)
+        {
+            auto& a = iNodes[aA];
+            if (a.is_leaf() || a.height < 2)
+                return aA;
+            auto const iB = a.child1;
+            auto const iC = a.child2;
+            auto& b = iNodes[iB];
+            auto& c = iNodes[iC];
+            auto const difference = c.height - b.height;
+            if (difference > 1)
+            {
+                auto const iF = c.child1;
+                auto const iG = c.child2;
+                auto& f = iNodes[iF];
+                auto& g = iNodes[iG];
+                c.child1 = aA;
+                c.parent = a.parent;
+                a.parent = iC;
+                replace_child(c.parent, aA, iC);
+                if (f.height > g.height)
+                {
+                    c.child2 = iF;
+                    a.child2 = iG;
+                    g.parent = aA;
+                    a.fatAabb = aabb_union(b.fatAabb, g.fatAabb);
+                    c.fatAabb = aabb_union(a.fatAabb, f.fatAabb);
+                    a.height = 1 + std::max(b.height, g.height);
+                    c.height = 1 + std::max(a.height, f.height);
+                }
+                else
+                {
+                    c.child2 = iG;
+                    a.child2 = iF;
+                    f.parent = aA;
+                    a.fatAabb = aabb_union(b.fatAabb, f.fatAabb);
+                    c.fatAabb = aabb_union(a.fatAabb, g.fatAabb);
+                    a.height = 1 + std::max(b.height, f.height);
+                    c.height = 1 + std::max(a.height, g.height);
+                }
+                return iC;
+            }
+            if (difference < -1)
+            {
+                auto const iD = b.child1;
+                auto const iE = b.child2;
+                auto& d = iNodes[iD];
+                auto& e = iNodes[iE];
+                b.child1 = aA;
+                b.parent = a.parent;
+                a.parent = iB;
+                replace_child(b.parent, aA, iB);
+                if (d.height > e.height)
+                {
+                    b.child2 = iD;
+                    a.child1 = iE;
+                    e.parent = aA;
+                    a.fatAabb = aabb_union(c.fatAabb, e.fatAabb);
+                    b.fatAabb = aabb_union(a.fatAabb, d.fatAabb);
+                    a.height = 1 + std::max(c.height, e.height);
+                    b.height = 1 + std::max(a.height, d.height);
+                }
+                else
+                {
+                    b.child2 = iE;
+                    a.child1 = iD;
+                    d.parent = aA;
+                    a.fatAabb = aabb_union(c.fatAabb, d.fatAabb);
+                    b.fatAabb = aabb_union(a.fatAabb, e.fatAabb);
+                    a.height = 1 + std::max(c.height, d.height);
+                    b.height = 1 + std::max(a.height, e.height);
+                }
+                return iB;
+            }
+            return aA;
+        }
+        void replace_child(node_index aParent, node_index aOldChild, node_index aNewChild)
+        {
+            if (aParent == NullNode)
+                iRoot = aNewChild;
+            else if (iNodes[aParent].child1 == aOldChild)
+                iNodes[aParent].child1 = aNewChild;
+            else
+                iNodes[aParent].child2 = aNewChild;
+        }
+        static scalar cost(const aabb_type& aAabb)
+        {
+            auto const extents = aAabb.max - aAabb.min;
+            if constexpr (std::is_same_v<aabb_type, aabb_2d>)
+                return 2.0 * (extents.x + extents.y);
+            else
+                return 2.0 * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
+        }
+        static bool contains(const aabb_type& aOuter, const aabb_type& aInner)
+        {
+            if constexpr (std::is_same_v<aabb_type, aabb_2d>)
+                return aOuter.min.x <= aInner.min.x && aOuter.min.y <= aInner.min.y &&
+                    aOuter.max.x >= aInner.max.x && aOuter.max.y >= aInner.max.y;
+            else
+                return aOuter.min.x <= aInner.min.x && aOuter.min.y <= aInner.min.y && aOuter.min.z <= aInner.min.z &&
+                    aOuter.max.x >= aInner.max.x && aOuter.max.y >= aInner.max.y && aOuter.max.z >= aInner.max.z;
+        }
+        static aabb_type inflate(const aabb_type& aAabb, scalar aMargin)
+        {
+            if constexpr (std::is_same_v<aabb_type, aabb_2d>)
+                return aabb_type{ aAabb.min - vec2{ aMargin, aMargin }, aAabb.max + vec2{ aMargin, aMargin } };
+            else
+                return aabb_type{ aAabb.min - vec3{ aMargin, aMargin, aMargin }, aAabb.max + vec3{ aMargin, aMargin, aMargin } };
+        }
+    private:
+        i_ecs& iEcs;
+        node_list iNodes;
+        std::unordered_map<entity_id, node_index> iLeaves;
+        node_index iRoot;
+        node_index iFreeList;
+        uint32_t iCount;
+        scalar iFatMargin;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+// barnes_hut_octree.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/core/numerical.hpp>
+
+namespace neogfx::game
+{
+    // Barnes-Hut approximation of universal gravitation: bodies are binned into an octree whose
+    // nodes record total mass and center of mass; a distant node (size / distance < opening angle)
+    // is treated as a single point mass making the cost of a full step O(n log n) rather than O(n^2).
+    class barnes_hut_octree
+    {
+    public:
+        struct body
+        {
+            vec3 position;
+            scalar mass;
+        };
+    private:
+        struct node
+        {
+            vec3 center;
+            scalar halfSize;
+            vec3 centerOfMass; // sum of mass-weighted positions until build() completes
+            scalar mass;
+            uint32_t count;
+            uint32_t firstChild; // eight contiguous children; zero if leaf
+        };
+        typedef std::vector<node> node_list;
+        typedef std::vector<body> body_list;
+    public:
+        static constexpr scalar DefaultOpeningAngle = 0.5;
+        static constexpr uint32_t DefaultMaximumDepth = 32u;
+    public:
+        barnes_hut_octree(scalar aOpeningAngle = DefaultOpeningAngle, uint32_t aMaximumDepth = DefaultMaximumDepth) :
+            iOpeningAngle{ aOpeningAngle }, iMaximumDepth{ aMaximumDepth }
+        {
+        }
+    public:
+        scalar opening_angle() const
+        {
+            return iOpeningAngle;
+        }
+        void set_opening_angle(scalar aOpeningAngle)
+        {
+            iOpeningAngle = aOpeningAngle;
+        }
+        uint32_t maximum_depth() const
+        {
+            return iMaximumDepth;
+        }
+        uint32_t node_count() const
+        {
+            return static_cast<uint32_t>(iNodes.size());
+        }
+        uint32_t body_count() const
+        {
+            return static_cast<uint32_t>(iBodies.size());
+        }
+    public:
+        void clear()
+        {
+            iBodies.clear();
+            iNodes.clear();
+        }
+        void add(const vec3& aPosition, scalar aMass)
+        {
+            if (aMass != 0.0)
+                iBodies.push_back(body{ aPosition, aMass });
+        }
+        void build()
+        {
+            iNodes.clear();
+            if (iBodies.empty())
+                return;
+            vec3 min = iBodies[0].position;
+            vec3 max = iBodies[0].position;
+            for (auto const& b : iBodies)
+            {
+                min = vec3{ std::min(min.x, b.position.x), std::min(min.y, b.position.y), std::min(min.z, b.position.z) };
+                max = vec3{ std::max(max.x, b.position.x), std::max(max.y, b.position.y), std::max(max.z, b.position.z) };
+            }
+            auto const extents = max - min;
+            auto const halfSize = std::max(std::max(extents.x, extents.y), std::max(extents.z, 1.0)) * 0.5 * 1.0001;
+            iNodes.push_back(node{ (min + max) / 2.0, halfSize, vec3{}, 0.0, 0u, 0u });
+            for (auto const& b : iBodies)
+                insert(b);
+            for (auto& n : iNodes)
+                if (n.mass != 0.0)
+                    n.centerOfMass = n.centerOfMass / n.mass;
+        }
+        // Gravitational field (acceleration per unit of gravitational constant) at aPosition; bodies
+        // coincident with aPosition (including the body being evaluated) contribute nothing.
+        vec3 field(const vec3& aPosition) const
+        {
+            vec3 result;
+            if (iNodes.empty())
+                return result;
+            thread_local std::vector<uint32_t> stack;
+            stack.clear();
+            stack.push_back(0u);
+            auto const openingAngleSquared = iOpeningAngle * iOpeningAngle;
+            while (!stack.empty())
+            {
+                auto const& n = iNodes[stack.back()];
+                stack.pop_back();
+                if (n.mass == 0.0)
+                    continue;
+                vec3 const delta = n.centerOfMass - aPosition;
+                auto const distanceSquared = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+                auto const size = n.halfSize * 2.0;
+                if (n.firstChild != 0u && (contains(n, aPosition) || size * size >= openingAngleSquared * distanceSquared))
+                {
+                    for (uint32_t child = 0u; child < 8u; ++child)
+                        stack.push_back(n.firstChild + child);
+                    continue;
+                }
+                if (distanceSquared > 0.0)
+                    result += delta * (n.mass / (distanceSquared * std::sqrt(distanceSquared)));
+            }
+            return result;
+        }
+    private:
+        static bool contains(const node& aNode, const vec3& aPosition)
+        {
+            return std::abs(aPosition.x - aNode.center.x) <= aNode.halfSize &&
+                std::abs(aPosition.y - aNode.center.y) <= aNode.halfSize &&
+                std::abs(aPosition.z - aNode.center.z) <= aNode.halfSize;
+        }
+        static uint32_t octant(const node& aNode, const vec3& aPosition)
+        {
+            return (aPosition.x >= aNode.center.x ? 1u : 0u) |
+                (aPosition.y >= aNode.center.y ? 2u : 0u) |
+                (aPosition.z >= aNode.center.z ? 4u : 0u);
+        }
+        static void accumulate(node& aNode, const vec3& aPosition, scalar aMass)
+        {
+            aNode.centerOfMass += aPosition * aMass;
+            aNode.mass += aMass;
+            ++aNode.count;
+        }
+        void subdivide(uint32_t aNode)
+        {
+            auto const firstChild = static_cast<uint32_t>(iNodes.size());
+            auto const center = iNodes[aNode].center;
+            auto const quarterSize = iNodes[aNode].halfSize / 2.0;
+            for (uint32_t child = 0u; child < 8u; ++child)
+            {
+                vec3 const offset{
+                    (child & 1u) ? quarterSize : -quarterSize,
+                    (child & 2u) ? quarterSize : -quarterSize,
+                    (child & 4u) ? quarterSize : -quarterSize };
+                iNodes.push_back(node{ center + offset, quarterSize, vec3{}, 0.0, 0u, 0u });
+            }
+            iNodes[aNode].firstChild = firstChild;
+        }
+        void insert(const body& aBody)
+        {
+            uint32_t current = 0u;
+            uint32_t depth = 1u;
+            for (;;)
+            {
+                if (iNodes[current].firstChild == 0u)
+                {
+                    if (iNodes[current].count == 0u || depth >= iMaximumDepth)
+                    {
+                        accumulate(iNodes[current], aBody.position, aBody.mass);
+                        return;
+                    }
+                    // leaf holds exactly one body; push it down a level
+                    auto const existingPosition = iNodes[current].centerOfMass / iNodes[current].mass;
+                    auto const existingMass = iNodes[current].mass;
+                    subdivide(current);
+                    accumulate(iNodes[iNodes[current].firstChild + octant(iNodes[current], existingPosition)], existingPosition, existingMass);
+                }
+                accumulate(iNodes[current], aBody.position, aBody.mass);
+                current = iNodes[current].firstChild + octant(iNodes[current], aBody.position);
+                ++depth;
+            }
+        }
+    private:
+        scalar iOpeningAngle;
+        uint32_t iMaximumDepth;
+        body_list iBodies;
+        node_list iNodes;
+    };
+}
\ No newline at end of file
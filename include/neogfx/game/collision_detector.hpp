@@ -23,7 +23,9 @@
 #include <neogfx/game/system.hpp>
 #include <neogfx/game/aabb_quadtree.hpp>
 #include <neogfx/game/aabb_octree.hpp>
+#include <neogfx/game/aabb_tree.hpp>
 #include <neogfx/game/box_collider.hpp>
+#include <neogfx/game/mesh_filter.hpp>
 
 namespace neogfx::game
 {
@@ -50,10 +52,21 @@ namespace neogfx::game
         return static_cast<collision_detection_cycle>(static_cast<uint32_t>(aLhs) & static_cast<uint32_t>(aRhs));
     }
 
+    enum class broadphase_algorithm : uint32_t
+    {
+        PartitionTree   = 0x00000000, // aabb_octree/aabb_quadtree
+        AabbTree        = 0x00000001  // aabb_tree
+    };
+
+    typedef std::pair<entity_id, entity_id> collision_pair;
+    typedef std::vector<collision_pair> collision_pairs;
+
     class collision_detector : public game::system<entity_info, box_collider, box_collider_2d>
     {
     public:
         define_event(Collision, collision, entity_id, entity_id)
+        // triggered once per detection cycle in place of Collision when parallel detection is enabled
+        define_event(Collisions, collisions, collision_pairs const&)
     public:
         collision_detector(i_ecs& aEcs);
         ~collision_detector();
@@ -69,20 +82,54 @@ namespace neogfx::game
         template <typename Visitor>
         void visit_aabbs(const Visitor& aVisitor) const
         {
-            iBroadphaseTree.visit_aabbs(aVisitor);
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                iBroadphaseAabbTree.visit_aabbs(aVisitor);
+            else
+                iBroadphaseTree.visit_aabbs(aVisitor);
         }
         template <typename Visitor>
         void visit_aabbs_2d(const Visitor& aVisitor) const
         {
-            iBroadphase2dTree.visit_aabbs(aVisitor);
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                iBroadphase2dAabbTree.visit_aabbs(aVisitor);
+            else
+                iBroadphase2dTree.visit_aabbs(aVisitor);
         }
     public:
+        bool incremental_update_enabled() const;
+        void enable_incremental_update(scalar aFatMargin = aabb_quadtree<box_collider_2d>::DefaultFatMargin);
+        void disable_incremental_update();
+    public:
+        bool parallel_detection_enabled() const;
+        void enable_parallel_detection(std::size_t aMaxThreads = 0u);
+        void disable_parallel_detection();
+    public:
+        broadphase_algorithm broadphase() const;
+        void set_broadphase(broadphase_algorithm aAlgorithm);
         const aabb_octree<box_collider>& broadphase_tree() const;
         const aabb_quadtree<box_collider_2d>& broadphase_2d_tree() const;
+        const aabb_tree<box_collider>& broadphase_aabb_tree() const;
+        const aabb_tree<box_collider_2d>& broadphase_2d_aabb_tree() const;
+    private:
+        struct collider_source
+        {
+            vec3 position;
+            vec3 angle;
+            std::optional<mat44> meshTransformation;
+            uint32_t generation;
+        };
+        typedef std::unordered_map<entity_id, collider_source> collider_sources;
     private:
         void update_colliders();
         void update_trees();
         void detect_collisions();
+        template <typename Tree>
+        void collect_collisions(const Tree& aTree);
+        template <typename Collider, typename Tree>
+        void update_tree(Tree& aTree, std::vector<entity_id>& aDirtyColliders, collider_sources& aSources, std::size_t aLiveColliders);
+        bool collider_source_changed(collider_sources& aSources, entity_id aEntity, const mesh_filter& aMeshFilter, bool aAnimated);
+    private:
+        static constexpr std::size_t CollisionBatchSize = 128u;
     public:
         struct meta
         {
@@ -100,6 +147,23 @@ namespace neogfx::game
     private:
         aabb_octree<box_collider> iBroadphaseTree;
         aabb_quadtree<box_collider_2d> iBroadphase2dTree;
+        aabb_tree<box_collider> iBroadphaseAabbTree;
+        aabb_tree<box_collider_2d> iBroadphase2dAabbTree;
+        broadphase_algorithm iBroadphase;
         std::atomic<bool> iCollidersUpdated;
+        bool iIncrementalUpdate;
+        std::atomic<bool> iRebuildRequested;
+        bool iRebuildPending;
+        uint32_t iGeneration;
+        collider_sources iColliderSources;
+        collider_sources iColliderSources2d;
+        std::vector<entity_id> iDirtyColliders;
+        std::vector<entity_id> iDirtyColliders2d;
+        std::size_t iLiveColliders;
+        std::size_t iLiveColliders2d;
+        bool iParallelDetection;
+        std::size_t iDetectionThreads;
+        std::vector<collision_pairs> iCollisionBuffers;
+        collision_pairs iCollisionPairs;
     };
 }
\ No newline at end of file
@@ -20,8 +20,11 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <mutex>
+#include <unordered_set>
 #include <neogfx/gfx/i_vertex_provider.hpp>
 #include <neolib/ecs/ecs.hpp>
+#include <neogfx/game/entity_info.hpp>
 
 namespace neogfx
 {
@@ -39,12 +42,46 @@ namespace neogfx
             bool run_threaded(const system_id& aSystemId) const override;
         public:
             void destroy_entity(entity_id aEntityId, bool aNotify = true) override;
+            void async_destroy_entity(entity_id aEntityId, bool aNotify = true) override;
+            void pending_destructions(std::vector<entity_id>& aEntities) const;
         public:
             bool cacheable() const override;
             const game::component<game::mesh_render_cache>& cache() const override;
             game::component<game::mesh_render_cache>& cache() override;
+        private:
+            mutable std::mutex iPendingDestructionsMutex;
+            std::unordered_set<entity_id> iPendingDestructions;
         };
 
+        // Skips entities that have been destroyed but whose records have not yet been removed from
+        // their components; while no destruction is pending (the usual case) no lookup is made at
+        // all. Construct once per pass with the relevant components locked; the set of destroyed
+        // entities (pending destructions whose entity info is marked destroyed) is snapshotted at
+        // construction so the filter may then be used from worker threads without taking any further
+        // component locks.
+        class live_entity_filter
+        {
+        public:
+            live_entity_filter(const i_ecs& aEcs);
+        public:
+            bool operator()(entity_id aEntity) const
+            {
+                return iPendingDestructions.empty() ||
+                    !std::binary_search(iPendingDestructions.begin(), iPendingDestructions.end(), aEntity);
+            }
+        private:
+            std::vector<entity_id> iPendingDestructions;
+        };
+
+        template <typename Data, typename Visitor>
+        inline void for_each_live_entity(const i_ecs& aEcs, const component<Data>& aComponent, Visitor aVisitor)
+        {
+            live_entity_filter const live{ aEcs };
+            for (auto entity : aComponent.entities())
+                if (live(entity))
+                    aVisitor(entity);
+        }
+
         template <typename... Systems>
         std::shared_ptr<ecs> make_ecs(ecs_flags aCreationFlags = ecs_flags::Default)
         {
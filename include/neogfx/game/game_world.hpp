@@ -25,6 +25,12 @@
 
 namespace neogfx::game
 {
+    enum class gravitation_algorithm : uint32_t
+    {
+        Exact       = 0x00000000,
+        BarnesHut   = 0x00000001
+    };
+
     class game_world : public game::system<>
     {
     public:
@@ -43,6 +49,10 @@ namespace neogfx::game
         bool universal_gravitation_enabled() const;
         void enable_universal_gravitation();
         void disable_universal_gravitation();
+        gravitation_algorithm universal_gravitation_algorithm() const;
+        void set_universal_gravitation_algorithm(gravitation_algorithm aAlgorithm);
+        scalar barnes_hut_opening_angle() const;
+        void set_barnes_hut_opening_angle(scalar aOpeningAngle);
     public:
         struct meta
         {
@@ -59,5 +69,7 @@ namespace neogfx::game
         };
     private:
         bool iUniversalGravitationEnabled;
+        gravitation_algorithm iUniversalGravitationAlgorithm;
+        scalar iBarnesHutOpeningAngle;
     };
 }
\ No newline at end of file
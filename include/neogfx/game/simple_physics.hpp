@@ -25,9 +25,13 @@
 #include <neogfx/game/mesh_filter.hpp>
 #include <neogfx/game/rigid_body.hpp>
 #include <neogfx/game/mesh_render_cache.hpp>
+#include <neogfx/game/barnes_hut_octree.hpp>
+#include <neogfx/game/game_world.hpp>
 
 namespace neogfx::game
 {
+    class live_entity_filter;
+
     class simple_physics : public game::system<entity_info, box_collider, box_collider_2d, mesh_filter, rigid_body, mesh_render_cache>
     {
     public:
@@ -42,6 +46,12 @@ namespace neogfx::game
         bool universal_gravitation_enabled() const;
         void enable_universal_gravitation();
         void disable_universal_gravitation();
+        gravitation_algorithm universal_gravitation_algorithm() const;
+        void set_universal_gravitation_algorithm(gravitation_algorithm aAlgorithm);
+    public:
+        bool parallel_integration_enabled() const;
+        void enable_parallel_integration(std::size_t aMaxThreads = 0u);
+        void disable_parallel_integration();
     public:
         void yield_after(std::chrono::duration<double, std::milli> aTime);
     public:
@@ -58,7 +68,23 @@ namespace neogfx::game
                 return sName;
             }
         };
+    private:
+        void snapshot_massive_bodies(const component<rigid_body>& aRigidBodies, std::size_t aMassiveCount, const live_entity_filter& aLive);
+        vec3 massive_bodies_field(const vec3& aPosition) const;
+    private:
+        static constexpr std::size_t IntegrationBatchSize = 256u;
     private:
         std::chrono::duration<double, std::milli> iYieldTime = std::chrono::duration<double, std::milli>{ 1.0 };
+        barnes_hut_octree iGravitationTree;
+        bool iParallelIntegration = false;
+        std::size_t iIntegrationThreads = 0u;
+        std::vector<std::vector<entity_id>> iDirtyEntities;
+        struct
+        {
+            std::vector<scalar> x;
+            std::vector<scalar> y;
+            std::vector<scalar> z;
+            std::vector<scalar> mass;
+        } iMassiveBodies;
     };
 }
\ No newline at end of file
@@ -204,6 +204,9 @@ namespace neogfx
         bool active() const;
         i_rendering_context& native_context() const;
         // helpers
+    private:
+        graphics_operation::path_id device_path(const path& aPath) const;
+        graphics_operation::mesh_id device_shape(const game::mesh& aShape) const;
         // attributes
     private:
         type iType;
@@ -35,6 +35,17 @@ namespace neogfx
 {
     namespace graphics_operation
     {
+        // Handles to path and mesh payloads held in the owning queue's per-frame arena.
+        struct path_id
+        {
+            uint32_t index;
+        };
+
+        struct mesh_id
+        {
+            uint32_t index;
+        };
+
         struct set_logical_coordinate_system
         {
             logical_coordinate_system system;
@@ -192,13 +203,13 @@ namespace neogfx
 
         struct draw_path
         {
-            path path;
+            path_id path;
             pen pen;
         };
 
         struct draw_shape
         {
-            game::mesh mesh;
+            mesh_id mesh;
             vec3 position;
             pen pen;
         };
@@ -251,13 +262,13 @@ namespace neogfx
 
         struct fill_path
         {
-            path path;
+            path_id path;
             brush fill;
         };
 
         struct fill_shape
         {
-            game::mesh mesh;
+            mesh_id mesh;
             vec3 position;
             brush fill;
         };
@@ -274,7 +285,7 @@ namespace neogfx
 
         struct draw_mesh
         {
-            game::mesh mesh;
+            mesh_id mesh;
             game::material material;
             mat44 transformation;
             std::optional<game::filter> filter;
@@ -375,7 +386,72 @@ namespace neogfx
         bool batchable(const operation& aLeft, const operation& aRight);
         bool batchable(i_glyph_text const& lhsText, i_glyph_text const& rhsText, glyph const& lhs, glyph const& rhs);
 
-        typedef std::vector<operation> queue;
+        typedef std::vector<operation> operation_list;
         typedef std::pair<operation const*, operation const*> batch;
+
+        // Operations plus an arena for their variable-sized payloads (paths and meshes). Operations refer
+        // to payloads by index; clear() recycles the payload slots, and the capacity of their containers,
+        // for the next frame so a steady-state frame enqueues without allocating. Glyph spans need no
+        // arena: draw_glyphs already refers to shared glyph_text by iterator range.
+        class queue
+        {
+        public:
+            typedef operation_list::const_iterator const_iterator;
+            typedef operation_list::iterator iterator;
+            struct statistics
+            {
+                uint64_t operations;
+                uint64_t payloads;
+                uint64_t payloadBytes;
+                uint64_t allocatedBytes;
+            };
+        private:
+            template <typename Payload>
+            struct slot
+            {
+                Payload payload;
+                std::size_t highWater;
+            };
+        public:
+            queue();
+        public:
+            bool empty() const;
+            std::size_t size() const;
+            const_iterator begin() const;
+            const_iterator end() const;
+            iterator begin();
+            iterator end();
+            const operation_list& operations() const;
+            operation_list& operations();
+            void push_back(const operation& aOperation);
+            void clear();
+        public:
+            path_id new_path(const neogfx::path& aPath);
+            mesh_id new_mesh();
+            mesh_id new_mesh(const game::mesh& aMesh);
+            const neogfx::path& path(path_id aPath) const;
+            neogfx::path& path(path_id aPath);
+            const game::mesh& mesh(mesh_id aMesh) const;
+            game::mesh& mesh(mesh_id aMesh);
+        public:
+            const statistics& last_statistics() const;
+        private:
+            operation_list iOperations;
+            std::vector<slot<neogfx::path>> iPaths;
+            std::vector<slot<game::mesh>> iMeshes;
+            std::size_t iPathsUsed;
+            std::size_t iMeshesUsed;
+            std::size_t iOperationsHighWater;
+            statistics iStatistics;
+        };
+
+        // Conservative logical-coordinate bounds of a drawing operation; std::nullopt for state changes
+        // and for anything whose extent cannot be known up front, which the reorder pass treats as barriers.
+        optional_rect bounding_rect(const queue& aQueue, const operation& aOperation);
+        // Number of batches a backend that batches adjacent batchable() operations would issue.
+        std::size_t batch_count(const queue& aQueue);
+        // Stable regrouping of drawing operations between barriers so that batchable operations become
+        // adjacent; an operation only moves ahead of earlier operations whose bounds it does not overlap.
+        void reorder(queue& aQueue);
     }
 }
\ No newline at end of file
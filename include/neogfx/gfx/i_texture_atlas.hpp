@@ -25,6 +25,15 @@
 
 namespace neogfx
 {
+    struct texture_atlas_page_stats
+    {
+        size extents;
+        dimension usedArea;
+        scalar occupancy;
+        uint32_t subTextureCount;
+        uint32_t freeRectCount;
+    };
+
     class i_texture_atlas
     {
     public:
@@ -39,5 +48,17 @@ namespace neogfx
         virtual i_sub_texture& create_sub_texture(const i_image& aImage) = 0;
         virtual i_sub_texture& create_sub_texture(const i_image& aImage, const rect& aImagePart) = 0;
         virtual void destroy_sub_texture(i_sub_texture& aSubTexture) = 0;
+    public:
+        virtual uint32_t page_count() const = 0;
+        virtual texture_atlas_page_stats page_stats(uint32_t aPageIndex) const = 0;
+        // Repacking moves sub-textures to a new page; only i_sub_texture references see the move as
+        // neogfx::texture copies and ECS components made from a sub-texture cache its page and atlas
+        // location. Relocation is therefore disabled by default and must only be enabled for atlases
+        // whose sub-textures are never used in those ways.
+        virtual bool relocation_enabled() const = 0;
+        virtual void enable_relocation(bool aEnable = true) = 0;
+        // Releases empty pages and, if relocation is enabled, repacks pages whose occupancy is below
+        // aMaximumOccupancy. Must be called on the rendering thread between frames.
+        virtual uint32_t compact(scalar aMaximumOccupancy = 0.5) = 0;
     };
 }
\ No newline at end of file
@@ -41,6 +41,13 @@
 
 namespace neogfx
 {
+    enum class rect_pack_algorithm : uint32_t
+    {
+        Guillotine  = 0x00, // binary tree of splits; freed leaves are merged back into their parent
+        MaxRects    = 0x01, // list of maximal free rectangles; best short side fit
+        Skyline     = 0x02  // bottom-left skyline; insert cost depends on skyline length not element count, space is only reclaimed once empty
+    };
+
     class rect_pack
     {
     private:
@@ -55,16 +62,7 @@ namespace neogfx
             }
             ~node()
             {
-                if (iChildren[0] != nullptr)
-                {
-                    iAllocator.destroy(iChildren[0]);
-                    iAllocator.deallocate(iChildren[0]);
-                }
-                if (iChildren[1] != nullptr)
-                {
-                    iAllocator.destroy(iChildren[1]);
-                    iAllocator.deallocate(iChildren[1]);
-                }
+                destroy_children();
             }
         public:
             bool is_leaf() const 
@@ -76,18 +74,72 @@ namespace neogfx
                 return iRect;
             }
             node* insert(const size& aElementSize);
+            bool remove(const neogfx::rect& aRect);
+            std::size_t free_leaf_count() const;
+        private:
+            void destroy_children()
+            {
+                if (iChildren[0] != nullptr)
+                {
+                    iAllocator.destroy(iChildren[0]);
+                    iAllocator.deallocate(iChildren[0]);
+                    iChildren[0] = nullptr;
+                }
+                if (iChildren[1] != nullptr)
+                {
+                    iAllocator.destroy(iChildren[1]);
+                    iAllocator.deallocate(iChildren[1]);
+                    iChildren[1] = nullptr;
+                }
+            }
         private:
             allocator_type& iAllocator;
             bool iInUse;
             std::array<node*, 2> iChildren;
             neogfx::rect iRect;
         };
+        typedef std::vector<rect> free_list;
+        struct skyline_segment
+        {
+            coordinate x;
+            coordinate y;
+            dimension width;
+        };
+        typedef std::vector<skyline_segment> skyline;
     public:
-        rect_pack(const size& aDimensions);
+        static constexpr scalar RebuildThreshold = 1.0 / 16.0;
+    public:
+        rect_pack(const size& aDimensions, rect_pack_algorithm aAlgorithm = rect_pack_algorithm::Guillotine);
+    public:
+        rect_pack_algorithm algorithm() const;
+        const size& dimensions() const;
+        dimension used_area() const;
+        scalar occupancy() const;
+        std::size_t free_rect_count() const;
     public:
         bool insert(const size& aElementSize, rect& aResult);
+        // inserts the elements tallest first (which packs more densely than arrival order); aResults
+        // is in the order of aElementSizes with std::nullopt for elements that did not fit
+        std::size_t insert(const std::vector<size>& aElementSizes, std::vector<optional_rect>& aResults);
+        // aRect must be a result of a previous insert; its space becomes available to later inserts
+        void remove(const rect& aRect);
+    private:
+        bool max_rects_insert(const size& aElementSize, rect& aResult);
+        void max_rects_split(const rect& aUsed);
+        void max_rects_merge(rect aFreed);
+        void max_rects_rebuild();
+        bool skyline_insert(const size& aElementSize, rect& aResult);
+        bool skyline_fit(std::size_t aSegment, const size& aElementSize, coordinate& aY) const;
+        void skyline_reset();
     private:
+        rect_pack_algorithm iAlgorithm;
+        size iDimensions;
+        dimension iUsedArea;
         node::allocator_type iAllocator;
         node iRoot;
+        free_list iFreeRects;
+        std::vector<rect> iUsedRects;
+        dimension iFreedSinceRebuild;
+        skyline iSkyline;
     };
 }
\ No newline at end of file
@@ -66,6 +66,8 @@ namespace neogfx
         texture_id atlas_id() const override;
         i_texture& atlas_texture() const override;
         const rect& atlas_location() const override;
+    public:
+        void relocate(i_texture& aAtlasTexture, const rect& aAtlasLocation);
         // attributes
     private:
         texture_id iAtlasId;
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <bitset>
 #include <unordered_map>
 #include <neogfx/gfx/i_texture_manager.hpp>
 #include <neogfx/gfx/i_texture_atlas.hpp>
@@ -32,18 +33,43 @@ namespace neogfx
     private:
         typedef std::map<dimension, std::string> sets;
         typedef std::map<std::u32string, sets> emojis;
+        // single code point emojis: a bitset per block of code points, blocks without emojis share block 0
+        static constexpr uint32_t CodePointBlockBits = 10u;
+        typedef std::bitset<1u << CodePointBlockBits> code_point_block;
+        // emoji sequences: a trie whose nodes' edges are contiguous and sorted by code point
+        struct sequence_node
+        {
+            uint32_t firstEdge;
+            uint32_t edgeCount;
+            bool terminal;
+        };
+        struct sequence_edge
+        {
+            char32_t codePoint;
+            uint32_t node;
+        };
     public:
         emoji_atlas();
     public:
         virtual bool is_emoji(char32_t aCodePoint) const;
         virtual bool is_emoji(const std::u32string& aCodePoints) const;
+        virtual bool is_emoji(char32_t const* aBegin, char32_t const* aEnd) const;
+        virtual std::size_t match_emoji(char32_t const* aBegin, char32_t const* aEnd) const;
         virtual emoji_id emoji(char32_t aCodePoint, dimension aDesiredSize) const;
         virtual emoji_id emoji(const std::u32string& aCodePoints, dimension aDesiredSize = 64) const;
         virtual const i_texture& emoji_texture(emoji_id aId) const;
+    private:
+        void build_lookup();
+        void build_sequence_node(uint32_t aNode, emojis::const_iterator aFirst, emojis::const_iterator aLast, std::size_t aDepth);
+        std::size_t walk_sequence(char32_t const* aBegin, char32_t const* aEnd, bool aLongest) const;
     private:
         const std::string kFilePath;
         std::unique_ptr<i_texture_atlas> iTextureAtlas;
         emojis iEmojis;
         mutable std::unordered_map<std::u32string, std::optional<emoji_id>> iEmojiMap;
+        std::vector<uint16_t> iCodePointBlockIndex;
+        std::vector<code_point_block> iCodePointBlocks;
+        std::vector<sequence_node> iSequenceNodes;
+        std::vector<sequence_edge> iSequenceEdges;
     };
 }
\ No newline at end of file
@@ -513,6 +513,15 @@ namespace neogfx
         function_type iSelectorFunction;
     };
 
+    struct glyph_text_cache_stats
+    {
+        std::size_t entries;
+        std::size_t bytes;
+        std::size_t budget;
+        uint64_t hits;
+        uint64_t misses;
+    };
+
     class i_glyph_text_factory
     {
     public:
@@ -521,6 +530,10 @@ namespace neogfx
         virtual glyph_text create_glyph_text(font const& aFont) = 0;
         virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector) = 0;
         virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, i_font_selector const& aFontSelector) = 0;
+    public:
+        virtual glyph_text_cache_stats cache_stats() const = 0;
+        virtual void set_cache_budget(std::size_t aBytes) = 0;
+        virtual void clear_cache() = 0;
     public:
         glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, std::function<font(std::size_t)> aFontSelector)
         {
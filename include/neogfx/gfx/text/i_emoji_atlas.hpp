@@ -33,6 +33,9 @@ namespace neogfx
     public:
         virtual bool is_emoji(char32_t aCodePoint) const = 0;
         virtual bool is_emoji(const std::u32string& aCodePoints) const = 0;
+        virtual bool is_emoji(char32_t const* aBegin, char32_t const* aEnd) const = 0;
+        // length of the longest emoji sequence (including ZWJ and modifier sequences) that starts at aBegin; zero if none does
+        virtual std::size_t match_emoji(char32_t const* aBegin, char32_t const* aEnd) const = 0;
         virtual emoji_id emoji(char32_t aCodePoint, dimension aDesiredSize) const = 0;
         virtual emoji_id emoji(const std::u32string& aCodePoints, dimension aDesiredSize) const = 0;
         virtual const i_texture& emoji_texture(emoji_id aId) const = 0;
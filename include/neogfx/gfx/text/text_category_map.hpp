@@ -20,6 +20,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <map>
 #include "glyph.hpp"
 #include "i_emoji_atlas.hpp"
 
@@ -28,7 +29,7 @@ namespace neogfx
     namespace detail
     {
         typedef std::pair<uint32_t, text_category> text_category_MAP_VALUE_TYPE;
-        const text_category_MAP_VALUE_TYPE text_category_MAP[] =
+        constexpr text_category_MAP_VALUE_TYPE text_category_MAP[] =
         {
             { 0x00000, text_category::None },
             { 0x00009, text_category::Whitespace },
@@ -1973,9 +1974,89 @@ namespace neogfx
         };
     }
 
+    namespace detail
+    {
+        constexpr std::size_t text_category_MAP_SIZE = sizeof(text_category_MAP) / sizeof(text_category_MAP[0]);
+
+        struct ascii_text_categories
+        {
+            text_category categories[0x80];
+        };
+
+        constexpr ascii_text_categories make_ascii_text_categories()
+        {
+            ascii_text_categories result{};
+            std::size_t range = 0;
+            for (uint32_t ch = 0; ch < 0x80; ++ch)
+            {
+                while (range + 1 < text_category_MAP_SIZE && text_category_MAP[range + 1].first <= ch)
+                    ++range;
+                result.categories[ch] = text_category_MAP[range].second;
+            }
+            return result;
+        }
+
+        constexpr ascii_text_categories ascii_text_category_TABLE = make_ascii_text_categories();
+
+        // Two-stage lookup built once from text_category_MAP: stage one maps each block of code points
+        // to a stage two block of categories; identical blocks (most of the code space) are shared.
+        class text_category_table
+        {
+        public:
+            static constexpr uint32_t BlockBits = 7u;
+            static constexpr uint32_t BlockSize = 1u << BlockBits;
+            static constexpr uint32_t CodePointLimit = 0x110000u;
+        public:
+            text_category_table()
+            {
+                iStage1.reserve(CodePointLimit >> BlockBits);
+                std::vector<text_category> block(BlockSize);
+                std::map<std::vector<text_category>, uint16_t> uniqueBlocks;
+                std::size_t range = 0;
+                for (uint32_t blockStart = 0; blockStart < CodePointLimit; blockStart += BlockSize)
+                {
+                    for (uint32_t ch = blockStart; ch < blockStart + BlockSize; ++ch)
+                    {
+                        while (range + 1 < text_category_MAP_SIZE && text_category_MAP[range + 1].first <= ch)
+                            ++range;
+                        block[ch - blockStart] = text_category_MAP[range].second;
+                    }
+                    auto existing = uniqueBlocks.find(block);
+                    if (existing == uniqueBlocks.end())
+                    {
+                        existing = uniqueBlocks.emplace(block, static_cast<uint16_t>(uniqueBlocks.size())).first;
+                        iStage2.insert(iStage2.end(), block.begin(), block.end());
+                    }
+                    iStage1.push_back(existing->second);
+                }
+            }
+        public:
+            static const text_category_table& instance()
+            {
+                static const text_category_table sInstance;
+                return sInstance;
+            }
+        public:
+            text_category operator[](char32_t aCodePoint) const
+            {
+                if (aCodePoint < 0x80)
+                    return ascii_text_category_TABLE.categories[aCodePoint];
+                if (aCodePoint >= CodePointLimit)
+                    return text_category_MAP[text_category_MAP_SIZE - 1].second;
+                return iStage2[(static_cast<std::size_t>(iStage1[aCodePoint >> BlockBits]) << BlockBits) | (aCodePoint & (BlockSize - 1u))];
+            }
+        private:
+            std::vector<uint16_t> iStage1;
+            std::vector<text_category> iStage2;
+        };
+    }
+
     inline text_category get_text_category(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd)
     {
         char32_t ch = aCodePoint[0];
+        // the emoji atlas holds no code points below U+0100
+        if (ch < 0x80)
+            return detail::ascii_text_category_TABLE.categories[ch];
         if (aEmojiAtlas.is_emoji(ch))
         {
             if (aCodePoint + 1 == aCodePointEnd || aCodePoint[1] != 0xEF0E)
@@ -1984,17 +2065,7 @@ namespace neogfx
         }
         else if (ch == 0xFE0F || ch == 0xFE0E)
             return text_category::Control;
-        const detail::text_category_MAP_VALUE_TYPE* rangeStart = std::lower_bound(
-            &detail::text_category_MAP[0], 
-            &detail::text_category_MAP[0] + sizeof(detail::text_category_MAP) / sizeof(detail::text_category_MAP[0]),
-            detail::text_category_MAP_VALUE_TYPE(ch, text_category::Unknown),
-            [](const detail::text_category_MAP_VALUE_TYPE& lhs, const detail::text_category_MAP_VALUE_TYPE& rhs) -> bool
-        {
-            return lhs.first < rhs.first;
-        });
-        if (rangeStart != &detail::text_category_MAP[0] && ch < rangeStart->first)
-            --rangeStart;
-        return rangeStart->second;
+        return detail::text_category_table::instance()[ch];
     }
 
     inline text_category get_text_category(const i_emoji_atlas& aEmojiAtlas, char32_t aCodePoint)
@@ -2002,9 +2073,28 @@ namespace neogfx
         return get_text_category(aEmojiAtlas, &aCodePoint, &aCodePoint + 1);
     }
 
-    inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd, text_direction aExistingDirection)
+    // classifies [aBegin, aEnd) into aResult (which must have room for aEnd - aBegin categories); runs of
+    // ASCII are classified without consulting the emoji atlas or the two-stage table
+    inline void get_text_categories(const i_emoji_atlas& aEmojiAtlas, const char32_t* aBegin, const char32_t* aEnd, text_category* aResult)
     {
-        switch (get_text_category(aEmojiAtlas, aCodePoint, aCodePointEnd))
+        auto const& table = detail::text_category_table::instance();
+        for (auto next = aBegin; next != aEnd; ++next, ++aResult)
+        {
+            char32_t ch = *next;
+            if (ch < 0x80)
+                *aResult = detail::ascii_text_category_TABLE.categories[ch];
+            else if (aEmojiAtlas.is_emoji(ch))
+                *aResult = (next + 1 == aEnd || next[1] != 0xEF0E ? text_category::Emoji : text_category::LTR);
+            else if (ch == 0xFE0F || ch == 0xFE0E)
+                *aResult = text_category::Control;
+            else
+                *aResult = table[ch];
+        }
+    }
+
+    inline text_direction get_text_direction(text_category aCategory, text_direction aExistingDirection)
+    {
+        switch (aCategory)
         {
         case text_category::LTR:
             return text_direction::LTR;
@@ -2032,6 +2122,11 @@ namespace neogfx
         }
     }
 
+    inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd, text_direction aExistingDirection)
+    {
+        return get_text_direction(get_text_category(aEmojiAtlas, aCodePoint, aCodePointEnd), aExistingDirection);
+    }
+
     inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, char32_t aCodePoint, text_direction aExistingDirection)
     {
         return get_text_direction(aEmojiAtlas, &aCodePoint, &aCodePoint + 1, aExistingDirection);
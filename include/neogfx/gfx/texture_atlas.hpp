@@ -21,7 +21,6 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
-#include <set>
 #include <tuple>
 #include "i_texture_atlas.hpp"
 #include "i_texture_manager.hpp"
@@ -38,34 +37,34 @@ namespace neogfx
     private:
         struct fragments
         {
-            struct fragment_less_than
-            {
-                bool operator()(const rect& aLhs, const rect& aRhs) const
-                {
-                    return std::forward_as_tuple(aLhs.width() * aLhs.height(), aLhs.top_left()) <
-                        std::forward_as_tuple(aRhs.width() * aRhs.height(), aRhs.top_left());
-                }
-            };
             rect_pack pack;
-            std::set<rect, fragment_less_than> used;
-            std::set<rect, fragment_less_than> freed; // todo: use this when bin pack is full
+            uint32_t count;
+            fragments(const size& aPageSize, rect_pack_algorithm aAlgorithm) :
+                pack{ aPageSize, aAlgorithm }, count{ 0u }
+            {
+            }
             bool insert(const size& aSize, rect& aResult)
             {
                 if (pack.insert(aSize, aResult))
                 {
-                    used.insert(aResult);
+                    ++count;
                     return true;
                 }
                 else
                     return false;
             }
+            void remove(const rect& aRect)
+            {
+                pack.remove(aRect);
+                --count;
+            }
         };
         typedef std::pair<texture, fragments> page;
         typedef std::list<page> pages;
         typedef std::pair<pages::iterator, neogfx::sub_texture> entry;
         typedef std::unordered_map<texture_id, entry> entries;
     public:
-        texture_atlas(const size& aPageSize);
+        texture_atlas(const size& aPageSize, rect_pack_algorithm aAlgorithm = rect_pack_algorithm::MaxRects);
     public:
         const i_sub_texture& sub_texture(texture_id aSubTextureId) const override;
         i_sub_texture& sub_texture(texture_id aSubTextureId) override;
@@ -73,13 +72,22 @@ namespace neogfx
         i_sub_texture& create_sub_texture(const i_image& aImage) override;
         i_sub_texture& create_sub_texture(const i_image& aImage, const rect& aImagePart) override;
         void destroy_sub_texture(i_sub_texture& aSubTexture) override;
+    public:
+        uint32_t page_count() const override;
+        texture_atlas_page_stats page_stats(uint32_t aPageIndex) const override;
+        bool relocation_enabled() const override;
+        void enable_relocation(bool aEnable = true) override;
+        uint32_t compact(scalar aMaximumOccupancy = 0.5) override;
     private:
         const size& page_size() const;
         pages::iterator create_page(dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat);
         std::pair<pages::iterator, rect> allocate_space(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat);
+        bool repack_page(pages::iterator aPage);
     private:
         i_texture_manager& iTextureManager;
         size iPageSize;
+        rect_pack_algorithm iAlgorithm;
+        bool iRelocationEnabled;
         pages iPages;
         entries iEntries;
     };
@@ -56,7 +56,6 @@ namespace neogfx
         {
             optional_dimension manual;
             dimension calculated;
-            dimension max;
         };
     public:
         header_view(i_header_view_owner& aOwner, header_view_type aType = header_view_type::Horizontal);
@@ -100,9 +99,10 @@ namespace neogfx
         virtual void items_filtered();
     private:
         void init();
+        void request_update(bool aUpdateButtons);
         void update_buttons();
-        void update_from_row(uint32_t aRow, i_graphics_context& aGc);
-        bool update_section_width(uint32_t aColumn, const size& aCellExtents, i_graphics_context& aGc);
+        void update_section_widths();
+        bool update_section_width(uint32_t aColumn, i_graphics_context& aGc);
     private:
         i_header_view_owner& iOwner;
         sink iSink;
@@ -335,5 +335,27 @@ namespace neogfx
     public:
         virtual const item_cell_info& cell_info(item_model_index const& aIndex) const = 0;
         virtual item_cell_data const& cell_data(item_model_index const& aIndex) const = 0;
+    public:
+        // Bulk changes made between begin_update() and end_update() (which nest) are notified as usual
+        // but observers can defer expensive work (e.g. sorting) until updated() is triggered.
+        virtual bool is_updating() const = 0;
+        virtual void begin_update() = 0;
+        virtual void end_update() = 0;
+    };
+
+    class scoped_item_model_update
+    {
+    public:
+        scoped_item_model_update(i_item_model& aModel) :
+            iModel(aModel)
+        {
+            iModel.begin_update();
+        }
+        ~scoped_item_model_update()
+        {
+            iModel.end_update();
+        }
+    private:
+        i_item_model& iModel;
     };
 }
\ No newline at end of file
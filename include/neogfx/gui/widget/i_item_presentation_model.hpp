@@ -156,6 +156,8 @@ namespace neogfx
         declare_event(column_info_changed, item_presentation_model_index::column_type)
         declare_event(item_model_changed, const i_item_model&)
         declare_event(item_added, item_presentation_model_index const&)
+        declare_event(rows_inserted, item_presentation_model_index::row_type, item_presentation_model_index::row_type)
+        declare_event(row_moved, item_presentation_model_index::row_type, item_presentation_model_index::row_type)
         declare_event(item_changed, item_presentation_model_index const&)
         declare_event(item_removed, item_presentation_model_index const&)
         declare_event(item_expanding, item_presentation_model_index const&)
@@ -213,6 +215,12 @@ namespace neogfx
         };
         typedef std::tuple<item_presentation_model_index::column_type, filter_search_key, filter_search_type, case_sensitivity> filter;
         typedef std::optional<filter> optional_filter;
+        enum class column_width_strategy
+        {
+            Exact,      // measure every row
+            Sampled,    // measure the leading rows and an evenly spaced sample of the rest
+            Progressive // as Sampled then measure the remaining rows in the background (see measure_column_widths)
+        };
     public:
         struct no_item_model : std::logic_error { no_item_model() : std::logic_error("neogfx::i_item_presentation_model::no_item_model") {} };
         struct bad_index : std::logic_error { bad_index() : std::logic_error("neogfx::i_item_presentation_model::bad_index") {} };
@@ -235,6 +243,11 @@ namespace neogfx
         virtual void accept(i_meta_visitor& aVisitor, bool aIgnoreCollapsedState = false) = 0;
     public:
         virtual dimension column_width(item_presentation_model_index::column_type aColumnIndex, i_graphics_context const& aGc, bool aIncludePadding = true) const = 0;
+        virtual column_width_strategy width_strategy() const = 0;
+        virtual void set_width_strategy(column_width_strategy aStrategy) = 0;
+        // measures up to aRows rows not yet measured for column widths, triggering visual_appearance_changed if a
+        // column widens; returns true if there are rows still to measure
+        virtual bool measure_column_widths(i_graphics_context const& aGc, item_presentation_model_index::row_type aRows) = 0;
         virtual std::string const& column_heading_text(item_presentation_model_index::column_type aColumnIndex) const = 0;
         virtual size column_heading_extents(item_presentation_model_index::column_type aColumnIndex, i_graphics_context const& aGc) const = 0;
         virtual void set_column_heading_text(item_presentation_model_index::column_type aColumnIndex, std::string const& aHeadingText) = 0;
@@ -264,6 +277,8 @@ namespace neogfx
         virtual void set_cell_padding(optional_padding const& aPadding, i_units_context const& aUnitsContext) = 0;
         virtual bool alternating_row_color() const = 0;
         virtual void set_alternating_row_color(bool aAlternatingColor) = 0;
+        virtual bool uniform_row_heights() const = 0;
+        virtual void set_uniform_row_heights(bool aUniformRowHeights) = 0;
     public:
         virtual dimension item_height(item_presentation_model_index const& aIndex, i_units_context const& aUnitsContext) const = 0;
         virtual double total_height(i_units_context const& aUnitsContext) const = 0;
@@ -293,6 +308,10 @@ namespace neogfx
         virtual optional_sort sorting_by() const = 0;
         virtual void sort_by(item_presentation_model_index::column_type aColumnIndex, optional_sort_direction const& aSortDirection = optional_sort_direction{}) = 0;
         virtual void reset_sort() = 0;
+        // when enabled, sort keys and filters are evaluated on thread pool threads which call the item model's
+        // cell_data() concurrently; only enable it for item models whose reads are thread safe
+        virtual bool parallel_evaluation() const = 0;
+        virtual void set_parallel_evaluation(bool aParallelEvaluation) = 0;
     public:
         virtual optional_item_presentation_model_index find_item(filter_search_key const& aFilterSearchKey, item_presentation_model_index::column_type aColumnIndex = 0, filter_search_type aFilterSearchType = filter_search_type::Prefix, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) const = 0;
     public:
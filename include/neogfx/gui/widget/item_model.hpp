@@ -240,7 +240,8 @@ namespace neogfx
         };
         typedef typename container_traits::template rebind<item_model_index::row_type, column_info>::other::row_cell_array column_info_array;
     public:
-        basic_item_model()
+        basic_item_model() :
+            iUpdateCount{ 0u }
         {
             base_type::set_alive();
         }
@@ -580,6 +581,21 @@ namespace neogfx
                 default_cell_info(aIndex.column()).dataType = static_cast<item_data_type>(aCellData.index());
             ItemChanged.trigger(aIndex);
         }
+    public:
+        bool is_updating() const override
+        {
+            return iUpdateCount != 0u;
+        }
+        void begin_update() override
+        {
+            if (++iUpdateCount == 1u)
+                Updating.trigger();
+        }
+        void end_update() override
+        {
+            if (--iUpdateCount == 0u)
+                Updated.trigger();
+        }
     public:
         using base_type::item;
         value_type& item(item_model_index const& aIndex) override
@@ -650,6 +666,7 @@ namespace neogfx
     private:
         container_type iItems;
         column_info_array iColumns;
+        uint32_t iUpdateCount;
     };
 
     typedef basic_item_model<void*> item_model;
@@ -22,11 +22,15 @@
 #include <neogfx/neogfx.hpp>
 #include <vector>
 #include <deque>
+#include <set>
+#include <regex>
 #include <boost/algorithm/string.hpp>
 #include <neolib/core/vecarray.hpp>
-#include <neolib/core/segmented_array.hpp>
 #include <neolib/core/scoped.hpp>
 #include <neogfx/core/object.hpp>
+#include <neogfx/core/glob.hpp>
+#include <neogfx/core/prefix_sum_tree.hpp>
+#include <neogfx/core/parallel.hpp>
 #include <neogfx/gfx/i_graphics_context.hpp>
 #include <neogfx/app/i_app.hpp>
 #include <neogfx/gui/widget/spin_box.hpp>
@@ -46,6 +50,8 @@ namespace neogfx
         define_declared_event(ColumnInfoChanged, column_info_changed, item_presentation_model_index::column_type)
         define_declared_event(ItemModelChanged, item_model_changed, const i_item_model&)
         define_declared_event(ItemAdded, item_added, item_presentation_model_index const&)
+        define_declared_event(RowsInserted, rows_inserted, item_presentation_model_index::row_type, item_presentation_model_index::row_type)
+        define_declared_event(RowMoved, row_moved, item_presentation_model_index::row_type, item_presentation_model_index::row_type)
         define_declared_event(ItemChanged, item_changed, item_presentation_model_index const&)
         define_declared_event(ItemRemoved, item_removed, item_presentation_model_index const&)
         define_declared_event(ItemExpanding, item_expanding, item_presentation_model_index const&)
@@ -73,6 +79,7 @@ namespace neogfx
         using typename base_type::filter_search_key;
         using typename base_type::filter_search_type;
         using typename base_type::case_sensitivity;
+        using typename base_type::column_width_strategy;
     private:
         typedef ItemModel item_model_type;
         typedef typename item_model_type::container_traits::template rebind<item_presentation_model_index::row_type, cell_meta_type, true>::other container_traits;
@@ -84,7 +91,6 @@ namespace neogfx
         typedef typename container_traits::sibling_iterator sibling_iterator;
         typedef typename container_traits::allocator_type allocator_type;
         typedef typename container_type::value_type row_type;
-        typedef std::optional<i_scrollbar::value_type> optional_position;
     private:
         typedef std::vector<item_presentation_model_index::optional_row_type, typename std::allocator_traits<allocator_type>:: template rebind_alloc<item_presentation_model_index::optional_row_type>> row_map_type;
         typedef std::vector<item_presentation_model_index::optional_column_type, typename std::allocator_traits<allocator_type>:: template rebind_alloc<item_presentation_model_index::optional_column_type>> column_map_type;
@@ -93,23 +99,50 @@ namespace neogfx
             column_info(const item_model_index::optional_column_type modelColumn = {}) : modelColumn{ modelColumn } {}
             mutable item_model_index::optional_column_type modelColumn;
             item_cell_flags flags = item_cell_flags::Default;
-            mutable optional_dimension width;
+            mutable std::multiset<dimension, std::greater<dimension>> cellWidths; // of the cells with cached extents (device units), widest first
+            mutable bool widthsMeasured = false; // all rows (Exact) or a sample of rows have been measured
             mutable std::optional<std::string> headingText;
             mutable font headingFont;
             mutable optional_size headingExtents;
             optional_size imageSize;
         };
         typedef typename container_traits::template rebind<item_presentation_model_index::row_type, column_info>::other::row_cell_array column_info_array;
+        struct sort_key
+        {
+            item_cell_data const* value;
+            std::string folded; // upper cased copy of a string value
+            uint64_t prefix; // first eight bytes of folded, big endian, so most comparisons don't touch the string
+            bool isString;
+        };
+        typedef std::vector<sort_key> sort_key_list;
+        struct sort_entry
+        {
+            item_presentation_model_index::row_type position;
+            item_model_index::row_type modelRow;
+        };
+        struct compiled_filter
+        {
+            item_model_index::column_type modelColumn;
+            filter_search_type type;
+            bool caseInsensitive;
+            std::string key; // upper cased if case insensitive (except for Regex)
+            std::optional<std::regex> pattern;
+        };
+        typedef std::vector<compiled_filter> compiled_filter_list;
+    private:
+        static constexpr std::size_t SortGrainSize = 16384u;
+        static constexpr std::size_t FilterGrainSize = 4096u;
+        static constexpr item_presentation_model_index::row_type WidthSampleSize = 256u;
     public:
         using typename base_type::no_item_model;
         using typename base_type::bad_index;
         using typename base_type::no_mapped_row;
     public:
-        basic_item_presentation_model(bool aSortable = false) : iItemModel{ nullptr }, iSortable{ aSortable }, iAlternatingRowColor{ false }, iInitializing{ false }, iFiltering{ false }
+        basic_item_presentation_model(bool aSortable = false) : iItemModel{ nullptr }, iSortable{ aSortable }, iParallelEvaluation{ false }, iAlternatingRowColor{ false }, iUniformRowHeights{ false }, iWidthStrategy{ column_width_strategy::Exact }, iWidthMeasureCursor{ 0u }, iFilterRefinable{ false }, iInitializing{ false }, iFiltering{ false }
         {
             init();
         }
-        basic_item_presentation_model(i_item_model& aItemModel, bool aSortable = false) : iItemModel{ nullptr }, iSortable{ aSortable }, iAlternatingRowColor{ false }, iInitializing{ false }, iFiltering{ false }
+        basic_item_presentation_model(i_item_model& aItemModel, bool aSortable = false) : iItemModel{ nullptr }, iSortable{ aSortable }, iParallelEvaluation{ false }, iAlternatingRowColor{ false }, iUniformRowHeights{ false }, iWidthStrategy{ column_width_strategy::Exact }, iWidthMeasureCursor{ 0u }, iFilterRefinable{ false }, iInitializing{ false }, iFiltering{ false }
         {
             init();
             set_item_model(aItemModel);
@@ -151,9 +184,13 @@ namespace neogfx
                         for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
                             item_added(item_model_index{ row });
                     }
+                    iFilterRefinable = false;
                     reset_maps();
                     reset_meta();
-                    reset_sort();
+                    if (aHardReset)
+                        reset_sort();
+                    else
+                        execute_sort();
                     ItemModelChanged.trigger(item_model());
                 };
                 iItemModelSink.clear();
@@ -248,16 +285,57 @@ namespace neogfx
         {
             if (iColumns.size() < aColumnIndex + 1u)
                 return 0.0;
-            auto& columnWidth = column(aColumnIndex).width;
-            if (columnWidth != std::nullopt)
-                return *columnWidth + (aIncludePadding ? cell_padding(aGc).size().cx : 0.0);
-            columnWidth = 0.0;
-            for (item_presentation_model_index::row_type row = 0u; row < rows(); ++row)
-            {
-                auto const cellWidth = cell_extents(item_presentation_model_index{ row, aColumnIndex }, aGc).cx;
-                columnWidth = std::max(*columnWidth, cellWidth);
+            measure_unmeasured_rows(aGc);
+            auto const& columnInfo = column(aColumnIndex);
+            if (!columnInfo.widthsMeasured)
+            {
+                columnInfo.widthsMeasured = true;
+                if (iWidthStrategy == column_width_strategy::Exact || rows() <= WidthSampleSize * 2u)
+                {
+                    for (item_presentation_model_index::row_type row = 0u; row < rows(); ++row)
+                        cell_extents(item_presentation_model_index{ row, aColumnIndex }, aGc);
+                }
+                else
+                {
+                    // the leading rows (what a view shows first) and an evenly spaced sample of the rest
+                    for (item_presentation_model_index::row_type row = 0u; row < WidthSampleSize; ++row)
+                        cell_extents(item_presentation_model_index{ row, aColumnIndex }, aGc);
+                    auto const step = (rows() - WidthSampleSize) / WidthSampleSize;
+                    for (auto row = WidthSampleSize + step / 2u; row < rows(); row += step)
+                        cell_extents(item_presentation_model_index{ row, aColumnIndex }, aGc);
+                }
             }
-            return *columnWidth + (aIncludePadding ? cell_padding(aGc).size().cx : 0.0);
+            return widest_cell(aColumnIndex, aGc) + (aIncludePadding ? cell_padding(aGc).size().cx : 0.0);
+        }
+        column_width_strategy width_strategy() const override
+        {
+            return iWidthStrategy;
+        }
+        void set_width_strategy(column_width_strategy aStrategy) override
+        {
+            if (iWidthStrategy != aStrategy)
+            {
+                iWidthStrategy = aStrategy;
+                reset_column_meta();
+                VisualAppearanceChanged.trigger();
+            }
+        }
+        bool measure_column_widths(i_graphics_context const& aGc, item_presentation_model_index::row_type aRows) override
+        {
+            std::vector<dimension> widest;
+            for (item_presentation_model_index::column_type col = 0u; col < iColumns.size(); ++col)
+                widest.push_back(widest_cell(col, aGc));
+            measure_unmeasured_rows(aGc);
+            for (; aRows > 0u && iWidthMeasureCursor < rows(); --aRows, ++iWidthMeasureCursor)
+                for (item_presentation_model_index::column_type col = 0u; col < iColumns.size(); ++col)
+                    cell_extents(item_presentation_model_index{ iWidthMeasureCursor, col }, aGc);
+            for (item_presentation_model_index::column_type col = 0u; col < iColumns.size(); ++col)
+                if (widest_cell(col, aGc) > widest[col])
+                {
+                    VisualAppearanceChanged.trigger();
+                    break;
+                }
+            return iWidthMeasureCursor < rows();
         }
         std::string const& column_heading_text(item_presentation_model_index::column_type aColumnIndex) const override
         {
@@ -430,6 +508,7 @@ namespace neogfx
                 iCellSpacing = aSpacing;
             else
                 iCellSpacing = units_converter(aUnitsContext).to_device_units(*aSpacing);
+            reset_position_meta();
         }
         neogfx::padding cell_padding(i_units_context const& aUnitsContext) const override
         {
@@ -445,6 +524,7 @@ namespace neogfx
                 iCellPadding = aPadding;
             else
                 iCellPadding = units_converter(aUnitsContext).to_device_units(*aPadding);
+            reset_position_meta();
         }
         bool alternating_row_color() const override
         {
@@ -454,9 +534,26 @@ namespace neogfx
         {
             iAlternatingRowColor = aAlternatingColor;
         }
+        bool uniform_row_heights() const override
+        {
+            return iUniformRowHeights;
+        }
+        // In uniform row height mode every row is assumed to be a single line of text in the column's
+        // font so row height is measured once (until fonts, padding or spacing change) rather than per
+        // row and row positions become simple arithmetic.
+        void set_uniform_row_heights(bool aUniformRowHeights) override
+        {
+            if (iUniformRowHeights != aUniformRowHeights)
+            {
+                iUniformRowHeights = aUniformRowHeights;
+                reset_position_meta();
+            }
+        }
     public:
         dimension item_height(item_presentation_model_index const& aIndex, i_units_context const& aUnitsContext) const override
         {
+            if (iUniformRowHeights)
+                return uniform_row_height(aUnitsContext);
             dimension height = 0.0;
             for (uint32_t col = 0; col < row(aIndex).cells.size(); ++col)
             {
@@ -483,76 +580,29 @@ namespace neogfx
         }
         double total_height(i_units_context const& aUnitsContext) const override
         {
-            if (iTotalHeight != std::nullopt)
-                return *iTotalHeight;
-            i_scrollbar::value_type height = 0.0;
-            for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
-                height += item_height(item_presentation_model_index(row, 0), aUnitsContext);
-            iTotalHeight = height;
-            return *iTotalHeight;
+            if (iUniformRowHeights)
+                return uniform_row_height(aUnitsContext) * rows();
+            return positions(aUnitsContext).total();
         }
         double item_position(item_presentation_model_index const& aIndex, i_units_context const& aUnitsContext) const override
         {
-            if (iPositions[aIndex.row()] == std::nullopt)
-            {
-                auto pred = [](const optional_position& lhs, const optional_position& rhs) -> bool
-                {
-                    if (lhs == std::nullopt && rhs == std::nullopt)
-                        return false;
-                    else if (lhs != std::nullopt && rhs == std::nullopt)
-                        return true;
-                    else if (lhs == std::nullopt && rhs != std::nullopt)
-                        return false;
-                    else
-                        return *lhs < *rhs;
-                };
-                auto i = std::lower_bound(iPositions.begin(), iPositions.end(), optional_position(), pred);
-                auto row = static_cast<item_presentation_model_index::row_type>(std::distance(iPositions.begin(), i));
-                double position = (row == 0 ? 0.0 : **(std::prev(i)) + item_height(item_presentation_model_index(row - 1), aUnitsContext));
-                while (row <= aIndex.row())
-                {
-                    iPositions[row] = position;
-                    position += item_height(item_presentation_model_index(row), aUnitsContext);
-                    ++row;
-                }
-            }
-            return *iPositions[aIndex.row()];
+            if (iUniformRowHeights)
+                return uniform_row_height(aUnitsContext) * aIndex.row();
+            return positions(aUnitsContext).prefix_sum(aIndex.row());
         }
         std::pair<item_presentation_model_index::row_type, coordinate> item_at(double aPosition, i_units_context const& aUnitsContext) const override
         {
             if (rows() == 0)
                 return std::pair<item_presentation_model_index::row_type, coordinate>{ 0u, 0.0 };
-            auto pred = [](const optional_position& lhs, const optional_position& rhs) -> bool
+            if (iUniformRowHeights)
             {
-                if (lhs == std::nullopt && rhs == std::nullopt)
-                    return false;
-                else if (lhs != std::nullopt && rhs == std::nullopt)
-                    return true;
-                else if (lhs == std::nullopt && rhs != std::nullopt)
-                    return false;
-                else
-                    return *lhs < *rhs;
-            };
-            auto i = std::lower_bound(iPositions.begin(), iPositions.end(), aPosition, pred);
-            if ((i == iPositions.end() || (*i != std::nullopt && **i > aPosition)) && i != iPositions.begin())
-                --i;
-            while (*i == std::nullopt)
-            {
-                auto j = std::lower_bound(iPositions.begin(), iPositions.end(), optional_position(), pred);
-                auto row = static_cast<item_presentation_model_index::row_type>(std::distance(iPositions.begin(), j));
-                double position = (row == 0 ? 0.0 : **(std::prev(j)) + item_height(item_presentation_model_index(row - 1), aUnitsContext));
-                while (row < iPositions.size())
-                {
-                    iPositions[row] = position;
-                    position += item_height(item_presentation_model_index(row), aUnitsContext);
-                    ++row;
-                }
-                i = std::lower_bound(iPositions.begin(), iPositions.end(), aPosition, pred);
-                if ((i == iPositions.end() || (*i != std::nullopt && **i > aPosition)) && i != iPositions.begin())
-                    --i;
+                auto const height = uniform_row_height(aUnitsContext);
+                auto const row = height > 0.0 ? 
+                    static_cast<item_presentation_model_index::row_type>(std::min<double>(std::max(std::floor(aPosition / height), 0.0), rows() - 1u)) : 0u;
+                return std::pair<item_presentation_model_index::row_type, coordinate>{ row, static_cast<coordinate>(height * row - aPosition) };
             }
-            auto const result = std::pair<item_presentation_model_index::row_type, coordinate>{ static_cast<item_presentation_model_index::row_type>(std::distance(iPositions.begin(), i)), static_cast<coordinate>(**i - aPosition) };
-            return result;
+            auto const [row, position] = positions(aUnitsContext).find(aPosition);
+            return std::pair<item_presentation_model_index::row_type, coordinate>{ static_cast<item_presentation_model_index::row_type>(row), static_cast<coordinate>(position - aPosition) };
         }
     public:
         item_cell_flags cell_flags(item_presentation_model_index const& aIndex) const override
@@ -765,7 +815,6 @@ namespace neogfx
         }
         size cell_extents(item_presentation_model_index const& aIndex, i_graphics_context const& aGc) const override
         {
-            auto oldItemHeight = item_height(aIndex, aGc);
             auto const& cellFont = (cell_font(aIndex) == std::nullopt ? default_font() : *cell_font(aIndex));
             auto& cellMeta = cell_meta(aIndex);
             if (cellMeta.extents != std::nullopt)
@@ -793,8 +842,9 @@ namespace neogfx
             }
             cellExtents.cy = std::max(cellExtents.cy, cellFont.height());
             cellMeta.extents = cellExtents.ceil();
-            if (iTotalHeight != std::nullopt)
-                *iTotalHeight += (item_height(aIndex, aGc) - oldItemHeight);
+            column(aIndex.column()).cellWidths.insert(cellMeta.extents->cx);
+            if (!iUniformRowHeights && aIndex.row() < iRowHeights.size())
+                iRowHeights.invalidate(aIndex.row());
             return units_converter(aGc).from_device_units(*cell_meta(aIndex).extents);
         }
         dimension indent(item_presentation_model_index const& aIndex, i_graphics_context const& aGc) const override
@@ -853,25 +903,25 @@ namespace neogfx
             if (sortable())
                 execute_sort();
         }
+        bool parallel_evaluation() const override
+        {
+            return iParallelEvaluation;
+        }
+        void set_parallel_evaluation(bool aParallelEvaluation) override
+        {
+            iParallelEvaluation = aParallelEvaluation;
+        }
     public:
         optional_item_presentation_model_index find_item(filter_search_key const& aFilterSearchKey, item_presentation_model_index::column_type aColumnIndex = 0, filter_search_type aFilterSearchType = filter_search_type::Prefix, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) const override
         {
+            compiled_filter_list filters;
+            compile_filter(filter{ aColumnIndex, aFilterSearchKey, aFilterSearchType, aCaseSensitivity }, filters);
+            if (filters.empty())
+                return optional_item_presentation_model_index{};
+            std::string value;
             for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
-            {
-                auto modelIndex = to_item_model_index(item_presentation_model_index{ row, aColumnIndex });
-                auto const& origValue = item_model().cell_data(modelIndex).to_string();
-                auto const& value = aCaseSensitivity == case_sensitivity::CaseSensitive ? origValue : boost::to_upper_copy<std::string>(origValue);
-                auto const& origKey = aFilterSearchKey;
-                auto const& key = aCaseSensitivity == case_sensitivity::CaseSensitive ? origKey : boost::to_upper_copy<std::string>(origKey);
-                if (key.empty())
-                    continue;
-                switch (aFilterSearchType)
-                {
-                case filter_search_type::Prefix:
-                    if (value.size() >= key.size() && value.substr(0, key.size()) == key)
-                        return from_item_model_index(modelIndex);
-                }
-            }
+                if (filter_matches(filters, self_type::row(row).value, value))
+                    return item_presentation_model_index{ row, aColumnIndex };
             return optional_item_presentation_model_index{};
         }
     public:
@@ -886,7 +936,7 @@ namespace neogfx
             else
                 return optional_filter{};
         }
-        void filter_by(item_presentation_model_index::column_type aColumnIndex, filter_search_key const& aFilterSearchKey, filter_search_type aFilterSearchType = filter_search_type::Value, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) override
+        void filter_by(item_presentation_model_index::column_type aColumnIndex, filter_search_key const& aFilterSearchKey, filter_search_type aFilterSearchType = filter_search_type::Prefix, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) override
         {
             iFilters.push_back(filter{ aColumnIndex, aFilterSearchKey, aFilterSearchType, aCaseSensitivity });
             for (auto i = iFilters.begin(); i != std::prev(iFilters.end()); ++i)
@@ -934,76 +984,340 @@ namespace neogfx
                 return;
             }
             ItemsSorting.trigger();
-            auto sortPredicate = [&](const typename container_type::value_type& aLhs, const typename container_type::value_type& aRhs) -> bool
+            std::vector<std::optional<i_scrollbar::value_type>> modelRowHeights;
+            if (iRowHeights.size() == rows())
+            {
+                modelRowHeights.resize(item_model().rows());
+                item_presentation_model_index::row_type index = 0;
+                for (auto r = begin(); r != end(); ++r, ++index)
+                    if (!iRowHeights.stale(index))
+                        modelRowHeights[r->value] = iRowHeights.value(index);
+            }
+            sort_key_list keys;
+            build_sort_keys(keys);
+            auto const keyColumns = iSortOrder.size();
+            if constexpr (container_traits::is_flat)
             {
-                for (std::size_t i = 0; i < iSortOrder.size(); ++i)
+                // sort (position, model row) pairs rather than the rows themselves then permute the rows once
+                std::vector<sort_entry> order;
+                order.reserve(rows());
+                for (item_presentation_model_index::row_type position = 0; position < rows(); ++position)
+                    order.push_back(sort_entry{ position, iRows[position].value });
+                parallel_sort(order.begin(), order.end(), [&](sort_entry const& aLhs, sort_entry const& aRhs)
                 {
-                    auto col = iSortOrder[i].first;
-                    auto const& v1 = item_model().cell_data(item_model_index{ aLhs.value, model_column(col) });
-                    auto const& v2 = item_model().cell_data(item_model_index{ aRhs.value, model_column(col) });
-                    if (std::holds_alternative<string>(v1) && std::holds_alternative<string>(v2))
+                    return sort_key_less(&keys[aLhs.modelRow * keyColumns], &keys[aRhs.modelRow * keyColumns]);
+                }, SortGrainSize);
+                container_type sortedRows;
+                sortedRows.reserve(iRows.size());
+                for (auto const& entry : order)
+                    sortedRows.push_back(std::move(iRows[entry.position]));
+                iRows.swap(sortedRows);
+            }
+            else
+                iRows.sort([&](const typename container_type::value_type& aLhs, const typename container_type::value_type& aRhs) -> bool
+                {
+                    return sort_key_less(&keys[aLhs.value * keyColumns], &keys[aRhs.value * keyColumns]);
+                });
+            reset_maps();
+            reset_position_meta();
+            iWidthMeasureCursor = 0u;
+            if (!modelRowHeights.empty())
+            {
+                // rows have only moved so permute their heights rather than measuring every row again
+                std::vector<i_scrollbar::value_type> heights;
+                heights.reserve(rows());
+                for (auto r = begin(); r != end(); ++r)
+                    heights.push_back(modelRowHeights[r->value].value_or(0.0));
+                iRowHeights.assign(heights.begin(), heights.end());
+                item_presentation_model_index::row_type index = 0;
+                for (auto r = begin(); r != end(); ++r, ++index)
+                    if (modelRowHeights[r->value] == std::nullopt)
+                        iRowHeights.invalidate(index);
+            }
+            ItemsSorted.trigger();
+        }
+        // Extracts each row's sort columns once (indexed by model row) with string values case folded so that
+        // comparisons made while sorting neither query the item model nor allocate.
+        void build_sort_keys(sort_key_list& aKeys) const
+        {
+            auto const keyColumns = iSortOrder.size();
+            std::vector<item_model_index::column_type> modelColumns;
+            for (auto const& sortColumn : iSortOrder)
+                modelColumns.push_back(model_column(sortColumn.first));
+            aKeys.clear();
+            aKeys.resize(item_model().rows() * keyColumns);
+            auto extract = [&](item_model_index::row_type aModelRow)
+            {
+                for (std::size_t i = 0; i < keyColumns; ++i)
+                {
+                    auto& key = aKeys[aModelRow * keyColumns + i];
+                    key.value = &item_model().cell_data(item_model_index{ aModelRow, modelColumns[i] });
+                    key.isString = std::holds_alternative<string>(*key.value);
+                    if (key.isString)
                     {
-                        std::string s1 = boost::to_upper_copy<std::string>(std::get<string>(v1));
-                        std::string s2 = boost::to_upper_copy<std::string>(std::get<string>(v2));
-                        if (s1 < s2)
-                            return iSortOrder[i].second == sort_direction::Ascending;
-                        else if (s2 < s1)
-                            return iSortOrder[i].second == sort_direction::Descending;
+                        key.folded = boost::to_upper_copy<std::string>(std::get<string>(*key.value));
+                        key.prefix = 0u;
+                        for (std::size_t j = 0; j < sizeof(key.prefix); ++j)
+                            key.prefix = (key.prefix << 8u) | (j < key.folded.size() ? static_cast<uint8_t>(key.folded[j]) : 0u);
                     }
-                    if (v1 < v2)
-                        return iSortOrder[i].second == sort_direction::Ascending;
-                    else if (v2 < v1)
-                        return iSortOrder[i].second == sort_direction::Descending;
                 }
-                return false;
             };
             if constexpr (container_traits::is_flat)
-                std::sort(iRows.begin(), iRows.end(), sortPredicate);
+            {
+                if (parallel_evaluation())
+                    parallel_for(rows(), SortGrainSize, [&](std::size_t aBegin, std::size_t aEnd, std::size_t)
+                    {
+                        for (auto position = aBegin; position != aEnd; ++position)
+                            extract(iRows[position].value);
+                    });
+                else
+                    for (auto const& row : iRows)
+                        extract(row.value);
+            }
             else
-                iRows.sort(sortPredicate);
-            reset_maps();
-            reset_position_meta(0);
-            ItemsSorted.trigger();
+                for (item_model_index::row_type modelRow = 0; modelRow < item_model().rows(); ++modelRow)
+                    extract(modelRow);
+        }
+        bool sort_key_less(sort_key const* aLhs, sort_key const* aRhs) const
+        {
+            for (std::size_t i = 0; i < iSortOrder.size(); ++i)
+            {
+                auto const& k1 = aLhs[i];
+                auto const& k2 = aRhs[i];
+                bool const ascending = (iSortOrder[i].second == sort_direction::Ascending);
+                if (k1.isString && k2.isString)
+                {
+                    if (k1.prefix != k2.prefix)
+                        return (k1.prefix < k2.prefix) == ascending;
+                    if (k1.folded < k2.folded)
+                        return ascending;
+                    else if (k2.folded < k1.folded)
+                        return !ascending;
+                }
+                if (*k1.value < *k2.value)
+                    return ascending;
+                else if (*k2.value < *k1.value)
+                    return !ascending;
+            }
+            return false;
+        }
+        bool sort_less(row_type const& aLhs, row_type const& aRhs) const
+        {
+            for (std::size_t i = 0; i < iSortOrder.size(); ++i)
+            {
+                auto col = iSortOrder[i].first;
+                auto const& v1 = item_model().cell_data(item_model_index{ aLhs.value, model_column(col) });
+                auto const& v2 = item_model().cell_data(item_model_index{ aRhs.value, model_column(col) });
+                if (std::holds_alternative<string>(v1) && std::holds_alternative<string>(v2))
+                {
+                    std::string s1 = boost::to_upper_copy<std::string>(std::get<string>(v1));
+                    std::string s2 = boost::to_upper_copy<std::string>(std::get<string>(v2));
+                    if (s1 < s2)
+                        return iSortOrder[i].second == sort_direction::Ascending;
+                    else if (s2 < s1)
+                        return iSortOrder[i].second == sort_direction::Descending;
+                }
+                if (v1 < v2)
+                    return iSortOrder[i].second == sort_direction::Ascending;
+                else if (v2 < v1)
+                    return iSortOrder[i].second == sort_direction::Descending;
+            }
+            return false;
+        }
+        bool sorted() const
+        {
+            return sortable() && !iSortOrder.empty();
+        }
+        // Position at which aRow belongs amongst the other rows in the current sort order.
+        item_presentation_model_index::row_type sorted_position(row_type const& aRow) const
+        {
+            return static_cast<item_presentation_model_index::row_type>(std::distance(iRows.begin(), 
+                std::upper_bound(iRows.begin(), iRows.end(), aRow, [&](row_type const& aLhs, row_type const& aRhs) { return sort_less(aLhs, aRhs); })));
+        }
+        // Moves a flat model row whose sort key has changed to its sorted position; rows between its old and
+        // new positions shift by one so only their row map entries are updated.
+        void reposition_row(item_presentation_model_index::row_type aRow)
+        {
+            auto const current = std::next(iRows.begin(), aRow);
+            if ((aRow == 0u || !sort_less(*current, *std::prev(current))) &&
+                (aRow + 1u == rows() || !sort_less(*std::next(current), *current)))
+                return;
+            bool const mapValid = row_map_valid();
+            row_type moving = std::move(*current);
+            iRows.erase(current);
+            auto const newRow = sorted_position(moving);
+            iRows.insert(std::next(iRows.begin(), newRow), std::move(moving));
+            if (iRowHeights.size() == rows())
+            {
+                iRowHeights.erase(aRow);
+                iRowHeights.insert(newRow, 0.0, true);
+            }
+            if (mapValid)
+                update_row_map(std::min(aRow, newRow), std::max(aRow, newRow) + 1u);
+            else
+                reset_maps();
+            RowMoved.trigger(aRow, newRow);
         }
         void execute_filter()
         {
             neolib::scoped_flag sf1{ iInitializing };
             neolib::scoped_flag sf2{ iFiltering };
             ItemsFiltering.trigger();
-            iRows.clear();
-            for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
+            compiled_filter_list filters;
+            for (auto const& f : iFilters)
+                compile_filter(f, filters);
+            // when every filter narrows the one last applied only the rows currently present need testing
+            // and, as a subset of a sorted sequence is still sorted, no re-sort is needed either
+            bool const refine = container_traits::is_flat && refines_applied_filters();
+            std::vector<item_model_index::row_type> candidates;
+            if (refine)
             {
-                bool matches = true;
-                for (auto const& filter : iFilters)
+                candidates.reserve(rows());
+                for (auto const& row : iRows)
+                    candidates.push_back(row.value);
+            }
+            else
+            {
+                candidates.resize(item_model().rows());
+                for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
+                    candidates[row] = row;
+            }
+            std::vector<uint8_t> matched(candidates.size(), 1u);
+            auto match = [&](std::size_t aBegin, std::size_t aEnd, std::size_t)
+            {
+                std::string value;
+                for (auto candidate = aBegin; candidate != aEnd; ++candidate)
+                    matched[candidate] = filter_matches(filters, candidates[candidate], value);
+            };
+            if (!filters.empty())
+            {
+                if (parallel_evaluation())
+                    parallel_for(candidates.size(), FilterGrainSize, match);
+                else
+                    match(0u, candidates.size(), 0u);
+            }
+            if constexpr (container_traits::is_flat)
+            {
+                container_type filteredRows;
+                std::vector<i_scrollbar::value_type> heights;
+                std::vector<item_presentation_model_index::row_type> staleHeights;
+                bool const keepHeights = refine && iRowHeights.size() == rows();
+                for (std::size_t candidate = 0; candidate < candidates.size(); ++candidate)
                 {
-                    auto const& origValue = item_model().cell_data(item_model_index{ row, model_column(std::get<0>(filter)) }).to_string();
-                    auto const& value = (std::get<3>(filter) == case_sensitivity::CaseSensitive ? origValue : boost::to_upper_copy<std::string>(origValue));
-                    auto const& origKey = std::get<1>(filter);
-                    auto const& key = (std::get<3>(filter) == case_sensitivity::CaseSensitive ? origKey : boost::to_upper_copy<std::string>(origKey));
-                    if (key.empty())
+                    if (!matched[candidate])
+                    {
+                        if (refine)
+                            forget_cell_widths(static_cast<item_presentation_model_index::row_type>(candidate));
                         continue;
-                    switch (std::get<2>(filter))
+                    }
+                    if (refine)
                     {
-                    case filter_search_type::Prefix:
-                        if (value.size() < key.size() || value.substr(0, key.size()) != key)
-                            matches = false;
-                        break;
-                    case filter_search_type::Glob:
-                        // todo
-                        break;
-                    case filter_search_type::Regex:
-                        // todo
-                        break;
+                        if (keepHeights)
+                        {
+                            if (iRowHeights.stale(candidate))
+                                staleHeights.push_back(static_cast<item_presentation_model_index::row_type>(heights.size()));
+                            heights.push_back(iRowHeights.value(candidate));
+                        }
+                        filteredRows.push_back(std::move(iRows[candidate]));
                     }
+                    else
+                        filteredRows.push_back(row_type{ candidates[candidate] });
+                }
+                iRows.swap(filteredRows);
+                reset_maps();
+                reset_position_meta();
+                if (keepHeights)
+                {
+                    iRowHeights.assign(heights.begin(), heights.end());
+                    for (auto row : staleHeights)
+                        iRowHeights.invalidate(row);
                 }
-                if (matches)
-                    item_added(item_model_index{ row });
             }
-            reset_maps();
-            reset_cell_meta();
-            reset_position_meta(0);
+            else
+            {
+                iRows.clear();
+                for (std::size_t candidate = 0; candidate < candidates.size(); ++candidate)
+                    if (matched[candidate])
+                        item_added(item_model_index{ candidates[candidate] });
+                reset_maps();
+                reset_position_meta();
+            }
+            if (!refine)
+                reset_cell_meta();
+            iAppliedFilters = iFilters;
+            iFilterRefinable = true;
+            iWidthMeasureCursor = 0u;
             ItemsFiltered.trigger();
-            execute_sort();
+            if (!refine)
+                execute_sort();
+        }
+        void compile_filter(filter const& aFilter, compiled_filter_list& aFilters) const
+        {
+            auto const& [column, key, type, caseSensitivity] = aFilter;
+            if (key.empty())
+                return;
+            compiled_filter result{ model_column(column), type, caseSensitivity == case_sensitivity::CaseInsensitive };
+            if (type == filter_search_type::Regex)
+            {
+                try
+                {
+                    result.pattern.emplace(key, std::regex::ECMAScript | std::regex::optimize | (result.caseInsensitive ? std::regex::icase : std::regex::ECMAScript));
+                }
+                catch (std::regex_error const&)
+                {
+                    // an incomplete pattern (e.g. whilst it is being typed) filters nothing
+                    return;
+                }
+            }
+            else
+                result.key = result.caseInsensitive ? boost::to_upper_copy<std::string>(key) : key;
+            aFilters.push_back(std::move(result));
+        }
+        // Thread safe (given a thread safe item model); aValue is scratch space.
+        bool filter_matches(compiled_filter_list const& aFilters, item_model_index::row_type aModelRow, std::string& aValue) const
+        {
+            for (auto const& f : aFilters)
+            {
+                aValue = item_model().cell_data(item_model_index{ aModelRow, f.modelColumn }).to_string();
+                if (f.caseInsensitive && f.type != filter_search_type::Regex)
+                    boost::to_upper(aValue);
+                switch (f.type)
+                {
+                case filter_search_type::Prefix:
+                    if (aValue.compare(0, f.key.size(), f.key) != 0)
+                        return false;
+                    break;
+                case filter_search_type::Glob:
+                    if (!glob_match(f.key, aValue))
+                        return false;
+                    break;
+                case filter_search_type::Regex:
+                    if (!std::regex_search(aValue, *f.pattern))
+                        return false;
+                    break;
+                }
+            }
+            return true;
+        }
+        bool refines_applied_filters() const
+        {
+            if (!iFilterRefinable)
+                return false;
+            for (auto const& [column, appliedKey, type, caseSensitivity] : iAppliedFilters)
+            {
+                if (appliedKey.empty())
+                    continue;
+                auto const existing = std::find_if(iFilters.begin(), iFilters.end(), [&](filter const& f) { return std::get<0>(f) == column; });
+                if (existing == iFilters.end() || std::get<2>(*existing) != type || std::get<3>(*existing) != caseSensitivity)
+                    return false;
+                auto const& key = std::get<1>(*existing);
+                if (key == appliedKey)
+                    continue;
+                if (type == filter_search_type::Prefix && key.size() > appliedKey.size() && key.compare(0, appliedKey.size(), appliedKey) == 0)
+                    continue;
+                return false;
+            }
+            return true;
         }
     private:
         void item_model_column_info_changed(item_model_index::column_type aColumnIndex)
@@ -1021,11 +1335,34 @@ namespace neogfx
             if constexpr (container_traits::is_tree)
                 if (item_model().has_parent(aItemIndex) && !has_item_model_index(item_model().parent(aItemIndex)))
                     return;
-            for (auto& row : iRows)
-                if (row.value >= aItemIndex.row())
-                    ++row.value;
+            // appending (the usual case when streaming rows in) doesn't renumber existing model rows
+            if (aItemIndex.row() + 1u != item_model().rows())
+            {
+                for (auto& row : iRows)
+                    if (row.value >= aItemIndex.row())
+                        ++row.value;
+                for (auto& row : iUnmeasuredRows)
+                    if (row >= aItemIndex.row())
+                        ++row;
+            }
             if constexpr (container_traits::is_flat)
-                iRows.push_back(row_type{ aItemIndex.row() });
+            {
+                bool const mapValid = !iInitializing && iRowMapDirtyFrom == std::nullopt && iRowMap.size() + 1u == item_model().rows();
+                bool const sortNow = !iInitializing && sorted();
+                auto const newRow = sortNow ? sorted_position(row_type{ aItemIndex.row() }) : rows();
+                iRows.insert(std::next(iRows.begin(), newRow), row_type{ aItemIndex.row() });
+                if (iRowHeights.size() + 1 == rows())
+                    iRowHeights.insert(newRow, 0.0, true);
+                if (mapValid)
+                {
+                    iRowMap.insert(std::next(iRowMap.begin(), aItemIndex.row()), item_presentation_model_index::optional_row_type{});
+                    update_row_map(newRow, rows());
+                }
+                else if (!iInitializing)
+                    reset_maps(aItemIndex);
+                if (!iInitializing)
+                    RowsInserted.trigger(newRow, 1u);
+            }
             else
             {
                 if (!item_model().has_parent(aItemIndex))
@@ -1039,31 +1376,66 @@ namespace neogfx
                     auto const pos = const_sibling_iterator{ std::next(iRows.cbegin(), parentIndex.row()) };
                     iRows.insert(pos.end(), row_type{ aItemIndex.row() });
                 }
-            }
-
-            if (!iInitializing || container_traits::is_tree)
+                reset_position_meta();
                 reset_maps(aItemIndex);
+                if (!iInitializing)
+                    RowsInserted.trigger(from_item_model_index(aItemIndex, true).row(), 1u);
+            }
 
             if (!iInitializing)
             {
-                reset_meta();
-                execute_sort();
+                auto const newRow = from_item_model_index(aItemIndex, true).row();
+                if (newRow < iWidthMeasureCursor)
+                    iWidthMeasureCursor = newRow;
+                // only exact column widths have to account for every new row
+                if (iWidthStrategy == column_width_strategy::Exact)
+                    iUnmeasuredRows.push_back(aItemIndex.row());
+                if constexpr (container_traits::is_flat)
+                {
+                    if (sortable() && iSortOrder.empty())
+                        execute_sort();
+                }
+                else
+                {
+                    reset_meta();
+                    execute_sort();
+                }
                 ItemAdded.trigger(from_item_model_index(aItemIndex, true));
             }
         }
         void item_changed(const item_model_index& aItemIndex)
         {
+            // a row the current filter excluded might now match it
+            iFilterRefinable = false;
             if (!has_item_model_index(aItemIndex))
                 return;
             if (!iInitializing)
             {
-                reset_maps();
-                reset_meta();
-                execute_sort();
-                auto& cellMeta = cell_meta(from_item_model_index(aItemIndex));
+                if constexpr (container_traits::is_flat)
+                {
+                    auto const index = from_item_model_index(aItemIndex);
+                    if (!iUniformRowHeights && index.row() < iRowHeights.size())
+                        iRowHeights.invalidate(index.row());
+                    if (sortable() && iSortOrder.empty())
+                        execute_sort();
+                    else if (sorted())
+                        reposition_row(index.row());
+                }
+                else
+                {
+                    reset_maps();
+                    reset_meta();
+                    execute_sort();
+                }
+                auto const index = from_item_model_index(aItemIndex);
+                auto& cellMeta = cell_meta(index);
                 cellMeta.text = std::nullopt;
-                cellMeta.extents = std::nullopt;
-                column(mapped_column(aItemIndex.column())).width = std::nullopt;
+                if (cellMeta.extents != std::nullopt)
+                {
+                    forget_cell_width(index.column(), cellMeta.extents->cx);
+                    cellMeta.extents = std::nullopt;
+                }
+                iUnmeasuredRows.push_back(aItemIndex.row());
                 ItemChanged.trigger(from_item_model_index(aItemIndex));
             }
         }
@@ -1073,12 +1445,34 @@ namespace neogfx
                 return;
             if (!iInitializing)
                 ItemRemoved.trigger(from_item_model_index(aItemIndex));
-            iRows.erase(std::next(begin(), from_item_model_index(aItemIndex).row()));
-            for (auto& row : iRows)
-                if (row.value >= aItemIndex.row())
-                    --row.value;
-            reset_maps(aItemIndex);
-            reset_position_meta(0);
+            auto const removedRow = from_item_model_index(aItemIndex).row();
+            bool const mapValid = container_traits::is_flat && row_map_valid();
+            if constexpr (container_traits::is_flat)
+                forget_cell_widths(removedRow);
+            iRows.erase(std::next(begin(), removedRow));
+            if constexpr (container_traits::is_tree)
+                rebuild_cell_widths(); // descendants went too
+            if (aItemIndex.row() + 1u != item_model().rows())
+                for (auto& row : iRows)
+                    if (row.value >= aItemIndex.row())
+                        --row.value;
+            iUnmeasuredRows.erase(std::remove(iUnmeasuredRows.begin(), iUnmeasuredRows.end(), aItemIndex.row()), iUnmeasuredRows.end());
+            for (auto& row : iUnmeasuredRows)
+                if (row > aItemIndex.row())
+                    --row;
+            if (removedRow < iWidthMeasureCursor)
+                --iWidthMeasureCursor;
+            if (mapValid)
+            {
+                iRowMap.erase(std::next(iRowMap.begin(), aItemIndex.row()));
+                update_row_map(removedRow, rows());
+            }
+            else
+                reset_maps(aItemIndex);
+            if (container_traits::is_flat && iRowHeights.size() == rows() + 1)
+                iRowHeights.erase(removedRow);
+            else
+                reset_position_meta();
         }
     private:
         void reset_maps(const item_model_index& aFrom = {}) const
@@ -1087,6 +1481,16 @@ namespace neogfx
                 iRowMapDirtyFrom = aFrom.row();
             iColumnMap.clear();
         }
+        bool row_map_valid() const
+        {
+            return iRowMapDirtyFrom == std::nullopt && iRowMap.size() == item_model().rows();
+        }
+        void update_row_map(item_presentation_model_index::row_type aFirstRow, item_presentation_model_index::row_type aLastRow) const
+        {
+            auto r = std::next(begin(), aFirstRow);
+            for (auto row = aFirstRow; row < aLastRow; ++row, ++r)
+                iRowMap[r->value] = row;
+        }
         item_presentation_model_index::row_type mapped_row(item_model_index::row_type aRowIndex) const
         {
             if (aRowIndex < row_map().size() && row_map()[aRowIndex])
@@ -1148,7 +1552,7 @@ namespace neogfx
         {
             reset_cell_meta();
             reset_column_meta();
-            reset_position_meta(0);
+            reset_position_meta();
         }
         void reset_cell_meta(const std::optional<item_presentation_model_index::column_type>& aColumn = {}) const
         {
@@ -1162,6 +1566,16 @@ namespace neogfx
                     cell_meta(item_presentation_model_index(row, col)).extents = std::nullopt;
                 }
             }
+            for (item_presentation_model_index::column_type col = 0; col < iColumns.size(); ++col)
+            {
+                if (aColumn != std::nullopt && col != *aColumn)
+                    continue;
+                column(col).cellWidths.clear();
+                column(col).widthsMeasured = false;
+            }
+            if (aColumn == std::nullopt)
+                iUnmeasuredRows.clear();
+            iWidthMeasureCursor = 0u;
         }
         void reset_column_meta(const std::optional<item_presentation_model_index::column_type>& aColumn = {}) const
         {
@@ -1169,16 +1583,100 @@ namespace neogfx
             {
                 if (aColumn != std::nullopt && col != *aColumn)
                     continue;
-                column(col).width = std::nullopt;
+                column(col).widthsMeasured = false;
                 column(col).headingExtents = std::nullopt;
             }
+            iWidthMeasureCursor = 0u;
+        }
+        dimension widest_cell(item_presentation_model_index::column_type aColumnIndex, i_units_context const& aUnitsContext) const
+        {
+            auto const& cellWidths = column(aColumnIndex).cellWidths;
+            if (cellWidths.empty())
+                return 0.0;
+            return units_converter(aUnitsContext).from_device_units(size{ *cellWidths.begin(), 0.0 }).cx;
+        }
+        void forget_cell_width(item_presentation_model_index::column_type aColumnIndex, dimension aWidth) const
+        {
+            auto& cellWidths = column(aColumnIndex).cellWidths;
+            auto const existing = cellWidths.find(aWidth);
+            if (existing != cellWidths.end())
+                cellWidths.erase(existing);
+        }
+        void forget_cell_widths(item_presentation_model_index::row_type aRow) const
+        {
+            for (item_presentation_model_index::column_type col = 0; col < iColumns.size(); ++col)
+            {
+                auto const& extents = cell_meta(item_presentation_model_index{ aRow, col }).extents;
+                if (extents != std::nullopt)
+                    forget_cell_width(col, extents->cx);
+            }
+        }
+        void rebuild_cell_widths() const
+        {
+            for (item_presentation_model_index::column_type col = 0; col < iColumns.size(); ++col)
+                column(col).cellWidths.clear();
+            for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
+                for (item_presentation_model_index::column_type col = 0; col < iColumns.size(); ++col)
+                {
+                    auto const& extents = cell_meta(item_presentation_model_index{ row, col }).extents;
+                    if (extents != std::nullopt)
+                        column(col).cellWidths.insert(extents->cx);
+                }
+        }
+        // (re)measures the rows added (Exact) or changed since column widths were last requested
+        void measure_unmeasured_rows(i_graphics_context const& aGc) const
+        {
+            for (auto const& modelRow : iUnmeasuredRows)
+                if (has_item_model_index(item_model_index{ modelRow }))
+                {
+                    auto const row = from_item_model_index(item_model_index{ modelRow }, true).row();
+                    for (item_presentation_model_index::column_type col = 0; col < iColumns.size(); ++col)
+                        cell_extents(item_presentation_model_index{ row, col }, aGc);
+                }
+            iUnmeasuredRows.clear();
+        }
+        void reset_position_meta() const
+        {
+            iRowHeights.clear();
+            iUniformRowHeight = std::nullopt;
+        }
+        dimension uniform_row_height(i_units_context const& aUnitsContext) const
+        {
+            if (iUniformRowHeight != std::nullopt)
+                return *iUniformRowHeight;
+            dimension height = 0.0;
+            for (item_presentation_model_index::column_type col = 0; col < columns(); ++col)
+            {
+                auto const index = item_presentation_model_index{ 0, col };
+                auto const& cellFont = (rows() > 0 ? cell_font(index) : optional_font{});
+                auto const& effectiveFont = (cellFont == std::nullopt ? default_font() : *cellFont);
+                height = std::max(height, units_converter(aUnitsContext).from_device_units(size{ 0.0, std::ceil(effectiveFont.height()) }).cy);
+                if (column(col).imageSize)
+                    height = std::max(height, units_converter(aUnitsContext).from_device_units(*column(col).imageSize).cy);
+                if (rows() > 0 && cell_editable(index) && item_model().cell_info(to_item_model_index(index)).dataStep != neolib::none)
+                    height = std::max<dimension>(height, dip(basic_spin_box<double>::SPIN_BUTTON_MINIMUM_SIZE.cy * 2.0));
+            }
+            if (columns() == 0)
+                height = units_converter(aUnitsContext).from_device_units(size{ 0.0, std::ceil(default_font().height()) }).cy;
+            iUniformRowHeight = height + cell_padding(aUnitsContext).size().cy + cell_spacing(aUnitsContext).cy;
+            return *iUniformRowHeight;
         }
-        void reset_position_meta(item_presentation_model_index::row_type aFromRow) const
+        const prefix_sum_tree<i_scrollbar::value_type>& positions(i_units_context const& aUnitsContext) const
         {
-            iTotalHeight = std::nullopt;
-            iPositions.resize(rows());
-            for (std::size_t i = aFromRow; i < iPositions.size(); ++i)
-                iPositions[i] = std::nullopt;
+            if (iRowHeights.size() != rows())
+            {
+                std::vector<i_scrollbar::value_type> heights;
+                heights.reserve(rows());
+                for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
+                    heights.push_back(item_height(item_presentation_model_index{ row }, aUnitsContext));
+                iRowHeights.assign(heights.begin(), heights.end());
+            }
+            while (iRowHeights.stale_count() != 0u)
+            {
+                auto const row = static_cast<item_presentation_model_index::row_type>(iRowHeights.first_stale());
+                iRowHeights.set_value(row, item_height(item_presentation_model_index{ row }, aUnitsContext));
+            }
+            return iRowHeights;
         }
     private:
         const_iterator cbegin() const
@@ -1247,6 +1745,7 @@ namespace neogfx
     private:
         i_item_model* iItemModel;
         bool iSortable;
+        bool iParallelEvaluation;
         sink iItemModelSink;
         optional_size iCellSpacing;
         optional_padding iCellPadding;
@@ -1256,11 +1755,17 @@ namespace neogfx
         mutable column_info_array iColumns;
         mutable column_map_type iColumnMap;
         mutable optional_font iDefaultFont;
-        mutable std::optional<i_scrollbar::value_type> iTotalHeight;
-        mutable neolib::segmented_array<optional_position, 256> iPositions;
+        mutable prefix_sum_tree<i_scrollbar::value_type> iRowHeights; // row heights, summed to give row positions
+        mutable std::optional<dimension> iUniformRowHeight;
         bool iAlternatingRowColor;
+        bool iUniformRowHeights;
+        column_width_strategy iWidthStrategy;
+        mutable item_presentation_model_index::row_type iWidthMeasureCursor; // rows before it have been measured (Progressive)
+        mutable std::vector<item_model_index::row_type> iUnmeasuredRows;
         std::deque<sort> iSortOrder;
         std::vector<filter> iFilters;
+        std::vector<filter> iAppliedFilters;
+        bool iFilterRefinable;
         sink iSink;
         bool iInitializing;
         bool iFiltering;
@@ -20,9 +20,12 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <vector>
+#include <algorithm>
 #include <neolib/core/scoped.hpp>
 #include <neolib/core/map.hpp>
 #include <neogfx/core/object.hpp>
+#include <neogfx/core/interval_set.hpp>
 #include <neogfx/gui/widget/i_item_presentation_model.hpp>
 #include <neogfx/gui/widget/i_item_selection_model.hpp>
 
@@ -41,8 +44,19 @@ namespace neogfx
     public:
         typedef Alloc allocator_type;
     private:
+        typedef item_presentation_model_index::row_type row_index;
         using concrete_item_selection = neolib::map<item_presentation_model_index, selection_area, std::less<item_presentation_model_index>, allocator_type>;
-        typedef std::deque<std::pair<item_presentation_model_index, item_selection_operation>> operation_queue_t;
+        typedef std::deque<std::tuple<item_presentation_model_index, item_presentation_model_index, item_selection_operation>> operation_queue_t;
+        // The selection is held as disjoint, non-adjacent row intervals (with the last selected column of each)
+        // stored as gaps and lengths, so inserting, removing or moving a row only touches the intervals around
+        // it. The map of areas exposed through selection() is kept in step by selections but is rebuilt, when
+        // next needed, after rows have been inserted, removed or moved.
+        struct selection_state
+        {
+            interval_set<row_index, item_presentation_model_index::column_type> rows;
+            mutable concrete_item_selection areas;
+            mutable bool areasStale = false;
+        };
     public:
         basic_item_selection_model(item_selection_mode aMode = item_selection_mode::SingleSelection) :
             iModel{ nullptr },
@@ -96,9 +110,11 @@ namespace neogfx
             iSink += presentation_model().item_model_changed([this](const i_item_model&)
             {
                 iCurrentIndex = std::nullopt;
-                reindex();
+                clear_selection(iSelection);
+                clear_selection(iPreviousSelection);
             });
-            iSink += presentation_model().item_removed([this](item_presentation_model_index const&)
+            // triggered before the row (and, for a tree, its visible descendants) is removed
+            iSink += presentation_model().item_removed([this](item_presentation_model_index const& aIndex)
             {
                 if (has_current_index())
                 {
@@ -107,25 +123,51 @@ namespace neogfx
                     else if (iCurrentIndex->row() >= presentation_model().rows() - 1u)
                         iCurrentIndex->set_row(iCurrentIndex->row() - 1u);
                 }
-                reindex();
+                erase_rows(aIndex.row(), 1u + descendant_rows(aIndex.row()));
+            });
+            // rows inserted or moved by the presentation model (e.g. a sorted insert) only shift the intervals around them
+            iSink += presentation_model().rows_inserted([this](row_index aRow, row_index aCount)
+            {
+                if (has_current_index() && iCurrentIndex->row() >= aRow)
+                    iCurrentIndex->set_row(iCurrentIndex->row() + aCount);
+                insert_rows(aRow, aCount);
+            });
+            iSink += presentation_model().row_moved([this](row_index aFrom, row_index aTo)
+            {
+                if (has_current_index())
+                {
+                    auto const current = iCurrentIndex->row();
+                    if (current == aFrom)
+                        iCurrentIndex->set_row(aTo);
+                    else if (aFrom < aTo && current > aFrom && current <= aTo)
+                        iCurrentIndex->set_row(current - 1u);
+                    else if (aTo < aFrom && current >= aTo && current < aFrom)
+                        iCurrentIndex->set_row(current + 1u);
+                }
+                move_row(iSelection, aFrom, aTo);
+                move_row(iPreviousSelection, aFrom, aTo);
             });
             iSink += presentation_model().item_expanded([this](item_presentation_model_index const& aIndex)
             {
                 if (has_current_index() && current_index().row() > aIndex.row())
                     iCurrentIndex = std::nullopt;
-                reindex();
+                insert_rows(aIndex.row() + 1u, descendant_rows(aIndex.row()));
+            });
+            iSink += presentation_model().item_collapsing([this](item_presentation_model_index const& aIndex)
+            {
+                erase_rows(aIndex.row() + 1u, descendant_rows(aIndex.row()));
             });
             iSink += presentation_model().item_collapsed([this](item_presentation_model_index const& aIndex)
             {
                 if (has_current_index() && current_index().row() > aIndex.row())
                     iCurrentIndex = std::nullopt;
-                reindex();
             });
             iSink += presentation_model().items_sorting([this]()
             {
                 neolib::scoped_flag sf{ iSorting };
                 iSavedModelIndex = has_current_index() ? presentation_model().to_item_model_index(current_index()) : optional_item_model_index{};
                 clear_current_index();
+                save_selection();
             });
             iSink += presentation_model().items_sorted([this]()
             {
@@ -133,13 +175,14 @@ namespace neogfx
                 if (iSavedModelIndex != std::nullopt)
                     set_current_index(presentation_model().from_item_model_index(*iSavedModelIndex));
                 iSavedModelIndex = std::nullopt;
-                reindex();
+                restore_selection();
             });
             iSink += presentation_model().items_filtering([this]()
             {
                 neolib::scoped_flag sf{ iFiltering };
                 iSavedModelIndex = has_current_index() ? presentation_model().to_item_model_index(current_index()) : optional_item_model_index{};
                 clear_current_index();
+                save_selection();
             });
             iSink += presentation_model().items_filtered([this]()
             {
@@ -149,7 +192,7 @@ namespace neogfx
                 else if (presentation_model().rows() >= 1)
                     set_current_index(item_presentation_model_index{ 0u, 0u });
                 iSavedModelIndex = std::nullopt;
-                reindex();
+                restore_selection();
             });
             iSink += neolib::destroying(presentation_model(), [this]()
             {
@@ -157,7 +200,9 @@ namespace neogfx
                 iModel = nullptr;
                 iCurrentIndex = std::nullopt;
                 iSavedModelIndex = std::nullopt;
+                iSavedSelection.clear();
                 iSelection = {};
+                iPreviousSelection = {};
                 PresentationModelRemoved.trigger(*oldModel);
             });
 
@@ -322,17 +367,22 @@ namespace neogfx
     public:
         const item_selection& selection() const override
         {
-            return iSelection;
+            return areas(iSelection);
         }
         bool is_selected(item_presentation_model_index const& aIndex) const override
         {
-            return (presentation_model().cell_meta(aIndex).selection & item_cell_selection_flags::Selected) == item_cell_selection_flags::Selected;
+            auto const existing = iSelection.rows.find(aIndex.row());
+            return existing != std::nullopt && aIndex.column() <= existing->value;
         }    
         bool is_selectable(item_presentation_model_index const& aIndex) const override
         {
             return (presentation_model().cell_flags(aIndex) & item_cell_flags::Selectable) == item_cell_flags::Selectable;
         }
         void select(item_presentation_model_index const& aIndex, item_selection_operation aOperation) override
+        {
+            select(aIndex, aIndex, aOperation);
+        }
+        void select(item_presentation_model_index const& aFirst, item_presentation_model_index const& aLast, item_selection_operation aOperation) override
         {
             if (aOperation == item_selection_operation::None)
                 return;
@@ -340,132 +390,56 @@ namespace neogfx
                 aOperation |= item_selection_operation::Queued;
             if ((aOperation & item_selection_operation::Queued) == item_selection_operation::Queued)
             {
-                iOperationQueue.push_back(std::make_pair(aIndex, aOperation));
+                iOperationQueue.emplace_back(aFirst, aLast, aOperation);
                 return;
             }
             if ((aOperation & item_selection_operation::CurrentIndex) == item_selection_operation::CurrentIndex)
             {
                 if ((aOperation & item_selection_operation::Select) == item_selection_operation::Select)
-                    set_current_index(aIndex);
+                    set_current_index(aLast);
                 else
                     clear_current_index();
             }
             if (mode() == item_selection_mode::NoSelection)
                 aOperation = item_selection_operation::Clear;
             // todo: cell and column
-            static auto find = [](item_presentation_model_index const& aIndex, concrete_item_selection& aSelection)
-            {
-                if (aSelection.empty())
-                    return aSelection.end();
-                auto iterExisting = aSelection.lower_bound(aIndex.with_column(0u));
-                if (iterExisting == aSelection.end())
-                    iterExisting = std::prev(iterExisting);
-                if (iterExisting != aSelection.begin())
-                {
-                    auto previous = std::prev(iterExisting);
-                    if (previous->second().topLeft.row() <= aIndex.row() &&
-                        previous->second().bottomRight.row() >= aIndex.row())
-                        return previous;
-                }
-                if (iterExisting->second().topLeft.row() <= aIndex.row() &&
-                    iterExisting->second().bottomRight.row() >= aIndex.row())
-                    return iterExisting;
-                return aSelection.end();
-            };
-            static auto find_adjacent = [](item_presentation_model_index const& aIndex, concrete_item_selection& aSelection)
+            auto const first = std::min(aFirst.row(), aLast.row());
+            auto const last = std::max(aFirst.row(), aLast.row());
+            bool const clear = (aOperation & item_selection_operation::Clear) == item_selection_operation::Clear;
+            bool const select = (aOperation & item_selection_operation::Select) == item_selection_operation::Select;
+            bool const deselect = !select && (aOperation & item_selection_operation::Deselect) == item_selection_operation::Deselect;
+            bool const toggle = !select && !deselect && (aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle;
+            // what a toggle selects depends on the selection before any clear
+            std::vector<std::pair<row_index, row_index>> toggled;
+            if (toggle)
+                toggled = unselected_rows(first, last);
+            auto update = [&](selection_state& aSelection)
             {
-                if (aSelection.empty())
-                    return aSelection.end();
-                auto iterExisting = find(aIndex.with_row(aIndex.row() - 1u), aSelection);
-                if (iterExisting != aSelection.end())
-                    return iterExisting;
-                return find(aIndex.with_row(aIndex.row() + 1u), aSelection);
-            };
-            auto update = [&, this](concrete_item_selection& aSelection, bool aUpdateCells)
-            {
-                bool const clear = (aOperation & item_selection_operation::Clear) == item_selection_operation::Clear;
-                bool const rowCurrentlySelected = aIndex.row() < presentation_model().rows() && (presentation_model().cell_meta(aIndex.with_column(0u)).selection & item_cell_selection_flags::Selected) ==
-                    item_cell_selection_flags::Selected;
-                bool const select = (aOperation & item_selection_operation::Select) == item_selection_operation::Select ||
-                    ((aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle && !rowCurrentlySelected);
-                bool const deselect = (aOperation & item_selection_operation::Deselect) == item_selection_operation::Deselect ||
-                    ((aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle && rowCurrentlySelected);
                 if (clear)
-                {
-                    if (aUpdateCells)
-                    {
-                        struct selection_clearer : i_item_presentation_model::i_meta_visitor
-                        {
-                            void visit(i_item_presentation_model::cell_meta_type& aMeta) override
-                            {
-                                aMeta.selection &= ~item_cell_selection_flags::Selected;
-                            }
-                        } selectionClearer;
-                        presentation_model().accept(selectionClearer, true);
-                    }
-                    aSelection.clear();
-                }
+                    clear_selection(aSelection);
                 if (select)
-                {
-                    if (find(aIndex, aSelection) == aSelection.end())
-                    {
-                        auto iterAdjacent = find_adjacent(aIndex, aSelection);
-                        if (iterAdjacent == aSelection.end())
-                            aSelection.emplace(aIndex.with_column(0u), selection_area{ aIndex.with_column(0u), aIndex.with_column(presentation_model().columns() - 1u) });
-                        else
-                        {
-                            auto& adjacent = *iterAdjacent;
-                            if (adjacent.second().bottomRight.row() == aIndex.row() - 1u)
-                                adjacent.second().bottomRight = aIndex.with_column(presentation_model().columns() - 1u);
-                            else
-                            {
-                                aSelection.emplace(aIndex.with_column(0u), selection_area{ aIndex.with_column(0u), adjacent.second().bottomRight });
-                                aSelection.erase(iterAdjacent);
-                            }
-                        }
-                    }
-                    if (aUpdateCells)
-                        for (auto& cellIndex : *this)
-                            if (cellIndex.row() == aIndex.row())
-                                presentation_model().cell_meta(cellIndex).selection |= item_cell_selection_flags::Selected;
-                }
-                else if (deselect)
-                {
-                    if (aUpdateCells)
-                        for (auto& cellIndex : *this)
-                            if (cellIndex.row() == aIndex.row())
-                                presentation_model().cell_meta(cellIndex).selection &= ~item_cell_selection_flags::Selected;
-                    auto iterExisting = find(aIndex, aSelection);
-                    if (iterExisting != aSelection.end())
-                    {
-                        auto& existing = *iterExisting;
-                        if (existing.second().topLeft.row() == existing.second().bottomRight.row())
-                            aSelection.erase(iterExisting);
-                        else if (existing.second().topLeft.row() == aIndex.row())
-                        {
-                            aSelection.emplace(aIndex.with_row(aIndex.row() + 1u).with_column(0u), selection_area{ aIndex.with_row(aIndex.row() + 1u).with_column(0u), existing.second().bottomRight });
-                            aSelection.erase(iterExisting);
-                        }
-                        else if (existing.second().bottomRight.row() == aIndex.row())
-                            existing.second().bottomRight.set_row(aIndex.row() - 1u);
-                        else
-                        {
-                            aSelection.emplace(aIndex.with_row(aIndex.row() + 1u).with_column(0u), selection_area{ aIndex.with_row(aIndex.row() + 1u).with_column(0u), existing.second().bottomRight });
-                            existing.second().bottomRight.set_row(aIndex.row() - 1u);
-                        }
-                    }
-                }
+                    select_rows(aSelection, first, last, last_column());
+                else if (deselect || toggle)
+                    deselect_rows(aSelection, first, last);
+                for (auto const& rows : toggled)
+                    select_rows(aSelection, rows.first, rows.second, last_column());
             };
-            update(iSelection, true);
+            update(iSelection);
             if ((aOperation & item_selection_operation::Internal) != item_selection_operation::Internal)
             {
                 neolib::scoped_flag sf{ iNotifying };
-                SelectionChanged.trigger(iSelection, iPreviousSelection);
+                SelectionChanged.trigger(areas(iSelection), areas(iPreviousSelection));
             }
-            update(iPreviousSelection, false);
+            update(iPreviousSelection);
             if ((aOperation & item_selection_operation::Internal) != item_selection_operation::Internal)
                 process_queue();
         }
+        void select_all() override
+        {
+            if (presentation_model().rows() == 0u)
+                return;
+            select(item_presentation_model_index{ 0u, 0u }, item_presentation_model_index{ presentation_model().rows() - 1u, last_column() }, item_selection_operation::ClearAndSelect);
+        }
     public:
         bool sorting() const override
         {
@@ -498,14 +472,182 @@ namespace neogfx
                 CurrentIndexChanged.trigger(iCurrentIndex, previousIndex);
             }
         }
-        void reindex()
+        item_presentation_model_index::column_type last_column() const
+        {
+            return presentation_model().columns() != 0u ? presentation_model().columns() - 1u : 0u;
+        }
+        static concrete_item_selection const& areas(selection_state const& aSelection)
+        {
+            if (aSelection.areasStale)
+            {
+                aSelection.areas.clear();
+                aSelection.rows.visit([&](auto const& aRows)
+                {
+                    aSelection.areas.emplace(item_presentation_model_index{ aRows.first, 0u },
+                        selection_area{ item_presentation_model_index{ aRows.first, 0u }, item_presentation_model_index{ aRows.last, aRows.value } });
+                });
+                aSelection.areasStale = false;
+            }
+            return aSelection.areas;
+        }
+        static void clear_selection(selection_state& aSelection)
+        {
+            aSelection.rows.clear();
+            aSelection.areas.clear();
+            aSelection.areasStale = false;
+        }
+        static void select_rows(selection_state& aSelection, row_index aFirst, row_index aLast, item_presentation_model_index::column_type aLastColumn)
+        {
+            aSelection.rows.insert(aFirst, aLast, aLastColumn);
+            if (!aSelection.areasStale)
+                select_rows(aSelection.areas, aFirst, aLast, aLastColumn);
+        }
+        static void deselect_rows(selection_state& aSelection, row_index aFirst, row_index aLast)
+        {
+            aSelection.rows.erase(aFirst, aLast);
+            if (!aSelection.areasStale)
+                deselect_rows(aSelection.areas, aFirst, aLast);
+        }
+        // The areas map is keyed (and so ordered) by the first row of each area: membership and updates are
+        // O(log n) in the number of areas irrespective of how many rows each area spans.
+        static auto area_at_or_after(concrete_item_selection& aSelection, row_index aRow)
+        {
+            auto existing = aSelection.lower_bound(item_presentation_model_index{ aRow, 0u });
+            if (existing != aSelection.begin())
+            {
+                auto const previous = std::prev(existing);
+                if (previous->second().bottomRight.row() >= aRow)
+                    return previous;
+            }
+            return existing;
+        }
+        static void select_rows(concrete_item_selection& aSelection, row_index aFirst, row_index aLast, item_presentation_model_index::column_type aLastColumn)
+        {
+            // absorb overlapping and adjacent areas
+            auto existing = area_at_or_after(aSelection, aFirst != 0u ? aFirst - 1u : 0u);
+            while (existing != aSelection.end() && existing->second().topLeft.row() <= aLast + 1u)
+            {
+                aFirst = std::min(aFirst, existing->second().topLeft.row());
+                aLast = std::max(aLast, existing->second().bottomRight.row());
+                aLastColumn = std::max(aLastColumn, existing->second().bottomRight.column());
+                auto const next = std::next(existing);
+                aSelection.erase(existing);
+                existing = next;
+            }
+            aSelection.emplace(item_presentation_model_index{ aFirst, 0u }, selection_area{ item_presentation_model_index{ aFirst, 0u }, item_presentation_model_index{ aLast, aLastColumn } });
+        }
+        static void deselect_rows(concrete_item_selection& aSelection, row_index aFirst, row_index aLast)
+        {
+            auto existing = area_at_or_after(aSelection, aFirst);
+            while (existing != aSelection.end() && existing->second().topLeft.row() <= aLast)
+            {
+                selection_area const area = existing->second();
+                auto const next = std::next(existing);
+                aSelection.erase(existing);
+                existing = next;
+                if (area.topLeft.row() < aFirst)
+                    aSelection.emplace(area.topLeft, selection_area{ area.topLeft, area.bottomRight.with_row(aFirst - 1u) });
+                if (area.bottomRight.row() > aLast)
+                    aSelection.emplace(item_presentation_model_index{ aLast + 1u, 0u }, selection_area{ item_presentation_model_index{ aLast + 1u, 0u }, area.bottomRight });
+            }
+        }
+        std::vector<std::pair<row_index, row_index>> unselected_rows(row_index aFirst, row_index aLast) const
+        {
+            std::vector<std::pair<row_index, row_index>> result;
+            auto next = aFirst;
+            iSelection.rows.visit(aFirst, aLast, [&](auto const& aRows)
+            {
+                if (aRows.first > next)
+                    result.emplace_back(next, aRows.first - 1u);
+                next = aRows.last + 1u;
+            });
+            if (next <= aLast)
+                result.emplace_back(next, aLast);
+            return result;
+        }
+        // moves the intervals at or after aRow by aCount rows (the newly inserted rows are not selected)
+        void insert_rows(row_index aRow, row_index aCount)
+        {
+            insert_rows(iSelection, aRow, aCount);
+            insert_rows(iPreviousSelection, aRow, aCount);
+        }
+        static void insert_rows(selection_state& aSelection, row_index aRow, row_index aCount)
+        {
+            if (aCount == 0u)
+                return;
+            aSelection.rows.insert_positions(aRow, aCount);
+            aSelection.areasStale = true;
+        }
+        void erase_rows(row_index aRow, row_index aCount)
         {
-            iPreviousSelection.clear();
-            iSelection.clear();
-            for (item_presentation_model_index::row_type row = 0; row < presentation_model().rows(); ++row)
-                for (item_presentation_model_index::column_type column = 0; column < presentation_model().columns(); ++column)
-                    if ((presentation_model().cell_meta(item_presentation_model_index{ row, column }).selection & item_cell_selection_flags::Selected) == item_cell_selection_flags::Selected)
-                        select(item_presentation_model_index{ row, column }, item_selection_operation::Select | item_selection_operation::Internal);
+            erase_rows(iSelection, aRow, aCount);
+            erase_rows(iPreviousSelection, aRow, aCount);
+        }
+        static void erase_rows(selection_state& aSelection, row_index aRow, row_index aCount)
+        {
+            if (aCount == 0u)
+                return;
+            aSelection.rows.erase_positions(aRow, aCount);
+            aSelection.areasStale = true;
+        }
+        static void move_row(selection_state& aSelection, row_index aFrom, row_index aTo)
+        {
+            if (aFrom == aTo)
+                return;
+            auto const existing = aSelection.rows.find(aFrom);
+            aSelection.rows.erase_positions(aFrom, 1u);
+            aSelection.rows.insert_positions(aTo, 1u);
+            if (existing != std::nullopt)
+                aSelection.rows.insert(aTo, aTo, existing->value);
+            aSelection.areasStale = true;
+        }
+        // number of rows immediately following aRow which are (visible) descendants of it; always zero for a flat model
+        row_index descendant_rows(row_index aRow) const
+        {
+            auto const& itemModel = presentation_model().item_model();
+            if (!itemModel.is_tree())
+                return 0u;
+            auto const ancestor = presentation_model().to_item_model_index(item_presentation_model_index{ aRow });
+            row_index result = 0u;
+            for (auto row = aRow + 1u; row < presentation_model().rows(); ++row, ++result)
+            {
+                auto index = presentation_model().to_item_model_index(item_presentation_model_index{ row });
+                while (itemModel.has_parent(index) && (index = itemModel.parent(index)) != ancestor)
+                    ;
+                if (index != ancestor)
+                    break;
+            }
+            return result;
+        }
+        // a full sort or filter can move every row so the selection is carried across by item model index
+        void save_selection()
+        {
+            iSavedSelection.clear();
+            iSelection.rows.visit([&](auto const& aRows)
+            {
+                for (auto row = aRows.first; row <= aRows.last && row < presentation_model().rows(); ++row)
+                    iSavedSelection.push_back(presentation_model().to_item_model_index(item_presentation_model_index{ row }));
+            });
+        }
+        void restore_selection()
+        {
+            std::vector<row_index> rows;
+            rows.reserve(iSavedSelection.size());
+            for (auto const& index : iSavedSelection)
+                if (presentation_model().has_item_model_index(index))
+                    rows.push_back(presentation_model().from_item_model_index(index, true).row());
+            iSavedSelection.clear();
+            std::sort(rows.begin(), rows.end());
+            clear_selection(iSelection);
+            for (auto row = rows.begin(); row != rows.end();)
+            {
+                auto last = row;
+                while (std::next(last) != rows.end() && *std::next(last) == *last + 1u)
+                    ++last;
+                select_rows(iSelection, *row, *last, last_column());
+                row = std::next(last);
+            }
+            iPreviousSelection = iSelection;
         }
         void process_queue()
         {
@@ -516,7 +658,7 @@ namespace neogfx
             {
                 auto next = iOperationQueue.front();
                 iOperationQueue.pop_front();
-                select(next.first, next.second & ~item_selection_operation::Queued);
+                select(std::get<0>(next), std::get<1>(next), std::get<2>(next) & ~item_selection_operation::Queued);
             }
         }
     private:
@@ -524,8 +666,9 @@ namespace neogfx
         item_selection_mode iMode;
         optional_item_presentation_model_index iCurrentIndex;
         optional_item_model_index iSavedModelIndex;
-        concrete_item_selection iPreviousSelection;
-        concrete_item_selection iSelection;
+        std::vector<item_model_index> iSavedSelection;
+        selection_state iPreviousSelection;
+        selection_state iSelection;
         bool iSorting;
         bool iFiltering;
         bool iNotifying;
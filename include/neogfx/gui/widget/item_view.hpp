@@ -171,6 +171,7 @@ namespace neogfx
     private:
         void init();
         void invalidate_item(item_presentation_model_index const& aItemIndex);
+        void measure_column_widths();
         void update_hover(const optional_point& aPosition);
         item_selection_operation to_selection_operation(key_modifiers_e aKeyModifiers) const;
         void select(item_presentation_model_index const& aItemIndex, key_modifiers_e aKeyModifiers);
@@ -187,6 +188,7 @@ namespace neogfx
         bool iHotTracking;
         bool iIgnoreNextMouseMove;
         std::optional<neolib::callback_timer> iMouseTracker;
+        std::optional<neolib::callback_timer> iColumnWidthMeasurer;
         optional_item_presentation_model_index iEditing;
         std::shared_ptr<i_item_editor> iEditor;
         bool iBeginningEdit;
@@ -195,6 +197,7 @@ namespace neogfx
         optional_item_presentation_model_index iClickedItem;
         optional_item_presentation_model_index iClickedCheckBox;
         optional_item_model_index iSavedModelIndex;
+        optional_item_model_index iSelectionAnchor;
         basic_size<i_scrollbar::value_type> iOldPositionForScrollbarVisibility;
         optional_easing iDefaultTransition;
         double iDefaultTransitionDuration;
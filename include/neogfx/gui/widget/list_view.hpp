@@ -35,6 +35,9 @@ namespace neogfx
         ~list_view();
     public:
         bool is_managing_layout() const;
+    public:
+        bool uniform_row_heights() const;
+        void set_uniform_row_heights(bool aUniformRowHeights = true);
     protected:
         void model_changed() override;
         void presentation_model_changed() override;
@@ -48,5 +51,6 @@ namespace neogfx
     private:
         vertical_layout iLayout;
         vertical_spacer iSpacer;
+        bool iUniformRowHeights;
     };
 }
\ No newline at end of file
@@ -35,6 +35,9 @@ namespace neogfx
         ~table_view();
     public:
         bool is_managing_layout() const;
+    public:
+        bool uniform_row_heights() const;
+        void set_uniform_row_heights(bool aUniformRowHeights = true);
     public:
         const header_view& column_header() const;
         header_view& column_header();
@@ -52,5 +55,6 @@ namespace neogfx
         vertical_layout iLayout;
         header_view iColumnHeader;
         vertical_spacer iSpacer;
+        bool iUniformRowHeights;
     };
 }
\ No newline at end of file
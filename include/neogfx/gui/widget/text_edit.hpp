@@ -20,10 +20,12 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <deque>
 #include <boost/pool/pool_alloc.hpp>
 #include <neolib/core/tag_array.hpp>
 #include <neolib/core/segmented_array.hpp>
 #include <neolib/core/indexitor.hpp>
+#include <neogfx/core/prefix_sum_tree.hpp>
 #include <neogfx/app/i_clipboard.hpp>
 #include <neogfx/gfx/text/glyph.hpp>
 #include <neogfx/gui/window/context_menu.hpp>
@@ -40,6 +42,7 @@ namespace neogfx
         define_event(TextChanged, text_changed)
         define_event(DefaultStyleChanged, default_style_changed)
         define_event(ContextMenu, context_menu, i_menu&)
+        define_event(ShapingProgress, shaping_progress, double)
     private:
         typedef text_edit property_context_type;
     public:
@@ -198,6 +201,24 @@ namespace neogfx
                 if (std::holds_alternative<style_list::const_iterator>(style()))
                     static_variant_cast<style_list::const_iterator>(style())->release();
             }
+        public:
+            tag& operator=(const tag& aOther)
+            {
+                if (std::holds_alternative<style_list::const_iterator>(aOther.style()))
+                    static_variant_cast<style_list::const_iterator>(aOther.style())->add_ref();
+                if (std::holds_alternative<style_list::const_iterator>(style()))
+                    static_variant_cast<style_list::const_iterator>(style())->release();
+                iNode = aOther.iNode;
+                iContents = aOther.iContents;
+                return *this;
+            }
+            tag& operator=(tag&& aOther)
+            {
+                // the reference we held is released when aOther is destroyed
+                std::swap(iNode, aOther.iNode);
+                std::swap(iContents, aOther.iContents);
+                return *this;
+            }
         public:
             bool operator==(const tag& aOther) const
             {
@@ -291,6 +312,21 @@ namespace neogfx
         {
         public:
             typedef std::map<document_glyphs::size_type, dimension, std::less<document_glyphs::size_type>, boost::fast_pool_allocator<std::pair<const document_glyphs::size_type, dimension>>> height_list;
+            struct wrapped_line
+            {
+                document_glyphs::size_type lineStart; // relative to paragraph start
+                document_glyphs::size_type lineEnd; // relative to paragraph start
+                size extents;
+                dimension advance;
+            };
+            typedef std::vector<wrapped_line> wrapped_lines;
+            struct line_wrap
+            {
+                dimension availableWidth;
+                bool wordWrap;
+                bool estimated;
+                wrapped_lines lines;
+            };
         public:
             glyph_paragraph(text_edit& aParent) :
                 iParent{&aParent}, iSelf{}
@@ -313,6 +349,7 @@ namespace neogfx
                 iParent = aOther.iParent;
                 iSelf = aOther.iSelf;
                 iHeights = aOther.iHeights;
+                iLineWrap = aOther.iLineWrap;
                 return *this;
             }
         public:
@@ -370,47 +407,55 @@ namespace neogfx
             }
             dimension height(document_glyphs::iterator aStart, document_glyphs::iterator aEnd) const
             {
+                // keyed on glyph index relative to the paragraph so that edits elsewhere in the document
+                // leave the cache valid
+                auto const paragraphStart = start();
                 if (iHeights.empty())
                 {
                     dimension previousHeight = 0.0;
-                    auto glyphsStartIndex = start_index();
-                    auto glyphsEndIndex = end_index();
-                    auto iterGlyph = start();
-                    for (auto i = glyphsStartIndex; i != glyphsEndIndex; ++i)
+                    auto const glyphCount = end_index() - start_index();
+                    auto iterGlyph = paragraphStart;
+                    for (document_glyphs::size_type i = 0; i != glyphCount; ++i)
                     {
                         auto const& glyph = *(iterGlyph++);
                         dimension cy = parent().glyphs().extents(glyph).cy;
-                        if (i == glyphsStartIndex || cy != previousHeight)
+                        if (i == 0 || cy != previousHeight)
                         {
                             iHeights[i] = cy;
                             previousHeight = cy;
                         }
                     }
-                    iHeights[end_index()] = 0.0;
+                    iHeights[glyphCount] = 0.0;
                 }
                 dimension result = 0.0;
-                auto start = iHeights.lower_bound(aStart - parent().glyphs().begin());
-                if (start != iHeights.begin() && aStart < parent().glyphs().begin() + start->first)
+                auto start = iHeights.lower_bound(aStart - paragraphStart);
+                if (start != iHeights.begin() && aStart < paragraphStart + start->first)
                     --start;
-                auto stop = iHeights.lower_bound(aEnd - parent().glyphs().begin());
+                auto stop = iHeights.lower_bound(aEnd - paragraphStart);
                 if (start == stop && stop != iHeights.end())
                     ++stop;
                 for (auto i = start; i != stop; ++i)
                     result = std::max(result, (*i).second);
                 return result;
             }
+            // lines as last wrapped; a reshaped paragraph is a new object so starts without any
+            std::optional<line_wrap>& wrapping() const
+            {
+                return iLineWrap;
+            }
         private:
             text_edit* iParent;
             glyph_paragraphs::const_iterator iSelf;
             mutable height_list iHeights;
+            mutable std::optional<line_wrap> iLineWrap;
         };
         struct glyph_line
         {
             std::pair<glyph_paragraphs::size_type, glyph_paragraphs::const_iterator> paragraph;
             std::pair<document_glyphs::size_type, document_glyphs::const_iterator> lineStart;
             std::pair<document_glyphs::size_type, document_glyphs::const_iterator> lineEnd;
-            coordinate ypos;
             size extents;
+            bool estimated = false; // whole paragraph awaiting wrapping; extents.cy is an estimate
         };
         typedef std::vector<glyph_line> glyph_lines;
         class glyph_column : public column_info
@@ -422,11 +467,37 @@ namespace neogfx
             }
         public:
             const glyph_lines& lines() const { return iLines; }
-            glyph_lines& lines() { return iLines; }
+            void clear_lines() { iLines.clear(); iLineAdvances.clear(); }
+            void append_line(const glyph_line& aLine, dimension aAdvance)
+            {
+                iLines.push_back(aLine);
+                iLineAdvances.insert(iLineAdvances.size(), aAdvance);
+            }
+            // replaces aLine with aLines returning the line following them
+            glyph_lines::const_iterator replace_line(glyph_lines::const_iterator aLine, const glyph_lines& aLines, const std::vector<dimension>& aAdvances)
+            {
+                auto const index = static_cast<std::size_t>(aLine - iLines.begin());
+                iLineAdvances.erase(index);
+                for (std::size_t i = 0u; i < aAdvances.size(); ++i)
+                    iLineAdvances.insert(index + i, aAdvances[i]);
+                iLines.erase(iLines.begin() + index);
+                iLines.insert(iLines.begin() + index, aLines.begin(), aLines.end());
+                return iLines.begin() + index + aLines.size();
+            }
+            coordinate ypos(glyph_lines::const_iterator aLine) const { return iLineAdvances.prefix_sum(static_cast<std::size_t>(aLine - iLines.begin())); }
+            dimension height() const { return iLineAdvances.total(); }
+            // the line whose advance contains aY (the first or last line if aY lies outside them all)
+            glyph_lines::const_iterator line_at(coordinate aY) const
+            {
+                if (iLines.empty())
+                    return iLines.end();
+                return iLines.begin() + iLineAdvances.find(aY).first;
+            }
             dimension width() const { return iWidth; }
             void set_width(dimension aWidth) { iWidth = aWidth; }
         private:
             glyph_lines iLines;
+            prefix_sum_tree<dimension> iLineAdvances;
             dimension iWidth;
         };
         typedef std::vector<glyph_column> glyph_columns;
@@ -547,6 +618,9 @@ namespace neogfx
         dimension tab_stops() const;
         void set_tab_stop_hint(std::string const& aTabStopHint = "0000");
         void set_tab_stops(const optional_dimension& aTabStops);
+    public:
+        bool shaping() const;
+        void complete_shaping();
     public:
         position_type document_hit_test(const point& aPosition, bool aAdjustForScrollPosition = true) const;
         virtual bool same_word(position_type aTextPositionLeft, position_type aTextPositionRight) const;
@@ -554,10 +628,36 @@ namespace neogfx
     public:
         neogfx::cursor& cursor() const;
         void set_cursor_position(const point& aPosition, bool aMoveAnchor = true, bool aEnableDragger = false);
+    protected:
+        void scrollbar_updated(const i_scrollbar& aScrollbar, i_scrollbar::update_reason_e aReason) override;
     protected:
         std::size_t column_index(const column_info& aColumn) const;
         rect column_rect(std::size_t aColumnIndex, bool aIncludePadding = false) const;
         std::size_t column_hit_test(const point& aPosition, bool aAdjustForScrollPosition = true) const;
+    private:
+        enum class edit_type : uint32_t
+        {
+            Insert  = 0x01,
+            Delete  = 0x02
+        };
+        struct edit
+        {
+            edit_type type;
+            position_type position;
+            std::u32string text;
+            std::vector<std::pair<document_text::size_type, document_text::tag_type>> styles; // runs of (length, tag) covering text
+        };
+        struct undo_step
+        {
+            std::vector<edit> edits;
+            position_type cursorPosition; // before the step
+            position_type cursorAnchor; // before the step
+            bool typing; // single character edits; consecutive typing coalesces into one step
+        };
+        typedef std::deque<undo_step> undo_stack;
+        static constexpr std::size_t UndoMemoryLimit = 16u * 1024u * 1024u; // bytes
+        static constexpr std::size_t BackgroundShapingThreshold = 64u * 1024u; // characters
+        static constexpr std::size_t ShapingBatchSize = 16u * 1024u; // characters
     private:
         struct position_info
         {
@@ -579,6 +679,9 @@ namespace neogfx
         document_glyphs& glyphs();
         std::size_t do_insert_text(position_type aPosition, std::string const& aText, const style& aStyle, bool aMoveCursor, bool aClearFirst);
         void delete_any_selection();
+        void record_edit(edit_type aType, position_type aPosition, document_text::const_iterator aBegin, document_text::const_iterator aEnd, std::optional<document_text::tag_type> const& aStyle = {});
+        void apply_edit(edit const& aEdit, bool aRevert);
+        void clear_undo_history();
         void notify_text_changed();
         std::pair<position_type, position_type> related_glyphs(position_type aGlyphPosition) const;
         bool same_paragraph(position_type aFirstGlyphPos, position_type aSecondGlyphPos) const;
@@ -587,8 +690,15 @@ namespace neogfx
         document_glyphs::const_iterator to_glyph(document_text::const_iterator aWhere) const;
         std::pair<document_text::size_type, document_text::size_type> from_glyph(document_glyphs::const_iterator aWhere) const;
         void refresh_paragraph(document_text::const_iterator aWhere, ptrdiff_t aDelta);
+        void shape_paragraphs(i_graphics_context const& aGc, document_text::const_iterator aBegin, document_text::const_iterator aEnd, glyph_paragraphs::const_iterator aBefore, document_glyphs::size_type aGlyphPosition);
+        bool shape_next_batch(i_graphics_context const& aGc);
+        void shape_in_background();
         void refresh_columns();
         void refresh_lines();
+        glyph_paragraph::line_wrap const& wrap_paragraph(glyph_paragraph& aParagraph, dimension aAvailableWidth, bool aEstimate);
+        bool estimated_lines_in_view() const;
+        void wrap_estimated_lines_in_view();
+        glyph_line to_glyph_line(glyph_paragraphs::const_iterator aParagraph, glyph_paragraph::wrapped_line const& aLine, bool aEstimated) const;
         void animate();
         void update_cursor();
         void make_cursor_visible(bool aForcePreviewScroll = false);
@@ -607,11 +717,16 @@ namespace neogfx
         mutable neogfx::cursor iCursor;
         style_list iStyles;
         std::u32string iNormalizedTextBuffer;
-        document_text iPreviousText;
         document_text iText;
+        undo_stack iUndoStack;
+        std::size_t iUndoPosition;
+        std::size_t iUndoMemory;
+        bool iUndoing;
+        bool iUndoGroupOpen;
         mutable std::optional<std::string> iUtf8TextCache;
         mutable std::optional<document_glyphs> iGlyphs;
         glyph_paragraphs iGlyphParagraphs;
+        document_text::size_type iShapingEnd;
         glyph_columns iGlyphColumns;
         size iTextExtents;
         uint64_t iCursorAnimationStartTime;
@@ -632,11 +747,13 @@ namespace neogfx
         basic_point<std::optional<dimension>> iCursorHint;
         mutable std::optional<std::pair<neogfx::font, dimension>> iCalculatedTabStops;
         neolib::callback_timer iAnimator;
+        std::optional<neolib::callback_timer> iShaper;
         std::optional<neolib::callback_timer> iDragger;
         std::unique_ptr<neogfx::context_menu> iMenu;
         uint32_t iSuppressTextChangedNotification;
         uint32_t iWantedToNotfiyTextChanged;
         bool iOutOfMemory;
+        bool iLazyWrapping;
     public:
         define_property(property_category::other, bool, ReadOnly, read_only, false)
         define_property(property_category::other, bool, WordWrap, word_wrap, iType == MultiLine)
@@ -27,6 +27,7 @@
 #include "../../hid/native/windows_mouse.hpp"
 #include "../../hid/native/windows_window_manager.hpp"
 #include "../../gfx/native/windows_renderer.hpp"
+#include "../../gfx/native/software_renderer.hpp"
 #include "windows_drag_drop.hpp"
 //#include "../../audio/native/windows_audio.hpp"
 
@@ -63,12 +64,23 @@ template<> neogfx::i_mouse& services::start_service<neogfx::i_mouse>()
 template<> neogfx::i_rendering_engine& services::start_service<neogfx::i_rendering_engine>()
 { 
     auto const& programOptions = service<neogfx::i_app>().program_options();
+    if (programOptions.renderer() == neogfx::renderer::Software)
+    {
+        static neogfx::software_renderer sSoftwareRenderer;
+        return sSoftwareRenderer;
+    }
     static neogfx::native::windows::renderer sWindowsRenderer{ programOptions.renderer(), programOptions.double_buffering() };
     return sWindowsRenderer; 
 }
 
 template<> void services::teardown_service<neogfx::i_rendering_engine>()
 {
+    if (service<neogfx::i_rendering_engine>().renderer() == neogfx::renderer::Software)
+    {
+        static_cast<neogfx::software_renderer&>(service<neogfx::i_rendering_engine>()).~software_renderer();
+        new(&service<neogfx::i_rendering_engine>()) neogfx::software_renderer{};
+        return;
+    }
     static_cast<neogfx::native::windows::renderer&>(service<neogfx::i_rendering_engine>()).~renderer();
     new(&service<neogfx::i_rendering_engine>()) neogfx::native::windows::renderer{ neogfx::renderer::None, false };
 }
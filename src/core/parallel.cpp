@@ -0,0 +1,99 @@
+// parallel.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <neolib/task/thread_pool.hpp>
+#include <neogfx/core/parallel.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        struct parallel_for_state
+        {
+            std::size_t count;
+            std::size_t grainSize;
+            std::atomic<std::size_t> next = 0u;
+            std::atomic<std::size_t> nextSlot = 1u;
+            std::atomic<std::size_t> active = 0u;
+            std::mutex mutex;
+            std::condition_variable idle;
+            std::exception_ptr exception;
+        };
+
+        void drain(parallel_for_state& aState, parallel_range_job const& aJob, std::size_t aSlot)
+        {
+            try
+            {
+                for (auto begin = aState.next.fetch_add(aState.grainSize); begin < aState.count; begin = aState.next.fetch_add(aState.grainSize))
+                    aJob(begin, std::min(begin + aState.grainSize, aState.count), aSlot);
+            }
+            catch (...)
+            {
+                std::unique_lock<std::mutex> lock{ aState.mutex };
+                if (!aState.exception)
+                    aState.exception = std::current_exception();
+                aState.next = aState.count;
+            }
+        }
+    }
+
+    std::size_t parallel_concurrency()
+    {
+        return std::max<std::size_t>(std::thread::hardware_concurrency(), 1u);
+    }
+
+    void parallel_for(std::size_t aCount, std::size_t aGrainSize, parallel_range_job const& aJob, std::size_t aMaxConcurrency)
+    {
+        if (aCount == 0u)
+            return;
+        aGrainSize = std::max<std::size_t>(aGrainSize, 1u);
+        auto const chunks = (aCount + aGrainSize - 1u) / aGrainSize;
+        auto const slots = std::min(chunks, aMaxConcurrency == 0u ? parallel_concurrency() : std::min(aMaxConcurrency, parallel_concurrency()));
+        if (slots <= 1u)
+        {
+            aJob(0u, aCount, 0u);
+            return;
+        }
+        auto state = std::make_shared<parallel_for_state>();
+        state->count = aCount;
+        state->grainSize = aGrainSize;
+        // A pool task that only starts once every sub-range has been claimed returns without touching
+        // aJob; a task that does claim work is counted as active first so we wait for it below.
+        for (std::size_t helper = 1u; helper < slots; ++helper)
+            neolib::thread_pool::default_thread_pool().run([state, &aJob]()
+            {
+                ++state->active;
+                if (state->next < state->count)
+                    drain(*state, aJob, state->nextSlot++);
+                std::unique_lock<std::mutex> lock{ state->mutex };
+                if (--state->active == 0u)
+                    state->idle.notify_all();
+            });
+        drain(*state, aJob, 0u);
+        std::unique_lock<std::mutex> lock{ state->mutex };
+        state->idle.wait(lock, [&]() { return state->active == 0u; });
+        if (state->exception)
+            std::rethrow_exception(state->exception);
+    }
+}
\ No newline at end of file
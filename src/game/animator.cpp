@@ -79,14 +79,11 @@ namespace neogfx::game
         auto& cache = ecs().component<mesh_render_cache>();
         auto const& worldClock = ecs().shared_component<game::clock>()[0];
 
-        for (auto entity : filters.entities())
+        for_each_live_entity(ecs(), filters, [&](entity_id entity)
         {
-            auto const& info = infos.entity_record(entity);
-            if (info.destroyed)
-                continue;
             auto& filter = filters.entity_record(entity);
             if (!filter.currentFrameStartTime)
-                filter.currentFrameStartTime = info.creationTime;
+                filter.currentFrameStartTime = infos.entity_record(entity).creationTime;
             auto const& frames = (filter.animation ? filter.animation->frames : filter.sharedAnimation.ptr->frames);
             while (*filter.currentFrameStartTime + to_step_time(frames[filter.currentFrame].duration, worldClock.timestep) < now)
             {
@@ -99,6 +96,6 @@ namespace neogfx::game
                 }
                 set_render_cache_dirty(cache, entity);
             }
-        }
+        });
     }
 }
\ No newline at end of file
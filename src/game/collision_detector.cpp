@@ -19,6 +19,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <neogfx/core/async_thread.hpp>
+#include <neogfx/core/parallel.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/ecs_helpers.hpp>
 #include <neogfx/game/entity_info.hpp>
@@ -31,9 +32,21 @@ namespace neogfx::game
         system<entity_info, box_collider, box_collider_2d>{ aEcs },
         iBroadphaseTree{ aEcs },
         iBroadphase2dTree{ aEcs },
-        iCollidersUpdated{ false }
+        iBroadphaseAabbTree{ aEcs },
+        iBroadphase2dAabbTree{ aEcs },
+        iBroadphase{ broadphase_algorithm::PartitionTree },
+        iCollidersUpdated{ false },
+        iIncrementalUpdate{ false },
+        iRebuildRequested{ false },
+        iRebuildPending{ false },
+        iGeneration{ 0u },
+        iLiveColliders{ 0u },
+        iLiveColliders2d{ 0u },
+        iParallelDetection{ false },
+        iDetectionThreads{ 0u }
     {
         Collision.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
+        Collisions.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
         start_thread_if();
     }
 
@@ -58,7 +71,10 @@ namespace neogfx::game
             scoped_component_lock<entity_info, box_collider> lock{ ecs() };
             thread_local std::vector<entity_id> hits;
             hits.clear();
-            iBroadphaseTree.pick(aPoint, hits);
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                iBroadphaseAabbTree.pick(aPoint, hits);
+            else
+                iBroadphaseTree.pick(aPoint, hits);
             if (!hits.empty())
                 return hits[0];
         }
@@ -68,7 +84,10 @@ namespace neogfx::game
             scoped_component_lock<entity_info, box_collider_2d> lock{ ecs() };
             thread_local std::vector<entity_id> hits;
             hits.clear();
-            iBroadphase2dTree.pick(aPoint.xy, hits);
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                iBroadphase2dAabbTree.pick(aPoint.xy, hits);
+            else
+                iBroadphase2dTree.pick(aPoint.xy, hits);
             if (!hits.empty())
                 return hits[0];
         }
@@ -107,6 +126,18 @@ namespace neogfx::game
 
     void collision_detector::update_colliders()
     {
+        if (iRebuildRequested.exchange(false))
+        {
+            // every live collider is dirty against a tree that is about to be cleared
+            iColliderSources.clear();
+            iColliderSources2d.clear();
+            iDirtyColliders.clear();
+            iDirtyColliders2d.clear();
+            iRebuildPending = true;
+        }
+        if (iIncrementalUpdate && ++iGeneration == 0u)
+            iGeneration = 1u;
+
         if (ecs().component_instantiated<box_collider>())
         {
             scoped_component_lock<entity_info, box_collider, mesh_filter, animation_filter, rigid_body> lock{ ecs() };
@@ -114,16 +145,20 @@ namespace neogfx::game
             auto const& animatedMeshFilters = ecs().component<animation_filter>();
             auto const& rigidBodies = ecs().component<rigid_body>();
             auto& boxColliders = ecs().component<box_collider>();
-            for (auto entity : boxColliders.entities())
+            iLiveColliders = 0u;
+            for_each_live_entity(ecs(), boxColliders, [&](entity_id entity)
             {
-                auto const& info = ecs().component<entity_info>().entity_record(entity);
-                if (info.destroyed)
-                    continue; // todo: add support for skip iterators
-                // todo: only update collider AABBs if rigid_body changes require it
                 auto const& meshFilter = meshFilters.has_entity_record(entity) ?
                     meshFilters.entity_record(entity) : current_animation_frame(animatedMeshFilters.entity_record(entity));
                 auto& collider = boxColliders.entity_record(entity);
                 collider.previousAabb = collider.currentAabb;
+                if (iIncrementalUpdate)
+                {
+                    ++iLiveColliders;
+                    if (!collider_source_changed(iColliderSources, entity, meshFilter, animatedMeshFilters.has_entity_record(entity)) && collider.currentAabb)
+                        return;
+                    iDirtyColliders.push_back(entity);
+                }
                 auto const& untransformed = (meshFilter.mesh != std::nullopt ?
                     *meshFilter.mesh : *meshFilter.sharedMesh.ptr);
                 if (!collider.untransformedAabb)
@@ -137,7 +172,7 @@ namespace neogfx::game
                         to_transformation_matrix(rigidBodies.entity_record(entity)) : mat44::identity()));
                 if (!collider.previousAabb)
                     collider.previousAabb = collider.currentAabb;
-            }
+            });
         }
 
         if (ecs().component_instantiated<box_collider_2d>())
@@ -147,16 +182,20 @@ namespace neogfx::game
             auto const& animatedMeshFilters = ecs().component<animation_filter>();
             auto const& rigidBodies = ecs().component<rigid_body>();
             auto& boxColliders2d = ecs().component<box_collider_2d>();
-            for (auto entity : boxColliders2d.entities())
+            iLiveColliders2d = 0u;
+            for_each_live_entity(ecs(), boxColliders2d, [&](entity_id entity)
             {
-                auto const& info = ecs().component<entity_info>().entity_record(entity);
-                if (info.destroyed)
-                    continue; // todo: add support for skip iterators
-                // todo: only update collider AABBs if rigid_body changes require it
                 auto const& meshFilter = meshFilters.has_entity_record(entity) ?
                     meshFilters.entity_record(entity) : current_animation_frame(animatedMeshFilters.entity_record(entity));
                 auto& collider = boxColliders2d.entity_record(entity);
                 collider.previousAabb = collider.currentAabb;
+                if (iIncrementalUpdate)
+                {
+                    ++iLiveColliders2d;
+                    if (!collider_source_changed(iColliderSources2d, entity, meshFilter, animatedMeshFilters.has_entity_record(entity)) && collider.currentAabb)
+                        return;
+                    iDirtyColliders2d.push_back(entity);
+                }
                 auto const& untransformed = (meshFilter.mesh != std::nullopt ?
                     *meshFilter.mesh : *meshFilter.sharedMesh.ptr);
                 if (!collider.untransformedAabb)
@@ -170,7 +209,7 @@ namespace neogfx::game
                         to_transformation_matrix(rigidBodies.entity_record(entity)) : mat44::identity()));
                 if (!collider.previousAabb)
                     collider.previousAabb = collider.currentAabb;
-            }
+            });
         }
 
         iCollidersUpdated = true;
@@ -181,40 +220,208 @@ namespace neogfx::game
         if (ecs().component_instantiated<box_collider>())
         {
             scoped_component_lock<entity_info, box_collider> lock{ ecs() };
-            iBroadphaseTree.full_update();
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                update_tree<box_collider>(iBroadphaseAabbTree, iDirtyColliders, iColliderSources, iLiveColliders);
+            else
+                update_tree<box_collider>(iBroadphaseTree, iDirtyColliders, iColliderSources, iLiveColliders);
         }
 
         if (ecs().component_instantiated<box_collider_2d>())
         {
             scoped_component_lock<entity_info, box_collider_2d> lock{ ecs() };
-            iBroadphase2dTree.full_update();
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                update_tree<box_collider_2d>(iBroadphase2dAabbTree, iDirtyColliders2d, iColliderSources2d, iLiveColliders2d);
+            else
+                update_tree<box_collider_2d>(iBroadphase2dTree, iDirtyColliders2d, iColliderSources2d, iLiveColliders2d);
+        }
+
+        iRebuildPending = false;
+    }
+
+    template <typename Collider, typename Tree>
+    void collision_detector::update_tree(Tree& aTree, std::vector<entity_id>& aDirtyColliders, collider_sources& aSources, std::size_t aLiveColliders)
+    {
+        if (!iIncrementalUpdate)
+        {
+            aTree.full_update();
+            return;
+        }
+        if (iRebuildPending)
+            aTree.clear();
+        auto const& colliders = ecs().component<Collider>();
+        live_entity_filter const live{ ecs() };
+        for (auto entity : aDirtyColliders)
+            if (colliders.has_entity_record(entity) && live(entity))
+                aTree.update_entity(entity, colliders.entity_record(entity));
+        aDirtyColliders.clear();
+        if (aSources.size() > aLiveColliders)
+        {
+            aTree.remove_entities_if([&](entity_id aEntity)
+            {
+                auto existing = aSources.find(aEntity);
+                return existing == aSources.end() || existing->second.generation != iGeneration;
+            });
+            for (auto existing = aSources.begin(); existing != aSources.end();)
+                existing = (existing->second.generation != iGeneration ? aSources.erase(existing) : std::next(existing));
         }
     }
 
     void collision_detector::detect_collisions()
     {
+        if (iParallelDetection)
+        {
+            iCollisionPairs.clear();
+            if (ecs().component_instantiated<box_collider>())
+            {
+                scoped_component_lock<entity_info, box_collider> lock{ ecs() };
+                if (iBroadphase == broadphase_algorithm::AabbTree)
+                    collect_collisions(iBroadphaseAabbTree);
+                else
+                    collect_collisions(iBroadphaseTree);
+            }
+            if (ecs().component_instantiated<box_collider_2d>())
+            {
+                scoped_component_lock<entity_info, box_collider_2d> lock{ ecs() };
+                if (iBroadphase == broadphase_algorithm::AabbTree)
+                    collect_collisions(iBroadphase2dAabbTree);
+                else
+                    collect_collisions(iBroadphase2dTree);
+            }
+            std::sort(iCollisionPairs.begin(), iCollisionPairs.end());
+            iCollisionPairs.erase(std::unique(iCollisionPairs.begin(), iCollisionPairs.end()), iCollisionPairs.end());
+            if (!iCollisionPairs.empty())
+                Collisions.trigger(iCollisionPairs);
+            iCollidersUpdated = false;
+            return;
+        }
+
         if (ecs().component_instantiated<box_collider>())
         {
             scoped_component_lock<entity_info, box_collider> lock{ ecs() };
-            iBroadphaseTree.collisions([this](entity_id e1, entity_id e2)
+            auto const collision = [this](entity_id e1, entity_id e2)
             {
                 Collision.trigger(e1, e2);
-            });
+            };
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                iBroadphaseAabbTree.collisions(collision);
+            else
+                iBroadphaseTree.collisions(collision);
         }
 
         if (ecs().component_instantiated<box_collider_2d>())
         {
             scoped_component_lock<entity_info, box_collider_2d> lock{ ecs() };
-            iBroadphase2dTree.full_update();
-            iBroadphase2dTree.collisions([this](entity_id e1, entity_id e2)
+            auto const collision = [this](entity_id e1, entity_id e2)
             {
                 Collision.trigger(e1, e2);
-            });
+            };
+            if (iBroadphase == broadphase_algorithm::AabbTree)
+                iBroadphase2dAabbTree.collisions(collision);
+            else
+                iBroadphase2dTree.collisions(collision);
         }
 
         iCollidersUpdated = false;
     }
 
+    template <typename Tree>
+    void collision_detector::collect_collisions(const Tree& aTree)
+    {
+        // called with the collider component locked; workers only use the no-lock accessors
+        live_entity_filter const live{ ecs() };
+        iCollisionBuffers.resize(parallel_concurrency());
+        for (auto& buffer : iCollisionBuffers)
+            buffer.clear();
+        parallel_for(aTree.collision_candidate_count(), CollisionBatchSize, [&](std::size_t aBegin, std::size_t aEnd, std::size_t aSlot)
+        {
+            auto& buffer = iCollisionBuffers[aSlot];
+            aTree.collisions(aBegin, aEnd, live, [&](entity_id e1, entity_id e2)
+            {
+                buffer.emplace_back(e1, e2);
+            });
+        }, iDetectionThreads);
+        for (auto const& buffer : iCollisionBuffers)
+            iCollisionPairs.insert(iCollisionPairs.end(), buffer.begin(), buffer.end());
+    }
+
+    bool collision_detector::parallel_detection_enabled() const
+    {
+        return iParallelDetection;
+    }
+
+    void collision_detector::enable_parallel_detection(std::size_t aMaxThreads)
+    {
+        iParallelDetection = true;
+        iDetectionThreads = aMaxThreads;
+    }
+
+    void collision_detector::disable_parallel_detection()
+    {
+        iParallelDetection = false;
+    }
+
+    bool collision_detector::incremental_update_enabled() const
+    {
+        return iIncrementalUpdate;
+    }
+
+    void collision_detector::enable_incremental_update(scalar aFatMargin)
+    {
+        iBroadphaseTree.set_fat_margin(aFatMargin);
+        iBroadphase2dTree.set_fat_margin(aFatMargin);
+        iBroadphaseAabbTree.set_fat_margin(aFatMargin);
+        iBroadphase2dAabbTree.set_fat_margin(aFatMargin);
+        if (iIncrementalUpdate)
+            return;
+        iIncrementalUpdate = true;
+        // entries left by full updates have no recorded placement so cannot be maintained incrementally
+        iRebuildRequested = true;
+    }
+
+    void collision_detector::disable_incremental_update()
+    {
+        if (!iIncrementalUpdate)
+            return;
+        iIncrementalUpdate = false;
+        iRebuildRequested = true;
+    }
+
+    bool collision_detector::collider_source_changed(collider_sources& aSources, entity_id aEntity, const mesh_filter& aMeshFilter, bool aAnimated)
+    {
+        auto const& rigidBodies = ecs().component<rigid_body>();
+        auto const position = rigidBodies.has_entity_record(aEntity) ? rigidBodies.entity_record(aEntity).position : vec3{};
+        auto const angle = rigidBodies.has_entity_record(aEntity) ? rigidBodies.entity_record(aEntity).angle : vec3{};
+        auto existing = aSources.find(aEntity);
+        if (existing == aSources.end())
+        {
+            aSources.emplace(aEntity, collider_source{ position, angle, aMeshFilter.transformation, iGeneration });
+            return true;
+        }
+        auto& source = existing->second;
+        source.generation = iGeneration;
+        if (!aAnimated && source.position == position && source.angle == angle && source.meshTransformation == aMeshFilter.transformation)
+            return false;
+        source.position = position;
+        source.angle = angle;
+        source.meshTransformation = aMeshFilter.transformation;
+        return true;
+    }
+
+    broadphase_algorithm collision_detector::broadphase() const
+    {
+        return iBroadphase;
+    }
+
+    void collision_detector::set_broadphase(broadphase_algorithm aAlgorithm)
+    {
+        if (iBroadphase == aAlgorithm)
+            return;
+        iBroadphase = aAlgorithm;
+        // the newly selected broadphase may hold stale entries from when it was last in use so it
+        // is cleared and every collider (re)inserted
+        iRebuildRequested = true;
+    }
+
     const aabb_octree<box_collider>& collision_detector::broadphase_tree() const
     {
         return iBroadphaseTree;
@@ -224,4 +431,14 @@ namespace neogfx::game
     {
         return iBroadphase2dTree;
     }
+
+    const aabb_tree<box_collider>& collision_detector::broadphase_aabb_tree() const
+    {
+        return iBroadphaseAabbTree;
+    }
+
+    const aabb_tree<box_collider_2d>& collision_detector::broadphase_2d_aabb_tree() const
+    {
+        return iBroadphase2dAabbTree;
+    }
 }
\ No newline at end of file
@@ -64,6 +64,24 @@ namespace neogfx
                     service<i_rendering_engine>().vertex_buffer(*this).reclaim(indices[0], indices[1]);
             }
             base_type::destroy_entity(aEntityId, aNotify);
+            std::scoped_lock<std::mutex> pendingLock{ iPendingDestructionsMutex };
+            iPendingDestructions.erase(aEntityId);
+        }
+
+        void ecs::async_destroy_entity(entity_id aEntityId, bool aNotify)
+        {
+            {
+                std::scoped_lock<std::mutex> pendingLock{ iPendingDestructionsMutex };
+                iPendingDestructions.insert(aEntityId);
+            }
+            base_type::async_destroy_entity(aEntityId, aNotify);
+        }
+
+        void ecs::pending_destructions(std::vector<entity_id>& aEntities) const
+        {
+            aEntities.clear();
+            std::scoped_lock<std::mutex> pendingLock{ iPendingDestructionsMutex };
+            aEntities.assign(iPendingDestructions.begin(), iPendingDestructions.end());
         }
 
         bool ecs::cacheable() const
@@ -80,5 +98,28 @@ namespace neogfx
         {
             return component<game::mesh_render_cache>();
         }
+
+        live_entity_filter::live_entity_filter(const i_ecs& aEcs)
+        {
+            auto const neogfxEcs = dynamic_cast<const ecs*>(&aEcs);
+            auto const& infos = aEcs.component<entity_info>();
+            if (neogfxEcs != nullptr)
+            {
+                neogfxEcs->pending_destructions(iPendingDestructions);
+                // an id may linger in the pending set (or be reused by a new entity) so it only counts as
+                // destroyed whilst its entity info still says so
+                iPendingDestructions.erase(std::remove_if(iPendingDestructions.begin(), iPendingDestructions.end(), [&](entity_id aEntity)
+                {
+                    return !infos.has_entity_record_no_lock(aEntity) || !infos.entity_record_no_lock(aEntity).destroyed;
+                }), iPendingDestructions.end());
+            }
+            else
+            {
+                for (std::size_t index = 0u; index < infos.component_data().size(); ++index)
+                    if (infos.component_data()[index].destroyed)
+                        iPendingDestructions.push_back(infos.entities()[index]);
+            }
+            std::sort(iPendingDestructions.begin(), iPendingDestructions.end());
+        }
     }
 }
\ No newline at end of file
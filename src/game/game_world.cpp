@@ -24,12 +24,16 @@
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/time.hpp>
 #include <neogfx/game/clock.hpp>
+#include <neogfx/game/barnes_hut_octree.hpp>
 #include <neogfx/game/game_world.hpp>
 
 namespace neogfx::game
 {
     game_world::game_world(game::i_ecs& aEcs) :
-        game::system<>{ aEcs }, iUniversalGravitationEnabled{ false }
+        game::system<>{ aEcs },
+        iUniversalGravitationEnabled{ false },
+        iUniversalGravitationAlgorithm{ gravitation_algorithm::Exact },
+        iBarnesHutOpeningAngle{ barnes_hut_octree::DefaultOpeningAngle }
     {
         ApplyingPhysics.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
         PhysicsApplied.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
@@ -76,4 +80,24 @@ namespace neogfx::game
         iUniversalGravitationEnabled = false;
     }
 
+    gravitation_algorithm game_world::universal_gravitation_algorithm() const
+    {
+        return iUniversalGravitationAlgorithm;
+    }
+
+    void game_world::set_universal_gravitation_algorithm(gravitation_algorithm aAlgorithm)
+    {
+        iUniversalGravitationAlgorithm = aAlgorithm;
+    }
+
+    scalar game_world::barnes_hut_opening_angle() const
+    {
+        return iBarnesHutOpeningAngle;
+    }
+
+    void game_world::set_barnes_hut_opening_angle(scalar aOpeningAngle)
+    {
+        iBarnesHutOpeningAngle = aOpeningAngle;
+    }
+
 }
\ No newline at end of file
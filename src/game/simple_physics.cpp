@@ -19,6 +19,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <neogfx/core/async_thread.hpp>
+#include <neogfx/core/parallel.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/entity_info.hpp>
 #include <neogfx/game/game_world.hpp>
@@ -32,6 +33,23 @@
 
 namespace neogfx::game
 {
+    namespace
+    {
+        bool integrate(rigid_body& aRigidBody, const vec3& aTotalForce, scalar aElapsedTime)
+        {
+            // GCSE-level physics (Newtonian) going on here... :)
+            // v = u + at
+            // F = ma; a = F/m
+            auto v0 = aRigidBody.velocity;
+            auto p0 = aRigidBody.position;
+            auto a0 = aRigidBody.angle;
+            aRigidBody.velocity = v0 + ((aRigidBody.mass == 0 ? vec3{} : aTotalForce / aRigidBody.mass) + (rotation_matrix(aRigidBody.angle) * aRigidBody.acceleration)).scale(vec3{ aElapsedTime, aElapsedTime, aElapsedTime });
+            aRigidBody.position = aRigidBody.position + vec3{ 1.0, 1.0, 1.0 }.scale(aElapsedTime * (v0 + aRigidBody.velocity) / 2.0);
+            aRigidBody.angle = (aRigidBody.angle + aRigidBody.spin * aElapsedTime) % (2.0 * boost::math::constants::pi<scalar>());
+            return p0 != aRigidBody.position || a0 != aRigidBody.angle;
+        }
+    }
+
     simple_physics::simple_physics(i_ecs& aEcs) :
         system<entity_info, box_collider, box_collider_2d, mesh_filter, rigid_body, mesh_render_cache>{ aEcs }
     {
@@ -91,44 +109,82 @@ namespace neogfx::game
             ecs().system<game_world>().ApplyingPhysics.trigger(worldClock.time);
             start_update(2);
             bool useUniversalGravitation = (universal_gravitation_enabled() && physicalConstants.gravitationalConstant != 0.0);
-            if (useUniversalGravitation)
+            bool useBarnesHut = useUniversalGravitation && universal_gravitation_algorithm() == gravitation_algorithm::BarnesHut;
+            if (useUniversalGravitation && !useBarnesHut)
                 rigidBodies.sort([](const rigid_body& lhs, const rigid_body& rhs) { return lhs.mass > rhs.mass; });
-            auto firstMassless = useUniversalGravitation ?
+            auto firstMassless = useUniversalGravitation && !useBarnesHut ?
                 std::find_if(rigidBodies.component_data().begin(), rigidBodies.component_data().end(), [](const rigid_body& body) { return body.mass == 0.0; }) :
                 rigidBodies.component_data().begin();
-            for (auto& rigidBody1 : rigidBodies.component_data())
+            live_entity_filter const live{ ecs() };
+            if (useBarnesHut)
+            {
+                iGravitationTree.set_opening_angle(ecs().system<game_world>().barnes_hut_opening_angle());
+                iGravitationTree.clear();
+                for (auto const& rigidBody : rigidBodies.component_data())
+                {
+                    if (!live(rigidBodies.entity(rigidBody)))
+                        continue;
+                    iGravitationTree.add(rigidBody.position, rigidBody.mass);
+                }
+                iGravitationTree.build();
+            }
+            auto const elapsedTime = from_step_time(nextTime - worldClock.time);
+            if (parallel_integration_enabled())
+            {
+                if (useUniversalGravitation && !useBarnesHut)
+                    snapshot_massive_bodies(rigidBodies, static_cast<std::size_t>(std::distance(rigidBodies.component_data().begin(), firstMassless)), live);
+                iDirtyEntities.resize(parallel_concurrency());
+                for (auto& dirtyEntities : iDirtyEntities)
+                    dirtyEntities.clear();
+                auto& bodies = rigidBodies.component_data();
+                parallel_for(bodies.size(), IntegrationBatchSize, [&](std::size_t aBegin, std::size_t aEnd, std::size_t aSlot)
+                {
+                    auto& dirtyEntities = iDirtyEntities[aSlot];
+                    for (auto index = aBegin; index != aEnd; ++index)
+                    {
+                        auto& rigidBody = bodies[index];
+                        auto entity = rigidBodies.entity(rigidBody);
+                        if (!live(entity))
+                            continue;
+                        vec3 totalForce = rigidBody.mass * uniformGravity;
+                        if (useBarnesHut)
+                            totalForce += physicalConstants.gravitationalConstant * rigidBody.mass * iGravitationTree.field(rigidBody.position);
+                        else if (useUniversalGravitation)
+                            totalForce += physicalConstants.gravitationalConstant * rigidBody.mass * massive_bodies_field(rigidBody.position);
+                        if (integrate(rigidBody, totalForce, elapsedTime))
+                            dirtyEntities.push_back(entity);
+                    }
+                }, iIntegrationThreads);
+                auto& renderCache = ecs().component<mesh_render_cache>();
+                for (auto const& dirtyEntities : iDirtyEntities)
+                    for (auto entity : dirtyEntities)
+                        set_render_cache_dirty_no_lock(renderCache, entity);
+            }
+            else
             {
-                auto entity1 = rigidBodies.entity(rigidBody1);
-                auto const& entity1Info = ecs().component<entity_info>().entity_record(entity1);
-                if (entity1Info.destroyed)
-                    continue; // todo: add support for skip iterators
-                vec3 totalForce = rigidBody1.mass * uniformGravity;
-                if (useUniversalGravitation)
+                for (auto& rigidBody1 : rigidBodies.component_data())
                 {
-                    for (auto iterRigidBody2 = rigidBodies.component_data().begin(); iterRigidBody2 != firstMassless; ++iterRigidBody2)
+                    auto entity1 = rigidBodies.entity(rigidBody1);
+                    if (!live(entity1))
+                        continue;
+                    vec3 totalForce = rigidBody1.mass * uniformGravity;
+                    if (useBarnesHut)
+                        totalForce += physicalConstants.gravitationalConstant * rigidBody1.mass * iGravitationTree.field(rigidBody1.position);
+                    else if (useUniversalGravitation)
                     {
-                        auto& rigidBody2 = *iterRigidBody2;
-                        auto entity2 = rigidBodies.entity(rigidBody2);
-                        auto const& entity2Info = ecs().component<entity_info>().entity_record(entity2);
-                        if (entity2Info.destroyed)
-                            continue; // todo: add support for skip iterators
-                        vec3 distance = rigidBody1.position - rigidBody2.position;
-                        if (distance.magnitude() > 0.0) // avoid division by zero or rigidBody1 == rigidBody2
-                            totalForce += -physicalConstants.gravitationalConstant * rigidBody2.mass * rigidBody1.mass * distance / std::pow(distance.magnitude(), 3.0);
+                        for (auto iterRigidBody2 = rigidBodies.component_data().begin(); iterRigidBody2 != firstMassless; ++iterRigidBody2)
+                        {
+                            auto& rigidBody2 = *iterRigidBody2;
+                            if (!live(rigidBodies.entity(rigidBody2)))
+                                continue;
+                            vec3 distance = rigidBody1.position - rigidBody2.position;
+                            if (distance.magnitude() > 0.0) // avoid division by zero or rigidBody1 == rigidBody2
+                                totalForce += -physicalConstants.gravitationalConstant * rigidBody2.mass * rigidBody1.mass * distance / std::pow(distance.magnitude(), 3.0);
+                        }
                     }
+                    if (integrate(rigidBody1, totalForce, elapsedTime))
+                        set_render_cache_dirty(ecs(), entity1);
                 }
-                // GCSE-level physics (Newtonian) going on here... :)
-                // v = u + at
-                // F = ma; a = F/m
-                auto v0 = rigidBody1.velocity;
-                auto p0 = rigidBody1.position;
-                auto a0 = rigidBody1.angle;
-                auto elapsedTime = from_step_time(nextTime - worldClock.time);
-                rigidBody1.velocity = v0 + ((rigidBody1.mass == 0 ? vec3{} : totalForce / rigidBody1.mass) + (rotation_matrix(rigidBody1.angle) * rigidBody1.acceleration)).scale(vec3{ elapsedTime, elapsedTime, elapsedTime });
-                rigidBody1.position = rigidBody1.position + vec3{ 1.0, 1.0, 1.0 }.scale(elapsedTime * (v0 + rigidBody1.velocity) / 2.0);
-                rigidBody1.angle = (rigidBody1.angle + rigidBody1.spin * elapsedTime) % (2.0 * boost::math::constants::pi<scalar>());
-                if (p0 != rigidBody1.position || a0 != rigidBody1.angle)
-                    set_render_cache_dirty(ecs(), entity1);
             }
             end_update(2);
             if (ecs().system_instantiated<collision_detector>() && !ecs().system<collision_detector>().paused())
@@ -166,8 +222,78 @@ namespace neogfx::game
         return ecs().system<game_world>().disable_universal_gravitation();
     }
 
+    gravitation_algorithm simple_physics::universal_gravitation_algorithm() const
+    {
+        return ecs().system<game_world>().universal_gravitation_algorithm();
+    }
+
+    void simple_physics::set_universal_gravitation_algorithm(gravitation_algorithm aAlgorithm)
+    {
+        return ecs().system<game_world>().set_universal_gravitation_algorithm(aAlgorithm);
+    }
+
+    bool simple_physics::parallel_integration_enabled() const
+    {
+        return iParallelIntegration;
+    }
+
+    void simple_physics::enable_parallel_integration(std::size_t aMaxThreads)
+    {
+        iParallelIntegration = true;
+        iIntegrationThreads = aMaxThreads;
+    }
+
+    void simple_physics::disable_parallel_integration()
+    {
+        iParallelIntegration = false;
+    }
+
     void simple_physics::yield_after(std::chrono::duration<double, std::milli> aTime)
     {
         iYieldTime = aTime;
     }
+
+    void simple_physics::snapshot_massive_bodies(const component<rigid_body>& aRigidBodies, std::size_t aMassiveCount, const live_entity_filter& aLive)
+    {
+        iMassiveBodies.x.clear();
+        iMassiveBodies.y.clear();
+        iMassiveBodies.z.clear();
+        iMassiveBodies.mass.clear();
+        for (std::size_t index = 0u; index < aMassiveCount; ++index)
+        {
+            auto const& rigidBody = aRigidBodies.component_data()[index];
+            if (!aLive(aRigidBodies.entity(rigidBody)))
+                continue;
+            iMassiveBodies.x.push_back(rigidBody.position.x);
+            iMassiveBodies.y.push_back(rigidBody.position.y);
+            iMassiveBodies.z.push_back(rigidBody.position.z);
+            iMassiveBodies.mass.push_back(rigidBody.mass);
+        }
+    }
+
+    vec3 simple_physics::massive_bodies_field(const vec3& aPosition) const
+    {
+        // structure of arrays with a branch-free body so the compiler can vectorize the loop
+        scalar const* const x = iMassiveBodies.x.data();
+        scalar const* const y = iMassiveBodies.y.data();
+        scalar const* const z = iMassiveBodies.z.data();
+        scalar const* const mass = iMassiveBodies.mass.data();
+        auto const count = iMassiveBodies.mass.size();
+        scalar fx = 0.0;
+        scalar fy = 0.0;
+        scalar fz = 0.0;
+        for (std::size_t index = 0u; index < count; ++index)
+        {
+            auto const dx = x[index] - aPosition.x;
+            auto const dy = y[index] - aPosition.y;
+            auto const dz = z[index] - aPosition.z;
+            auto const distanceSquared = dx * dx + dy * dy + dz * dz;
+            auto const coincident = (distanceSquared == 0.0);
+            auto const scale = coincident ? 0.0 : mass[index] / ((coincident ? 1.0 : distanceSquared) * std::sqrt(coincident ? 1.0 : distanceSquared));
+            fx += dx * scale;
+            fy += dy * scale;
+            fz += dz * scale;
+        }
+        return vec3{ fx, fy, fz };
+    }
 }
\ No newline at end of file
@@ -416,25 +416,14 @@ namespace neogfx
     {
         if (aFill != neolib::none)
             fill_path(aPath, aFill);
-        path path = to_device_units(aPath);
-        path.set_position(path.position() + iOrigin);
-        native_context().enqueue(graphics_operation::draw_path{ path, aPen });
+        native_context().enqueue(graphics_operation::draw_path{ device_path(aPath), aPen });
     }
 
     void graphics_context::draw_shape(const game::mesh& aShape, const vec3& aPosition, const pen& aPen, const brush& aFill) const
     {
         if (aFill != neolib::none)
             fill_shape(aShape, aPosition, aFill);
-        vec2 const toDeviceUnits = to_device_units(vec2{ 1.0, 1.0 });
-        native_context().enqueue(
-            graphics_operation::draw_shape{
-                mat44{ 
-                    { toDeviceUnits.x, 0.0, 0.0, 0.0 },
-                    { 0.0, toDeviceUnits.y, 0.0, 0.0 },
-                    { 0.0, 0.0, 1.0, 0.0 }, 
-                    { iOrigin.x, iOrigin.y, 0.0, 1.0 } } * aShape,
-                aPosition,
-                aPen });
+        native_context().enqueue(graphics_operation::draw_shape{ device_shape(aShape), aPosition, aPen });
     }
 
     void graphics_context::draw_entities(game::i_ecs& aEcs, int32_t aLayer) const
@@ -488,23 +477,12 @@ namespace neogfx
 
     void graphics_context::fill_path(const path& aPath, const brush& aFill) const
     {
-        path path = to_device_units(aPath);
-        path.set_position(path.position() + iOrigin);
-        native_context().enqueue(graphics_operation::fill_path{ path, aFill });
+        native_context().enqueue(graphics_operation::fill_path{ device_path(aPath), aFill });
     }
 
     void graphics_context::fill_shape(const game::mesh& aShape, const vec3& aPosition, const brush& aFill) const
     {
-        vec2 const toDeviceUnits = to_device_units(vec2{ 1.0, 1.0 });
-        native_context().enqueue(
-            graphics_operation::fill_shape{
-                mat44{ 
-                    { toDeviceUnits.x, 0.0, 0.0, 0.0 },
-                    { 0.0, toDeviceUnits.y, 0.0, 0.0 },
-                    { 0.0, 0.0, 1.0, 0.0 }, 
-                    { iOrigin.x, iOrigin.y, 0.0, 1.0 } } * aShape,
-                aPosition,
-                aFill });
+        native_context().enqueue(graphics_operation::fill_shape{ device_shape(aShape), aPosition, aFill });
     }
 
     size graphics_context::text_extent(std::string const& aText, const font& aFont) const
@@ -743,6 +721,38 @@ namespace neogfx
         throw unattached();
     }
 
+    graphics_operation::path_id graphics_context::device_path(const path& aPath) const
+    {
+        // converted in place in the queue's recycled payload slot rather than via temporaries
+        auto& queue = native_context().queue();
+        auto const result = queue.new_path(aPath);
+        auto& devicePath = queue.path(result);
+        devicePath.set_position(to_device_units(devicePath.position()) + iOrigin);
+        for (auto& subPath : devicePath.sub_paths())
+            for (auto& point : subPath)
+                point = to_device_units(point);
+        return result;
+    }
+
+    graphics_operation::mesh_id graphics_context::device_shape(const game::mesh& aShape) const
+    {
+        vec2 const toDeviceUnits = to_device_units(vec2{ 1.0, 1.0 });
+        mat44 const transformation{
+            { toDeviceUnits.x, 0.0, 0.0, 0.0 },
+            { 0.0, toDeviceUnits.y, 0.0, 0.0 },
+            { 0.0, 0.0, 1.0, 0.0 },
+            { iOrigin.x, iOrigin.y, 0.0, 1.0 } };
+        auto& queue = native_context().queue();
+        auto const result = queue.new_mesh();
+        auto& deviceShape = queue.mesh(result);
+        deviceShape.vertices.reserve(aShape.vertices.size());
+        for (auto const& v : aShape.vertices)
+            deviceShape.vertices.push_back(transformation * v);
+        deviceShape.uv = aShape.uv;
+        deviceShape.faces = aShape.faces;
+        return result;
+    }
+
     void graphics_context::flush() const
     {
         native_context().flush();
@@ -1189,7 +1199,7 @@ namespace neogfx
         vec2 const toDeviceUnits = to_device_units(vec2{ 1.0, 1.0 });
         native_context().enqueue(
             graphics_operation::draw_mesh{
-                aMesh,
+                native_context().queue().new_mesh(aMesh),
                 aMaterial,
                 mat44{
                     { toDeviceUnits.x, 0.0, 0.0, 0.0 },
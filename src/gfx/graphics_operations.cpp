@@ -168,5 +168,402 @@ namespace neogfx
                 return false;
             }
         }
+
+        namespace
+        {
+            struct reorder_group
+            {
+                std::size_t first;
+                std::size_t last;
+                rect bounds;
+            };
+
+            // How many groups back an operation may be moved; bounds the cost of the pass on long queues.
+            constexpr std::size_t ReorderLookback = 32u;
+            constexpr std::size_t NoOperation = static_cast<std::size_t>(-1);
+
+            inline bool overlapping(const rect& aLeft, const rect& aRight)
+            {
+                return aLeft.x < aRight.x + aRight.cx && aRight.x < aLeft.x + aLeft.cx &&
+                    aLeft.y < aRight.y + aRight.cy && aRight.y < aLeft.y + aLeft.cy;
+            }
+
+            inline rect stroke_bounds(const rect& aRect, const pen& aPen)
+            {
+                return aRect.inflated(size{ aPen.width() / 2.0 });
+            }
+
+            inline std::size_t payload_bytes(const path& aPath)
+            {
+                std::size_t result = 0u;
+                for (auto const& subPath : aPath.sub_paths())
+                    result += subPath.size() * sizeof(path::point_type);
+                return result;
+            }
+
+            inline std::size_t payload_bytes(const game::mesh& aMesh)
+            {
+                return aMesh.vertices.size() * sizeof(decltype(aMesh.vertices)::value_type) +
+                    aMesh.uv.size() * sizeof(decltype(aMesh.uv)::value_type) +
+                    aMesh.faces.size() * sizeof(decltype(aMesh.faces)::value_type);
+            }
+        }
+
+        queue::queue() :
+            iPathsUsed{ 0u },
+            iMeshesUsed{ 0u },
+            iOperationsHighWater{ 0u },
+            iStatistics{}
+        {
+        }
+
+        bool queue::empty() const
+        {
+            return iOperations.empty();
+        }
+
+        std::size_t queue::size() const
+        {
+            return iOperations.size();
+        }
+
+        queue::const_iterator queue::begin() const
+        {
+            return iOperations.begin();
+        }
+
+        queue::const_iterator queue::end() const
+        {
+            return iOperations.end();
+        }
+
+        queue::iterator queue::begin()
+        {
+            return iOperations.begin();
+        }
+
+        queue::iterator queue::end()
+        {
+            return iOperations.end();
+        }
+
+        const operation_list& queue::operations() const
+        {
+            return iOperations;
+        }
+
+        operation_list& queue::operations()
+        {
+            return iOperations;
+        }
+
+        void queue::push_back(const operation& aOperation)
+        {
+            iOperations.push_back(aOperation);
+        }
+
+        void queue::clear()
+        {
+            // A slot's containers keep the capacity of the largest payload they have held, so only growth
+            // beyond that high water mark is a fresh allocation.
+            statistics result{ iOperations.size(), iPathsUsed + iMeshesUsed, 0u, 0u };
+            auto account = [&](auto& aSlot)
+            {
+                auto const bytes = payload_bytes(aSlot.payload);
+                result.payloadBytes += bytes;
+                if (bytes > aSlot.highWater)
+                {
+                    result.allocatedBytes += bytes - aSlot.highWater;
+                    aSlot.highWater = bytes;
+                }
+            };
+            for (std::size_t i = 0u; i < iPathsUsed; ++i)
+                account(iPaths[i]);
+            for (std::size_t i = 0u; i < iMeshesUsed; ++i)
+                account(iMeshes[i]);
+            if (iOperations.size() > iOperationsHighWater)
+            {
+                result.allocatedBytes += (iOperations.size() - iOperationsHighWater) * sizeof(operation);
+                iOperationsHighWater = iOperations.size();
+            }
+            iStatistics = result;
+            iOperations.clear();
+            iPathsUsed = 0u;
+            iMeshesUsed = 0u;
+        }
+
+        path_id queue::new_path(const neogfx::path& aPath)
+        {
+            if (iPathsUsed == iPaths.size())
+                iPaths.push_back(slot<neogfx::path>{ aPath, 0u });
+            else
+                iPaths[iPathsUsed].payload = aPath;
+            return path_id{ static_cast<uint32_t>(iPathsUsed++) };
+        }
+
+        mesh_id queue::new_mesh()
+        {
+            if (iMeshesUsed == iMeshes.size())
+                iMeshes.push_back(slot<game::mesh>{ {}, 0u });
+            else
+            {
+                auto& mesh = iMeshes[iMeshesUsed].payload;
+                mesh.vertices.clear();
+                mesh.uv.clear();
+                mesh.faces.clear();
+            }
+            return mesh_id{ static_cast<uint32_t>(iMeshesUsed++) };
+        }
+
+        mesh_id queue::new_mesh(const game::mesh& aMesh)
+        {
+            auto const result = new_mesh();
+            mesh(result) = aMesh;
+            return result;
+        }
+
+        const neogfx::path& queue::path(path_id aPath) const
+        {
+            return iPaths[aPath.index].payload;
+        }
+
+        neogfx::path& queue::path(path_id aPath)
+        {
+            return iPaths[aPath.index].payload;
+        }
+
+        const game::mesh& queue::mesh(mesh_id aMesh) const
+        {
+            return iMeshes[aMesh.index].payload;
+        }
+
+        game::mesh& queue::mesh(mesh_id aMesh)
+        {
+            return iMeshes[aMesh.index].payload;
+        }
+
+        const queue::statistics& queue::last_statistics() const
+        {
+            return iStatistics;
+        }
+
+        optional_rect bounding_rect(const queue& aQueue, const operation& aOperation)
+        {
+            // one pixel of slack covers snap-to-pixel offsets and anti-aliasing fringes
+            size const margin{ 1.0 };
+            switch (static_cast<operation_type>(aOperation.index()))
+            {
+            case operation_type::SetPixel:
+                return rect{ static_variant_cast<const set_pixel&>(aOperation).point, size{ 1.0 } }.inflated(margin);
+            case operation_type::DrawPixel:
+                return rect{ static_variant_cast<const draw_pixel&>(aOperation).point, size{ 1.0 } }.inflated(margin);
+            case operation_type::DrawLine:
+                {
+                    auto& op = static_variant_cast<const draw_line&>(aOperation);
+                    return stroke_bounds(rect{ op.from.min(op.to), op.from.max(op.to) }, op.pen).inflated(margin);
+                }
+            case operation_type::DrawRect:
+                {
+                    auto& op = static_variant_cast<const draw_rect&>(aOperation);
+                    return stroke_bounds(op.rect, op.pen).inflated(margin);
+                }
+            case operation_type::DrawRoundedRect:
+                {
+                    auto& op = static_variant_cast<const draw_rounded_rect&>(aOperation);
+                    return stroke_bounds(op.rect, op.pen).inflated(margin);
+                }
+            case operation_type::DrawCircle:
+                {
+                    auto& op = static_variant_cast<const draw_circle&>(aOperation);
+                    return stroke_bounds(rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }, op.pen).inflated(margin);
+                }
+            case operation_type::DrawArc:
+                {
+                    auto& op = static_variant_cast<const draw_arc&>(aOperation);
+                    return stroke_bounds(rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }, op.pen).inflated(margin);
+                }
+            case operation_type::DrawCubicBezier:
+                {
+                    auto& op = static_variant_cast<const draw_cubic_bezier&>(aOperation);
+                    return stroke_bounds(rect{ op.p0.min(op.p1.min(op.p2.min(op.p3))), op.p0.max(op.p1.max(op.p2.max(op.p3))) }, op.pen).inflated(margin);
+                }
+            case operation_type::DrawPath:
+                {
+                    auto& op = static_variant_cast<const draw_path&>(aOperation);
+                    return stroke_bounds(aQueue.path(op.path).bounding_rect(), op.pen).inflated(margin);
+                }
+            case operation_type::DrawShape:
+                {
+                    auto& op = static_variant_cast<const draw_shape&>(aOperation);
+                    auto result = neogfx::bounding_rect(aQueue.mesh(op.mesh));
+                    result.position() += point{ op.position.x, op.position.y };
+                    return stroke_bounds(result, op.pen).inflated(margin);
+                }
+            case operation_type::FillRect:
+                return static_variant_cast<const fill_rect&>(aOperation).rect.inflated(margin);
+            case operation_type::FillRoundedRect:
+                return static_variant_cast<const fill_rounded_rect&>(aOperation).rect.inflated(margin);
+            case operation_type::FillCheckerRect:
+                return static_variant_cast<const fill_checker_rect&>(aOperation).rect.inflated(margin);
+            case operation_type::FillCircle:
+                {
+                    auto& op = static_variant_cast<const fill_circle&>(aOperation);
+                    return rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }.inflated(margin);
+                }
+            case operation_type::FillArc:
+                {
+                    auto& op = static_variant_cast<const fill_arc&>(aOperation);
+                    return rect{ op.center - point{ op.radius, op.radius }, size{ op.radius * 2.0 } }.inflated(margin);
+                }
+            case operation_type::FillPath:
+                return aQueue.path(static_variant_cast<const fill_path&>(aOperation).path).bounding_rect().inflated(margin);
+            case operation_type::FillShape:
+                {
+                    auto& op = static_variant_cast<const fill_shape&>(aOperation);
+                    auto result = neogfx::bounding_rect(aQueue.mesh(op.mesh));
+                    result.position() += point{ op.position.x, op.position.y };
+                    return result.inflated(margin);
+                }
+            case operation_type::DrawGlyph:
+                {
+                    // the line box combined with the glyph textures, which can overhang both the advance and the
+                    // line box; glyphs are placed as the rendering contexts place them, and as the logical coordinate
+                    // system isn't known here the texture is allowed for in both vertical orientations
+                    auto& op = static_variant_cast<const draw_glyphs&>(aOperation);
+                    auto const& glyphText = op.glyphText.content();
+                    scalar x = op.point.x;
+                    scalar left = x;
+                    scalar right = x;
+                    scalar top = op.point.y;
+                    scalar bottom = op.point.y;
+                    for (auto g = op.begin; g != op.end; ++g)
+                    {
+                        auto const& glyph = *g;
+                        auto const& glyphFont = glyphText.glyph_font(glyph);
+                        bottom = std::max(bottom, op.point.y + glyphFont.height());
+                        right = std::max(right, x + advance(glyph).cx);
+                        if (!is_whitespace(glyph) && !is_emoji(glyph))
+                        {
+                            auto const& glyphTexture = glyphText.glyph_texture(glyph);
+                            auto const& textureExtents = glyphTexture.texture().extents();
+                            auto const glyphOffset = glyph.offset.as<scalar>();
+                            auto const glyphLeft = x + glyphTexture.placement().x + glyphOffset.x;
+                            auto const glyphBaseline = glyphTexture.placement().y + -glyphFont.descender();
+                            auto const glyphTopGame = op.point.y + glyphBaseline + glyphOffset.y;
+                            auto const glyphTopGui = op.point.y + glyphFont.height() - glyphBaseline - textureExtents.cy + glyphOffset.y;
+                            left = std::min(left, glyphLeft);
+                            right = std::max(right, glyphLeft + textureExtents.cx);
+                            top = std::min(top, std::min(glyphTopGame, glyphTopGui));
+                            bottom = std::max(bottom, std::max(glyphTopGame, glyphTopGui) + textureExtents.cy);
+                        }
+                        x += advance(glyph).cx;
+                    }
+                    rect result{ point{ left, top }, size{ right - left, bottom - top } };
+                    if (op.appearance.effect())
+                    {
+                        auto const& effect = *op.appearance.effect();
+                        auto const offset = effect.offset();
+                        result.inflate(size{ effect.width() + std::abs(offset.x), effect.width() + std::abs(offset.y) });
+                    }
+                    return result.inflated(margin);
+                }
+            case operation_type::DrawMesh:
+                {
+                    auto& op = static_variant_cast<const draw_mesh&>(aOperation);
+                    if (op.filter != std::nullopt)
+                        return {};
+                    return neogfx::bounding_rect(aQueue.mesh(op.mesh), op.transformation).inflated(margin);
+                }
+            default:
+                return {};
+            }
+        }
+
+        std::size_t batch_count(const queue& aQueue)
+        {
+            std::size_t result = 0u;
+            for (auto batchStart = aQueue.begin(); batchStart != aQueue.end(); ++result)
+            {
+                auto batchEnd = std::next(batchStart);
+                while (batchEnd != aQueue.end() && batchable(*batchStart, *batchEnd))
+                    ++batchEnd;
+                batchStart = batchEnd;
+            }
+            return result;
+        }
+
+        void reorder(queue& aQueue)
+        {
+            thread_local std::vector<optional_rect> bounds;
+            thread_local std::vector<std::size_t> next;
+            thread_local std::vector<reorder_group> groups;
+            thread_local operation_list reordered;
+
+            auto& operations = aQueue.operations();
+            bounds.clear();
+            for (auto const& op : operations)
+                bounds.push_back(bounding_rect(aQueue, op));
+            next.assign(operations.size(), NoOperation);
+            groups.clear();
+            reordered.clear();
+            reordered.reserve(operations.size());
+
+            auto emit_groups = [&]()
+            {
+                for (auto const& group : groups)
+                    for (auto i = group.first; i != NoOperation; i = next[i])
+                        reordered.push_back(std::move(operations[i]));
+                groups.clear();
+            };
+
+            auto overlaps_group = [&](const reorder_group& aGroup, const rect& aBounds)
+            {
+                if (!overlapping(aGroup.bounds, aBounds))
+                    return false;
+                for (auto i = aGroup.first; i != NoOperation; i = next[i])
+                    if (overlapping(*bounds[i], aBounds))
+                        return true;
+                return false;
+            };
+
+            for (std::size_t i = 0u; i < operations.size(); ++i)
+            {
+                if (bounds[i] == std::nullopt)
+                {
+                    // state changes (scissor, opacity, blending mode, logical coordinates...) are barriers
+                    emit_groups();
+                    reordered.push_back(std::move(operations[i]));
+                    continue;
+                }
+                auto const& opBounds = *bounds[i];
+                std::optional<std::size_t> target;
+                std::size_t examined = 0u;
+                // walk back over later groups: the operation can join a group only if it does not overlap
+                // anything drawn after that group, otherwise painter's order would change
+                for (auto g = groups.size(); g-- > 0u && examined++ < ReorderLookback;)
+                {
+                    if (batchable(operations[groups[g].first], operations[i]))
+                    {
+                        target = g;
+                        break;
+                    }
+                    if (overlaps_group(groups[g], opBounds))
+                        break;
+                }
+                if (target != std::nullopt)
+                {
+                    auto& group = groups[*target];
+                    next[group.last] = i;
+                    group.last = i;
+                    group.bounds = group.bounds.combined(opBounds);
+                }
+                else
+                    groups.push_back(reorder_group{ i, i, opBounds });
+            }
+            emit_groups();
+
+            operations.swap(reordered);
+            reordered.clear();
+        }
     }
 }
\ No newline at end of file
@@ -74,7 +74,11 @@ namespace neogfx
         iRenderer{ aRenderer },
         iLimitFrameRate{ true },
         iFrameRateLimit{ 60u },
-        iSubpixelRendering{ false }
+        iSubpixelRendering{ false },
+        iReorderOperations{ false },
+        iCollectStatistics{ false },
+        iStatistics{},
+        iLastFrameStatistics{}
     {
 #ifdef _WIN32
         ::SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
@@ -416,4 +420,45 @@ namespace neogfx
         aPreviousExtents = idealSize;
         return newBuffer->second.first;
     }
+
+    bool opengl_renderer::operation_reordering_enabled() const
+    {
+        return iReorderOperations;
+    }
+
+    void opengl_renderer::enable_operation_reordering(bool aEnable)
+    {
+        iReorderOperations = aEnable;
+    }
+
+    bool opengl_renderer::frame_statistics_enabled() const
+    {
+        return iCollectStatistics;
+    }
+
+    void opengl_renderer::enable_frame_statistics(bool aEnable)
+    {
+        iCollectStatistics = aEnable;
+    }
+
+    const opengl_renderer::frame_statistics& opengl_renderer::last_frame_statistics() const
+    {
+        return iLastFrameStatistics;
+    }
+
+    void opengl_renderer::flushed(uint64_t aBatchesBeforeReorder, uint64_t aBatchesAfterReorder, const graphics_operation::queue::statistics& aQueueStatistics)
+    {
+        ++iStatistics.flushes;
+        iStatistics.operations += aQueueStatistics.operations;
+        iStatistics.batchesBeforeReorder += aBatchesBeforeReorder;
+        iStatistics.batchesAfterReorder += aBatchesAfterReorder;
+        iStatistics.payloadBytes += aQueueStatistics.payloadBytes;
+        iStatistics.allocatedBytes += aQueueStatistics.allocatedBytes;
+    }
+
+    void opengl_renderer::next_frame()
+    {
+        iLastFrameStatistics = iStatistics;
+        iStatistics = {};
+    }
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <map>
 #include <neolib/task/timer.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/graphics_operations.hpp>
 #include <neogfx/gfx/text/font_manager.hpp>
 #include <neogfx/gfx/i_standard_shader_program.hpp>
 #include "opengl.hpp"
@@ -70,6 +71,16 @@ namespace neogfx
         typedef neolib::vector<neolib::ref_ptr<i_shader_program>> shader_program_list;
         typedef std::map<std::pair<texture_sampling, size>, std::pair<texture, size>> ping_pong_buffers_t;
         typedef i_rendering_engine::handle opengl_context;
+        struct frame_statistics
+        {
+            uint64_t flushes;
+            uint64_t operations;
+            // batch counts are only gathered whilst frame statistics are enabled
+            uint64_t batchesBeforeReorder;
+            uint64_t batchesAfterReorder;
+            uint64_t payloadBytes;
+            uint64_t allocatedBytes;
+        };
         // construction
     public:
         opengl_renderer(neogfx::renderer aRenderer);
@@ -123,6 +134,15 @@ namespace neogfx
         void unregister_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
         uint32_t frame_counter(uint32_t aDuration) const override;
         i_texture& create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, size& aPreviousExtents, texture_sampling aSampling);
+    public:
+        bool operation_reordering_enabled() const;
+        void enable_operation_reordering(bool aEnable);
+        bool frame_statistics_enabled() const;
+        void enable_frame_statistics(bool aEnable);
+        const frame_statistics& last_frame_statistics() const;
+        void flushed(uint64_t aBatchesBeforeReorder, uint64_t aBatchesAfterReorder, const graphics_operation::queue::statistics& aQueueStatistics);
+    protected:
+        void next_frame();
     private:
         neogfx::renderer iRenderer;
         mutable std::optional<opengl_texture_manager> iTextureManager;
@@ -138,5 +158,9 @@ namespace neogfx
         mutable std::optional<ping_pong_buffers_t> iPingPongBuffer1s;
         mutable std::optional<ping_pong_buffers_t> iPingPongBuffer2s;
         ref_ptr<i_standard_shader_program> iDefaultShaderProgram;
+        bool iReorderOperations;
+        bool iCollectStatistics;
+        frame_statistics iStatistics;
+        frame_statistics iLastFrameStatistics;
     };
 }
\ No newline at end of file
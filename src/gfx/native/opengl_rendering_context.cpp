@@ -31,10 +31,12 @@
 #include <neogfx/gui/widget/i_widget.hpp>
 #include <neogfx/game/rectangle.hpp>
 #include <neogfx/game/text_mesh.hpp>
+#include <neogfx/game/ecs.hpp>
 #include <neogfx/game/ecs_helpers.hpp>
 #include <neogfx/hid/i_native_surface.hpp>
 #include "i_native_texture.hpp"
 #include "../text/native/i_native_font_face.hpp"
+#include "opengl_renderer.hpp"
 #include "opengl_rendering_context.hpp"
 
 namespace neogfx
@@ -454,6 +456,17 @@ namespace neogfx
         if (queue().empty())
             return;
 
+        auto& renderer = static_cast<opengl_renderer&>(rendering_engine());
+        // counting batches walks the whole queue so only do it when statistics are being collected
+        bool const countBatches = renderer.frame_statistics_enabled();
+        uint64_t batchesBeforeReorder = countBatches ? graphics_operation::batch_count(queue()) : 0u;
+        uint64_t batchesAfterReorder = batchesBeforeReorder;
+        if (renderer.operation_reordering_enabled())
+        {
+            graphics_operation::reorder(queue());
+            if (countBatches)
+                batchesAfterReorder = graphics_operation::batch_count(queue());
+        }
         scoped_render_target srt{ render_target() };
         set_blending_mode(blending_mode());
         apply_scissor();
@@ -601,7 +614,7 @@ namespace neogfx
                 for (auto op = opBatch.first; op != opBatch.second; ++op)
                 {
                     auto const& args = static_variant_cast<const graphics_operation::draw_path&>(*op);
-                    draw_path(args.path, args.pen);
+                    draw_path(queue().path(args.path), args.pen);
                 }
                 break;
             case graphics_operation::operation_type::DrawShape:
@@ -609,7 +622,7 @@ namespace neogfx
                 for (auto op = opBatch.first; op != opBatch.second; ++op)
                 {
                     auto const& args = static_variant_cast<const graphics_operation::draw_shape&>(*op);
-                    draw_shape(args.mesh, args.position, args.pen);
+                    draw_shape(queue().mesh(args.mesh), args.position, args.pen);
                 }
                 break;
             case graphics_operation::operation_type::DrawEntities:
@@ -648,7 +661,7 @@ namespace neogfx
                 break;
             case graphics_operation::operation_type::FillPath:
                 for (auto op = opBatch.first; op != opBatch.second; ++op)
-                    fill_path(static_variant_cast<const graphics_operation::fill_path&>(*op).path, static_variant_cast<const graphics_operation::fill_path&>(*op).fill);
+                    fill_path(queue().path(static_variant_cast<const graphics_operation::fill_path&>(*op).path), static_variant_cast<const graphics_operation::fill_path&>(*op).fill);
                 break;
             case graphics_operation::operation_type::FillShape:
                 fill_shapes(opBatch);
@@ -661,12 +674,14 @@ namespace neogfx
                 for (auto op = opBatch.first; op != opBatch.second; ++op)
                 {
                     auto const& args = static_variant_cast<const graphics_operation::draw_mesh&>(*op);
-                    draw_mesh(args.mesh, args.material, args.transformation, args.filter);
+                    draw_mesh(queue().mesh(args.mesh), args.material, args.transformation, args.filter);
                 }
                 break;
             }
         }
         queue().clear();
+
+        renderer.flushed(batchesBeforeReorder, batchesAfterReorder, queue().last_statistics());
     }
 
     void opengl_rendering_context::scissor_on(const rect& aRect)
@@ -1264,14 +1279,14 @@ namespace neogfx
             auto const& meshRenderers = aEcs.component<game::mesh_renderer>();
             auto const& meshFilters = aEcs.component<game::mesh_filter>();
             auto const& cache = aEcs.component<game::mesh_render_cache>();
+            game::live_entity_filter const live{ aEcs };
             for (auto entity : meshRenderers.entities())
             {
 #ifdef NEOGFX_DEBUG
                 if (infos.entity_record(entity).debug::layoutItem)
                     service<debug::logger>() << "Rendering debug::layoutItem entity..." << endl;
 #endif // NEOGFX_DEBUG
-                auto const& info = infos.entity_record_no_lock(entity);
-                if (info.destroyed)
+                if (!live(entity))
                     continue;
                 auto const& meshRenderer = meshRenderers.entity_record_no_lock(entity);
                 maxLayer = std::max(maxLayer, meshRenderer.layer);
@@ -1560,8 +1575,9 @@ namespace neogfx
             for (auto op = aFillShapeOps.first; op != aFillShapeOps.second; ++op)
             {
                 auto& drawOp = static_variant_cast<const graphics_operation::fill_shape&>(*op);
-                auto const& vertices = drawOp.mesh.vertices;
-                auto const& uv = drawOp.mesh.uv;
+                auto const& mesh = queue().mesh(drawOp.mesh);
+                auto const& vertices = mesh.vertices;
+                auto const& uv = mesh.uv;
                 vec3 min, max;
                 if (std::holds_alternative<gradient>(drawOp.fill))
                 {
@@ -1576,9 +1592,9 @@ namespace neogfx
                     }
                 }
                 auto const function = to_function(drawOp.fill, rect{ point{ min.x, min.y }, size{ max.x - min.x, max.y - min.y } });
-                if (!vertexArrays.room_for(drawOp.mesh.faces.size() * 3u))
+                if (!vertexArrays.room_for(mesh.faces.size() * 3u))
                     vertexArrays.draw_and_execute();
-                for (auto const& f : drawOp.mesh.faces)
+                for (auto const& f : mesh.faces)
                 {
                     for (auto vi : f)
                     {
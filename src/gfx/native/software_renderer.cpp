@@ -0,0 +1,403 @@
+// software_renderer.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/hid/i_surface_manager.hpp>
+#include <neogfx/gui/widget/i_widget.hpp>
+#include "software_renderer.hpp"
+
+namespace neogfx
+{
+    software_renderer::software_renderer() :
+        iLimitFrameRate{ false },
+        iFrameRateLimit{ 60u },
+        iSubpixelRendering{ false },
+        iStatistics{}
+    {
+    }
+
+    software_renderer::~software_renderer()
+    {
+        cleanup();
+    }
+
+    const i_device_metrics& software_renderer::default_screen_metrics() const
+    {
+        return iScreenMetrics;
+    }
+
+    renderer software_renderer::renderer() const
+    {
+        return neogfx::renderer::Software;
+    }
+
+    bool software_renderer::double_buffering() const
+    {
+        return false;
+    }
+
+    bool software_renderer::vsync_enabled() const
+    {
+        return false;
+    }
+
+    void software_renderer::enable_vsync()
+    {
+        // nothing to synchronize with
+    }
+
+    void software_renderer::disable_vsync()
+    {
+        // nothing to synchronize with
+    }
+
+    void software_renderer::initialize()
+    {
+        service<debug::logger>() << "Software renderer: headless, CPU rasteriser" << endl;
+    }
+
+    void software_renderer::cleanup()
+    {
+        iFontManager = std::nullopt;
+        iPingPongBuffer1s = std::nullopt;
+        iPingPongBuffer2s = std::nullopt;
+        iTextureManager = std::nullopt;
+        iShaderPrograms.clear();
+    }
+
+    pixel_format_t software_renderer::set_pixel_format(const i_render_target&)
+    {
+        return 0;
+    }
+
+    const i_render_target* software_renderer::active_target() const
+    {
+        if (iTargetStack.empty())
+            return nullptr;
+        return iTargetStack.back();
+    }
+
+    void software_renderer::activate_context(const i_render_target& aTarget)
+    {
+        iTargetStack.push_back(&aTarget);
+    }
+
+    void software_renderer::deactivate_context()
+    {
+        if (iTargetStack.empty())
+            throw no_target_active();
+        iTargetStack.pop_back();
+    }
+
+    software_renderer::handle software_renderer::create_context(const i_render_target& aTarget)
+    {
+        return const_cast<i_render_target*>(&aTarget);
+    }
+
+    void software_renderer::destroy_context(handle)
+    {
+    }
+
+    const software_renderer::shader_program_list& software_renderer::shader_programs() const
+    {
+        return iShaderPrograms;
+    }
+
+    const i_shader_program& software_renderer::shader_program(const neolib::i_string& aName) const
+    {
+        for (auto const& s : shader_programs())
+            if (s->name() == aName)
+                return *s;
+        throw shader_program_not_found();
+    }
+
+    i_shader_program& software_renderer::shader_program(const neolib::i_string& aName)
+    {
+        return const_cast<i_shader_program&>(to_const(*this).shader_program(aName));
+    }
+
+    i_shader_program& software_renderer::add_shader_program(const neolib::i_ref_ptr<i_shader_program>& aShaderProgram)
+    {
+        iShaderPrograms.push_back(aShaderProgram);
+        return *aShaderProgram;
+    }
+
+    bool software_renderer::is_shader_program_active() const
+    {
+        return false;
+    }
+
+    i_shader_program& software_renderer::active_shader_program()
+    {
+        throw no_shader_program_active();
+    }
+
+    const i_standard_shader_program& software_renderer::default_shader_program() const
+    {
+        throw no_shader_support();
+    }
+
+    i_standard_shader_program& software_renderer::default_shader_program()
+    {
+        throw no_shader_support();
+    }
+
+    software_renderer::handle software_renderer::create_shader_program_object()
+    {
+        throw no_shader_support();
+    }
+
+    void software_renderer::destroy_shader_program_object(handle)
+    {
+        throw no_shader_support();
+    }
+
+    software_renderer::handle software_renderer::create_shader_object(shader_type)
+    {
+        throw no_shader_support();
+    }
+
+    void software_renderer::destroy_shader_object(handle)
+    {
+        throw no_shader_support();
+    }
+
+    void software_renderer::create_window(i_surface_manager&, i_surface_window&, const video_mode&, std::string const&, window_style, i_ref_ptr<i_native_window>&)
+    {
+        throw headless();
+    }
+
+    void software_renderer::create_window(i_surface_manager&, i_surface_window&, const size&, std::string const&, window_style, i_ref_ptr<i_native_window>&)
+    {
+        throw headless();
+    }
+
+    void software_renderer::create_window(i_surface_manager&, i_surface_window&, const point&, const size&, std::string const&, window_style, i_ref_ptr<i_native_window>&)
+    {
+        throw headless();
+    }
+
+    void software_renderer::create_window(i_surface_manager&, i_surface_window&, i_native_surface&, const video_mode&, std::string const&, window_style, i_ref_ptr<i_native_window>&)
+    {
+        throw headless();
+    }
+
+    void software_renderer::create_window(i_surface_manager&, i_surface_window&, i_native_surface&, const size&, std::string const&, window_style, i_ref_ptr<i_native_window>&)
+    {
+        throw headless();
+    }
+
+    void software_renderer::create_window(i_surface_manager&, i_surface_window&, i_native_surface&, const point&, const size&, std::string const&, window_style, i_ref_ptr<i_native_window>&)
+    {
+        throw headless();
+    }
+
+    bool software_renderer::creating_window() const
+    {
+        return false;
+    }
+
+    i_font_manager& software_renderer::font_manager()
+    {
+        if (iFontManager == std::nullopt)
+            iFontManager.emplace();
+        return *iFontManager;
+    }
+
+    i_texture_manager& software_renderer::texture_manager()
+    {
+        if (iTextureManager == std::nullopt)
+            iTextureManager.emplace();
+        return *iTextureManager;
+    }
+
+    bool software_renderer::vertex_buffer_allocated(i_vertex_provider&) const
+    {
+        return false;
+    }
+
+    i_vertex_buffer& software_renderer::allocate_vertex_buffer(i_vertex_provider&, vertex_buffer_type)
+    {
+        throw no_vertex_buffer_support();
+    }
+
+    void software_renderer::deallocate_vertex_buffer(i_vertex_provider&)
+    {
+    }
+
+    const i_vertex_buffer& software_renderer::vertex_buffer(i_vertex_provider&) const
+    {
+        throw no_vertex_buffer_support();
+    }
+
+    i_vertex_buffer& software_renderer::vertex_buffer(i_vertex_provider&)
+    {
+        throw no_vertex_buffer_support();
+    }
+
+    void software_renderer::execute_vertex_buffers()
+    {
+    }
+
+    i_texture& software_renderer::ping_pong_buffer1(const size& aExtents, size& aPreviousExtents, texture_sampling aSampling)
+    {
+        if (!iPingPongBuffer1s)
+            iPingPongBuffer1s.emplace();
+        return create_ping_pong_buffer(*iPingPongBuffer1s, aExtents, aPreviousExtents, aSampling);
+    }
+
+    i_texture& software_renderer::ping_pong_buffer2(const size& aExtents, size& aPreviousExtents, texture_sampling aSampling)
+    {
+        if (!iPingPongBuffer2s)
+            iPingPongBuffer2s.emplace();
+        return create_ping_pong_buffer(*iPingPongBuffer2s, aExtents, aPreviousExtents, aSampling);
+    }
+
+    bool software_renderer::is_subpixel_rendering_on() const
+    {
+        return iSubpixelRendering;
+    }
+
+    void software_renderer::subpixel_rendering_on()
+    {
+        if (!iSubpixelRendering)
+        {
+            iSubpixelRendering = true;
+            SubpixelRenderingChanged.trigger();
+        }
+    }
+
+    void software_renderer::subpixel_rendering_off()
+    {
+        if (iSubpixelRendering)
+        {
+            iSubpixelRendering = false;
+            SubpixelRenderingChanged.trigger();
+        }
+    }
+
+    void software_renderer::render_now()
+    {
+        auto const startTime = std::chrono::steady_clock::now();
+        service<i_surface_manager>().render_surfaces();
+        for (auto& frameCounter : iFrameCounters)
+        {
+            ++frameCounter.second.first;
+            for (auto w : frameCounter.second.second)
+                w->update();
+        }
+        ++iStatistics.frames;
+        iStatistics.lastFrameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime);
+    }
+
+    bool software_renderer::frame_rate_limited() const
+    {
+        return iLimitFrameRate;
+    }
+
+    void software_renderer::enable_frame_rate_limiter(bool aEnable)
+    {
+        iLimitFrameRate = aEnable;
+    }
+
+    uint32_t software_renderer::frame_rate_limit() const
+    {
+        return iFrameRateLimit;
+    }
+
+    void software_renderer::set_frame_rate_limit(uint32_t aFps)
+    {
+        iFrameRateLimit = aFps;
+    }
+
+    bool software_renderer::use_rendering_priority() const
+    {
+        return false;
+    }
+
+    bool software_renderer::process_events()
+    {
+        // no native surfaces so no native events
+        return false;
+    }
+
+    void software_renderer::register_frame_counter(i_widget& aWidget, uint32_t aDuration)
+    {
+        // Headless frame counters advance once per rendered frame rather than on a wall-clock timer
+        // so that benchmark runs are reproducible.
+        iFrameCounters[aDuration].second.push_back(&aWidget);
+    }
+
+    void software_renderer::unregister_frame_counter(i_widget& aWidget, uint32_t aDuration)
+    {
+        auto iterFrameCounter = iFrameCounters.find(aDuration);
+        if (iterFrameCounter != iFrameCounters.end())
+        {
+            auto& widgets = iterFrameCounter->second.second;
+            auto existing = std::find(widgets.begin(), widgets.end(), &aWidget);
+            if (existing != widgets.end())
+                widgets.erase(existing);
+        }
+    }
+
+    uint32_t software_renderer::frame_counter(uint32_t aDuration) const
+    {
+        auto iterFrameCounter = iFrameCounters.find(aDuration);
+        if (iterFrameCounter != iFrameCounters.end())
+            return iterFrameCounter->second.first;
+        return 0;
+    }
+
+    const software_renderer::frame_statistics& software_renderer::statistics() const
+    {
+        return iStatistics;
+    }
+
+    void software_renderer::reset_statistics()
+    {
+        iStatistics = {};
+    }
+
+    void software_renderer::flushed(const graphics_operation::queue::statistics& aQueueStatistics, uint64_t aUnsupportedOperations, std::chrono::nanoseconds aRasterTime)
+    {
+        ++iStatistics.flushes;
+        iStatistics.operations += aQueueStatistics.operations;
+        iStatistics.unsupportedOperations += aUnsupportedOperations;
+        iStatistics.payloadBytes += aQueueStatistics.payloadBytes;
+        iStatistics.allocatedBytes += aQueueStatistics.allocatedBytes;
+        iStatistics.rasterTime += aRasterTime;
+    }
+
+    i_texture& software_renderer::create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, size& aPreviousExtents, texture_sampling aSampling)
+    {
+        auto existing = aBufferList.lower_bound(std::make_pair(aSampling, aExtents));
+        if (existing != aBufferList.end() && existing->first.first == aSampling && existing->first.second >= aExtents)
+        {
+            aPreviousExtents = existing->second.second;
+            existing->second.second = aExtents;
+            return existing->second.first;
+        }
+        auto const sizeMultiple = 1024;
+        basic_size<int32_t> idealSize{ (((static_cast<int32_t>(aExtents.cx) - 1) / sizeMultiple) + 1) * sizeMultiple, (((static_cast<int32_t>(aExtents.cy) - 1) / sizeMultiple) + 1) * sizeMultiple };
+        auto newBuffer = aBufferList.emplace(std::make_pair(aSampling, idealSize), std::make_pair(texture{ idealSize, 1.0, aSampling }, aExtents)).first;
+        newBuffer->second.second = aExtents;
+        aPreviousExtents = idealSize;
+        return newBuffer->second.first;
+    }
+}
\ No newline at end of file
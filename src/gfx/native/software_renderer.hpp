@@ -0,0 +1,165 @@
+// software_renderer.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <map>
+#include <chrono>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/graphics_operations.hpp>
+#include <neogfx/gfx/text/font_manager.hpp>
+#include <neogfx/gfx/texture.hpp>
+#include "software_texture_manager.hpp"
+
+namespace neogfx
+{
+    // Headless rendering engine: render targets are in-memory RGBA textures rasterised on the CPU
+    // by software_rendering_context so widgets can be laid out, painted and timed without a GPU
+    // or a display. There are no native windows, shader programs or vertex buffers.
+    class software_renderer : public i_rendering_engine
+    {
+        // events
+    public:
+        define_declared_event(SubpixelRenderingChanged, subpixel_rendering_changed)
+        // exceptions
+    public:
+        struct headless : std::logic_error { headless() : std::logic_error("neogfx::software_renderer::headless") {} };
+        struct no_shader_support : std::logic_error { no_shader_support() : std::logic_error("neogfx::software_renderer::no_shader_support") {} };
+        struct no_vertex_buffer_support : std::logic_error { no_vertex_buffer_support() : std::logic_error("neogfx::software_renderer::no_vertex_buffer_support") {} };
+        struct no_target_active : std::logic_error { no_target_active() : std::logic_error("neogfx::software_renderer::no_target_active") {} };
+        // types
+    public:
+        typedef neolib::vector<neolib::ref_ptr<i_shader_program>> shader_program_list;
+        typedef std::map<std::pair<texture_sampling, size>, std::pair<texture, size>> ping_pong_buffers_t;
+        struct frame_statistics
+        {
+            uint64_t frames;
+            uint64_t flushes;
+            uint64_t operations;
+            uint64_t unsupportedOperations;
+            uint64_t payloadBytes;
+            uint64_t allocatedBytes;
+            std::chrono::nanoseconds rasterTime;
+            std::chrono::nanoseconds lastFrameTime;
+        };
+    private:
+        class screen_metrics : public i_device_metrics
+        {
+        public:
+            dimension horizontal_dpi() const override { return 96.0; }
+            dimension vertical_dpi() const override { return 96.0; }
+            dimension ppi() const override { return 96.0; }
+            bool metrics_available() const override { return true; }
+            size extents() const override { return size{ 1920.0, 1080.0 }; }
+            dimension em_size() const override { return 0.0; }
+        };
+        // construction
+    public:
+        software_renderer();
+        ~software_renderer();
+    public:
+        const i_device_metrics& default_screen_metrics() const override;
+    public:
+        neogfx::renderer renderer() const override;
+        bool double_buffering() const override;
+        bool vsync_enabled() const override;
+        void enable_vsync() override;
+        void disable_vsync() override;
+        void initialize() override;
+        void cleanup() override;
+        pixel_format_t set_pixel_format(const i_render_target& aTarget) override;
+        const i_render_target* active_target() const override;
+        void activate_context(const i_render_target& aTarget) override;
+        void deactivate_context() override;
+        handle create_context(const i_render_target& aTarget) override;
+        void destroy_context(handle aContext) override;
+    public:
+        const shader_program_list& shader_programs() const override;
+        const i_shader_program& shader_program(const neolib::i_string& aName) const override;
+        i_shader_program& shader_program(const neolib::i_string& aName) override;
+        i_shader_program& add_shader_program(const neolib::i_ref_ptr<i_shader_program>& aShaderProgram) override;
+        bool is_shader_program_active() const override;
+        i_shader_program& active_shader_program() override;
+    public:
+        const i_standard_shader_program& default_shader_program() const override;
+        i_standard_shader_program& default_shader_program() override;
+    public:
+        handle create_shader_program_object() override;
+        void destroy_shader_program_object(handle aShaderProgramObject) override;
+        handle create_shader_object(shader_type aShaderType) override;
+        void destroy_shader_object(handle aShaderObject) override;
+    public:
+        void create_window(i_surface_manager& aSurfaceManager, i_surface_window& aWindow, const video_mode& aVideoMode, std::string const& aWindowTitle, window_style aStyle, i_ref_ptr<i_native_window>& aResult) override;
+        void create_window(i_surface_manager& aSurfaceManager, i_surface_window& aWindow, const size& aDimensions, std::string const& aWindowTitle, window_style aStyle, i_ref_ptr<i_native_window>& aResult) override;
+        void create_window(i_surface_manager& aSurfaceManager, i_surface_window& aWindow, const point& aPosition, const size& aDimensions, std::string const& aWindowTitle, window_style aStyle, i_ref_ptr<i_native_window>& aResult) override;
+        void create_window(i_surface_manager& aSurfaceManager, i_surface_window& aWindow, i_native_surface& aParent, const video_mode& aVideoMode, std::string const& aWindowTitle, window_style aStyle, i_ref_ptr<i_native_window>& aResult) override;
+        void create_window(i_surface_manager& aSurfaceManager, i_surface_window& aWindow, i_native_surface& aParent, const size& aDimensions, std::string const& aWindowTitle, window_style aStyle, i_ref_ptr<i_native_window>& aResult) override;
+        void create_window(i_surface_manager& aSurfaceManager, i_surface_window& aWindow, i_native_surface& aParent, const point& aPosition, const size& aDimensions, std::string const& aWindowTitle, window_style aStyle, i_ref_ptr<i_native_window>& aResult) override;
+        bool creating_window() const override;
+        i_font_manager& font_manager() override;
+        i_texture_manager& texture_manager() override;
+    public:
+        bool vertex_buffer_allocated(i_vertex_provider& aProvider) const override;
+        i_vertex_buffer& allocate_vertex_buffer(i_vertex_provider& aProvider, vertex_buffer_type aType = vertex_buffer_type::Default) override;
+        void deallocate_vertex_buffer(i_vertex_provider& aProvider) override;
+        const i_vertex_buffer& vertex_buffer(i_vertex_provider& aProvider) const override;
+        i_vertex_buffer& vertex_buffer(i_vertex_provider& aProvider) override;
+        void execute_vertex_buffers() override;
+    public:
+        i_texture& ping_pong_buffer1(const size& aExtents, size& aPreviousExtents, texture_sampling aSampling = texture_sampling::Multisample) override;
+        i_texture& ping_pong_buffer2(const size& aExtents, size& aPreviousExtents, texture_sampling aSampling = texture_sampling::Multisample) override;
+    public:
+        bool is_subpixel_rendering_on() const override;
+        void subpixel_rendering_on() override;
+        void subpixel_rendering_off() override;
+    public:
+        void render_now() override;
+        bool frame_rate_limited() const override;
+        void enable_frame_rate_limiter(bool aEnable) override;
+        uint32_t frame_rate_limit() const override;
+        void set_frame_rate_limit(uint32_t aFps) override;
+        bool use_rendering_priority() const override;
+    public:
+        bool process_events() override;
+    public:
+        void register_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
+        void unregister_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
+        uint32_t frame_counter(uint32_t aDuration) const override;
+    public:
+        const frame_statistics& statistics() const;
+        void reset_statistics();
+        void flushed(const graphics_operation::queue::statistics& aQueueStatistics, uint64_t aUnsupportedOperations, std::chrono::nanoseconds aRasterTime);
+    private:
+        i_texture& create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, size& aPreviousExtents, texture_sampling aSampling);
+    private:
+        screen_metrics iScreenMetrics;
+        mutable std::optional<software_texture_manager> iTextureManager;
+        mutable std::optional<neogfx::font_manager> iFontManager;
+        shader_program_list iShaderPrograms;
+        bool iLimitFrameRate;
+        uint32_t iFrameRateLimit;
+        bool iSubpixelRendering;
+        std::vector<const i_render_target*> iTargetStack;
+        std::map<uint32_t, std::pair<uint32_t, std::vector<i_widget*>>> iFrameCounters;
+        mutable std::optional<ping_pong_buffers_t> iPingPongBuffer1s;
+        mutable std::optional<ping_pong_buffers_t> iPingPongBuffer2s;
+        frame_statistics iStatistics;
+    };
+}
\ No newline at end of file
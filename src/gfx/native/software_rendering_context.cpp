@@ -0,0 +1,1505 @@
+// software_rendering_context.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <chrono>
+#include <boost/math/constants/constants.hpp>
+#include <neolib/core/thread_local.hpp>
+#include <neogfx/app/i_basic_services.hpp>
+#include <neogfx/hid/i_native_surface.hpp>
+#include <neogfx/gfx/i_texture_manager.hpp>
+#include <neogfx/gfx/i_gradient_manager.hpp>
+#include <neogfx/gfx/text/glyph.hpp>
+#include <neogfx/gfx/text/i_emoji_atlas.hpp>
+#include <neogfx/gfx/text/i_glyph_texture.hpp>
+#include <neogfx/gfx/shapes.hpp>
+#include "../text/native/i_native_font_face.hpp"
+#include "software_renderer.hpp"
+#include "software_texture.hpp"
+#include "software_rendering_context.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        inline vec4f to_vec4f(const color& aColor, double aOpacity)
+        {
+            return vec4f{ aColor.red<float>(), aColor.green<float>(), aColor.blue<float>(), aColor.alpha<float>() * static_cast<float>(aOpacity) };
+        }
+
+        inline uint8_t to_component(float aValue)
+        {
+            return static_cast<uint8_t>(std::max(0.0f, std::min(1.0f, aValue)) * 255.0f + 0.5f);
+        }
+
+        inline vec4f to_vec4f(const avec4u8& aTexel)
+        {
+            return vec4f{ aTexel[0] / 255.0f, aTexel[1] / 255.0f, aTexel[2] / 255.0f, aTexel[3] / 255.0f };
+        }
+
+        // Same blend functions as opengl_rendering_context::set_blending_mode and the XOR logic op
+        inline void blend(avec4u8& aDestination, const vec4f& aSource, blending_mode aBlendingMode, bool aXor)
+        {
+            if (aXor)
+            {
+                for (std::size_t c = 0; c < 4; ++c)
+                    aDestination[c] ^= to_component(aSource[c]);
+                return;
+            }
+            switch (aBlendingMode)
+            {
+            case blending_mode::None:
+                for (std::size_t c = 0; c < 4; ++c)
+                    aDestination[c] = to_component(aSource[c]);
+                break;
+            case blending_mode::Blit:
+                for (std::size_t c = 0; c < 4; ++c)
+                    aDestination[c] = to_component(aSource[c] + aDestination[c] / 255.0f * (1.0f - aSource[3]));
+                break;
+            case blending_mode::Default:
+                for (std::size_t c = 0; c < 4; ++c)
+                    aDestination[c] = to_component(aSource[c] * aSource[3] + aDestination[c] / 255.0f * (1.0f - aSource[3]));
+                break;
+            }
+        }
+
+        // Mirrors standard_texture_shader (texel conversion and effects) and, for shader_effect::Ignore,
+        // standard_glyph_shader with no subpixel format (render targets are textures).
+        inline vec4f shade(const vec4f& aColor, const avec4u8& aTexel, texture_data_format aDataFormat, shader_effect aEffect)
+        {
+            if (aEffect == shader_effect::Ignore)
+            {
+                float const coverage = (aDataFormat == texture_data_format::SubPixel ?
+                    (aTexel[0] + aTexel[1] + aTexel[2]) / (3.0f * 255.0f) : aTexel[0] / 255.0f);
+                return vec4f{ aColor[0], aColor[1], aColor[2], aColor[3] * coverage };
+            }
+            auto texel = to_vec4f(aTexel);
+            if (aDataFormat == texture_data_format::Red)
+                texel = vec4f{ 1.0f, 1.0f, 1.0f, texel[0] };
+            else if (aDataFormat == texture_data_format::SubPixel)
+                texel = vec4f{ 1.0f, 1.0f, 1.0f, (texel[0] + texel[1] + texel[2]) / 3.0f };
+            switch (aEffect)
+            {
+            case shader_effect::None:
+            default:
+                break;
+            case shader_effect::Colorize:
+                {
+                    float const average = (texel[0] + texel[1] + texel[2]) / 3.0f;
+                    texel = vec4f{ average, average, average, texel[3] };
+                }
+                break;
+            case shader_effect::ColorizeMaximum:
+                {
+                    float const maxChannel = std::max(texel[0], std::max(texel[1], texel[2]));
+                    texel = vec4f{ maxChannel, maxChannel, maxChannel, texel[3] };
+                }
+                break;
+            case shader_effect::ColorizeSpot:
+                texel = vec4f{ 1.0f, 1.0f, 1.0f, texel[3] };
+                break;
+            case shader_effect::ColorizeAlpha:
+                texel = vec4f{ 1.0f, 1.0f, 1.0f, texel[3] * (texel[0] + texel[1] + texel[2]) / 3.0f };
+                break;
+            case shader_effect::Monochrome:
+                {
+                    float const gray = aColor[0] * texel[0] * 0.299f + aColor[1] * texel[1] * 0.587f + aColor[2] * texel[2] * 0.114f;
+                    texel = vec4f{ gray, gray, gray, texel[3] };
+                }
+                break;
+            }
+            return vec4f{ texel[0] * aColor[0], texel[1] * aColor[1], texel[2] * aColor[2], texel[3] * aColor[3] };
+        }
+
+        inline void add_segment_quad(std::vector<std::vector<vec2>>& aContours, const vec2& aFrom, const vec2& aTo, scalar aWidth)
+        {
+            auto const delta = aTo - aFrom;
+            auto const length = delta.magnitude();
+            if (length == 0.0)
+                return;
+            auto const normal = vec2{ -delta.y, delta.x } * (aWidth / 2.0 / length);
+            aContours.push_back({ aFrom + normal, aTo + normal, aTo - normal, aFrom - normal });
+        }
+
+        inline vec2 bezier_point(const vec2& aP0, const vec2& aP1, const vec2& aP2, const vec2& aP3, scalar aT)
+        {
+            scalar const u = 1.0 - aT;
+            return aP0 * (u * u * u) + aP1 * (3.0 * u * u * aT) + aP2 * (3.0 * u * aT * aT) + aP3 * (aT * aT * aT);
+        }
+    }
+
+    // A colour source for spans: a solid colour or a gradient evaluated through a lookup table.
+    class software_rendering_context::paint
+    {
+    private:
+        static constexpr std::size_t LookupTableSize = 256u;
+    public:
+        paint(const vec4f& aColor) :
+            iContext{ nullptr }, iColor{ aColor }
+        {
+        }
+        paint(const software_rendering_context& aContext, const gradient& aGradient, const rect& aBoundingRect, double aOpacity) :
+            iContext{ &aContext },
+            iDirection{ aGradient.direction() },
+            iBoundingRect{ aGradient.bounding_box() != std::nullopt ? *aGradient.bounding_box() : aBoundingRect }
+        {
+            iLookupTable.reserve(LookupTableSize);
+            for (std::size_t i = 0; i < LookupTableSize; ++i)
+                iLookupTable.push_back(to_vec4f(aGradient.at(static_cast<scalar>(i) / (LookupTableSize - 1u)), aOpacity));
+            if (iDirection == gradient_direction::Diagonal)
+            {
+                if (std::holds_alternative<corner>(aGradient.orientation()))
+                {
+                    switch (static_variant_cast<corner>(aGradient.orientation()))
+                    {
+                    case corner::TopLeft:
+                        iDiagonal = vec4{ 0.0, 0.0, 0.5, 0.5 };
+                        break;
+                    case corner::TopRight:
+                        iDiagonal = vec4{ 1.0, 0.0, -0.5, 0.5 };
+                        break;
+                    case corner::BottomRight:
+                        iDiagonal = vec4{ 1.0, 1.0, -0.5, -0.5 };
+                        break;
+                    case corner::BottomLeft:
+                        iDiagonal = vec4{ 0.0, 1.0, 0.5, -0.5 };
+                        break;
+                    }
+                }
+                else
+                {
+                    auto const angle = static_variant_cast<scalar>(aGradient.orientation());
+                    vec2 const axis{ std::cos(angle), -std::sin(angle) };
+                    auto const extent = std::abs(axis.x) + std::abs(axis.y);
+                    iDiagonal = vec4{ 0.5 - axis.x / extent, 0.5 - axis.y / extent, axis.x / extent, axis.y / extent };
+                }
+            }
+        }
+    public:
+        static paint from(const software_rendering_context& aContext, const brush& aBrush, const rect& aBoundingRect, double aOpacity)
+        {
+            if (std::holds_alternative<color>(aBrush))
+                return paint{ to_vec4f(static_variant_cast<const color&>(aBrush), aOpacity) };
+            else if (std::holds_alternative<gradient>(aBrush))
+                return paint{ aContext, static_variant_cast<const gradient&>(aBrush), aBoundingRect, aOpacity };
+            // texture brushes are not sampled by the OpenGL backend's colour/gradient path either
+            return paint{ vec4f{} };
+        }
+        static paint from(const software_rendering_context& aContext, const color_or_gradient& aColor, const rect& aBoundingRect, double aOpacity)
+        {
+            if (std::holds_alternative<color>(aColor))
+                return paint{ to_vec4f(static_variant_cast<const color&>(aColor), aOpacity) };
+            else if (std::holds_alternative<gradient>(aColor))
+                return paint{ aContext, static_variant_cast<const gradient&>(aColor), aBoundingRect, aOpacity };
+            return paint{ vec4f{} };
+        }
+    public:
+        bool solid() const
+        {
+            return iContext == nullptr;
+        }
+        const vec4f& color() const
+        {
+            return iColor;
+        }
+        const vec4f& at(int32_t aX, int32_t aY) const
+        {
+            if (solid())
+                return iColor;
+            auto const position = iContext->from_target(vec2{ aX + 0.5, aY + 0.5 });
+            vec2 const relative{
+                iBoundingRect.cx != 0.0 ? (position.x - iBoundingRect.x) / iBoundingRect.cx : 0.0,
+                iBoundingRect.cy != 0.0 ? (position.y - iBoundingRect.y) / iBoundingRect.cy : 0.0 };
+            scalar t = 0.0;
+            switch (iDirection)
+            {
+            case gradient_direction::Vertical:
+                t = relative.y;
+                break;
+            case gradient_direction::Horizontal:
+                t = relative.x;
+                break;
+            case gradient_direction::Diagonal:
+                t = (relative.x - iDiagonal[0]) * iDiagonal[2] + (relative.y - iDiagonal[1]) * iDiagonal[3];
+                break;
+            case gradient_direction::Rectangular:
+                t = std::max(std::abs(relative.x - 0.5), std::abs(relative.y - 0.5)) * 2.0;
+                break;
+            case gradient_direction::Radial:
+                t = (relative - vec2{ 0.5, 0.5 }).magnitude() * 2.0;
+                break;
+            }
+            t = std::max(0.0, std::min(1.0, t));
+            return iLookupTable[static_cast<std::size_t>(t * (LookupTableSize - 1u) + 0.5)];
+        }
+    private:
+        const software_rendering_context* iContext;
+        vec4f iColor;
+        gradient_direction iDirection = gradient_direction::Vertical;
+        rect iBoundingRect;
+        vec4 iDiagonal;
+        std::vector<vec4f> iLookupTable;
+    };
+
+    software_rendering_context::software_rendering_context(const i_render_target& aTarget, neogfx::blending_mode aBlendingMode) :
+        iRenderingEngine{ service<i_rendering_engine>() },
+        iTarget{ aTarget },
+        iInFlush{ false },
+        iOpacity{ 1.0 },
+        iSubpixelRendering{ rendering_engine().is_subpixel_rendering_on() },
+        iSnapToPixel{ false },
+        iScale{ 1.0, 1.0 },
+        iUnsupportedOperations{ 0u }
+    {
+        set_blending_mode(aBlendingMode);
+        set_smoothing_mode(neogfx::smoothing_mode::AntiAlias);
+        iSink += render_target().target_deactivating([&]()
+        {
+            flush();
+        });
+    }
+
+    software_rendering_context::software_rendering_context(const software_rendering_context& aOther) :
+        iRenderingEngine{ aOther.iRenderingEngine },
+        iTarget{ aOther.iTarget },
+        iInFlush{ false },
+        iLogicalCoordinateSystem{ aOther.iLogicalCoordinateSystem },
+        iLogicalCoordinates{ aOther.iLogicalCoordinates },
+        iOpacity{ 1.0 },
+        iSubpixelRendering{ aOther.iSubpixelRendering },
+        iSnapToPixel{ false },
+        iScale{ 1.0, 1.0 },
+        iUnsupportedOperations{ 0u }
+    {
+        set_blending_mode(aOther.blending_mode());
+        set_smoothing_mode(aOther.smoothing_mode());
+        iSink += render_target().target_deactivating([&]()
+        {
+            flush();
+        });
+    }
+
+    software_rendering_context::~software_rendering_context()
+    {
+    }
+
+    std::unique_ptr<i_rendering_context> software_rendering_context::clone() const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context(*this));
+    }
+
+    i_rendering_engine& software_rendering_context::rendering_engine() const
+    {
+        return iRenderingEngine;
+    }
+
+    const i_render_target& software_rendering_context::render_target() const
+    {
+        return iTarget;
+    }
+
+    rect software_rendering_context::rendering_area(bool aConsiderScissor) const
+    {
+        if (scissor_rect() == std::nullopt || !aConsiderScissor)
+            return rect{ point{}, render_target().target_extents() };
+        else
+            return *scissor_rect();
+    }
+
+    const graphics_operation::queue& software_rendering_context::queue() const
+    {
+        return iQueue;
+    }
+
+    graphics_operation::queue& software_rendering_context::queue()
+    {
+        return const_cast<graphics_operation::queue&>(to_const(*this).queue());
+    }
+
+    void software_rendering_context::enqueue(const graphics_operation::operation& aOperation)
+    {
+        queue().push_back(aOperation);
+    }
+
+    void software_rendering_context::flush()
+    {
+        if (iInFlush)
+            return;
+
+        neolib::scoped_flag sf{ iInFlush };
+
+        if (queue().empty())
+            return;
+
+        auto const startTime = std::chrono::steady_clock::now();
+
+        scoped_render_target srt{ render_target() };
+        update_transformation();
+        iClipRect = std::nullopt;
+        iUnsupportedOperations = 0u;
+
+        for (auto const& op : queue())
+        {
+            switch (op.index())
+            {
+            case graphics_operation::operation_type::SetLogicalCoordinateSystem:
+                set_logical_coordinate_system(static_variant_cast<const graphics_operation::set_logical_coordinate_system&>(op).system);
+                break;
+            case graphics_operation::operation_type::SetLogicalCoordinates:
+                set_logical_coordinates(static_variant_cast<const graphics_operation::set_logical_coordinates&>(op).coordinates);
+                break;
+            case graphics_operation::operation_type::SetOrigin:
+                set_origin(static_variant_cast<const graphics_operation::set_origin&>(op).origin);
+                break;
+            case graphics_operation::operation_type::ScissorOn:
+                scissor_on(static_variant_cast<const graphics_operation::scissor_on&>(op).rect);
+                break;
+            case graphics_operation::operation_type::ScissorOff:
+                scissor_off();
+                break;
+            case graphics_operation::operation_type::SnapToPixelOn:
+                set_snap_to_pixel(true);
+                break;
+            case graphics_operation::operation_type::SnapToPixelOff:
+                set_snap_to_pixel(false);
+                break;
+            case graphics_operation::operation_type::SetOpacity:
+                set_opacity(static_variant_cast<const graphics_operation::set_opacity&>(op).opacity);
+                break;
+            case graphics_operation::operation_type::SetBlendingMode:
+                set_blending_mode(static_variant_cast<const graphics_operation::set_blending_mode&>(op).blendingMode);
+                break;
+            case graphics_operation::operation_type::SetSmoothingMode:
+                set_smoothing_mode(static_variant_cast<const graphics_operation::set_smoothing_mode&>(op).smoothingMode);
+                break;
+            case graphics_operation::operation_type::PushLogicalOperation:
+                push_logical_operation(static_variant_cast<const graphics_operation::push_logical_operation&>(op).logicalOperation);
+                break;
+            case graphics_operation::operation_type::PopLogicalOperation:
+                pop_logical_operation();
+                break;
+            case graphics_operation::operation_type::LineStippleOn:
+                // stipple is a shader feature; lines are drawn solid
+                ++iUnsupportedOperations;
+                break;
+            case graphics_operation::operation_type::LineStippleOff:
+                break;
+            case graphics_operation::operation_type::SubpixelRenderingOn:
+                subpixel_rendering_on();
+                break;
+            case graphics_operation::operation_type::SubpixelRenderingOff:
+                subpixel_rendering_off();
+                break;
+            case graphics_operation::operation_type::Clear:
+                clear(static_variant_cast<const graphics_operation::clear&>(op).color);
+                break;
+            case graphics_operation::operation_type::ClearDepthBuffer:
+            case graphics_operation::operation_type::ClearStencilBuffer:
+                // no depth or stencil buffers
+                break;
+            case graphics_operation::operation_type::SetGradient:
+                set_gradient(static_variant_cast<const graphics_operation::set_gradient&>(op).gradient);
+                break;
+            case graphics_operation::operation_type::ClearGradient:
+                clear_gradient();
+                break;
+            case graphics_operation::operation_type::SetPixel:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::set_pixel&>(op);
+                    set_pixel(args.point, args.color);
+                }
+                break;
+            case graphics_operation::operation_type::DrawPixel:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_pixel&>(op);
+                    draw_pixel(args.point, args.color);
+                }
+                break;
+            case graphics_operation::operation_type::DrawLine:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_line&>(op);
+                    draw_line(args.from, args.to, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_rect&>(op);
+                    draw_rect(args.rect, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawRoundedRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_rounded_rect&>(op);
+                    draw_rounded_rect(args.rect, args.radius, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawCircle:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_circle&>(op);
+                    draw_circle(args.center, args.radius, args.pen, args.startAngle);
+                }
+                break;
+            case graphics_operation::operation_type::DrawArc:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_arc&>(op);
+                    draw_arc(args.center, args.radius, args.startAngle, args.endAngle, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawCubicBezier:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_cubic_bezier&>(op);
+                    draw_cubic_bezier(args.p0, args.p1, args.p2, args.p3, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawPath:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_path&>(op);
+                    draw_path(queue().path(args.path), args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawShape:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_shape&>(op);
+                    draw_shape(queue().mesh(args.mesh), args.position, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawEntities:
+                // entity rendering requires vertex buffers
+                ++iUnsupportedOperations;
+                break;
+            case graphics_operation::operation_type::FillRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_rect&>(op);
+                    fill_rect(args.rect, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillRoundedRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_rounded_rect&>(op);
+                    fill_rounded_rect(args.rect, args.radius, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillCheckerRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_checker_rect&>(op);
+                    fill_checker_rect(args.rect, args.squareSize, args.fill1, args.fill2);
+                }
+                break;
+            case graphics_operation::operation_type::FillCircle:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_circle&>(op);
+                    fill_circle(args.center, args.radius, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillArc:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_arc&>(op);
+                    fill_arc(args.center, args.radius, args.startAngle, args.endAngle, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillPath:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_path&>(op);
+                    fill_path(queue().path(args.path), args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillShape:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::fill_shape&>(op);
+                    fill_shape(queue().mesh(args.mesh), args.position, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::DrawGlyph:
+                draw_glyphs(graphics_operation::batch{ &op, &op + 1 });
+                break;
+            case graphics_operation::operation_type::DrawMesh:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_mesh&>(op);
+                    draw_mesh(queue().mesh(args.mesh), args.material, args.transformation, args.filter);
+                }
+                break;
+            }
+        }
+
+        queue().clear();
+
+        static_cast<software_renderer&>(iRenderingEngine).flushed(queue().last_statistics(), iUnsupportedOperations,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime));
+    }
+
+    neogfx::logical_coordinate_system software_rendering_context::logical_coordinate_system() const
+    {
+        if (iLogicalCoordinateSystem != std::nullopt)
+            return *iLogicalCoordinateSystem;
+        return render_target().logical_coordinate_system();
+    }
+
+    void software_rendering_context::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem)
+    {
+        iLogicalCoordinateSystem = aSystem;
+        iClipRect = std::nullopt;
+        update_transformation();
+    }
+
+    logical_coordinates software_rendering_context::logical_coordinates() const
+    {
+        if (iLogicalCoordinates != std::nullopt)
+            return *iLogicalCoordinates;
+        auto result = render_target().logical_coordinates();
+        if (logical_coordinate_system() != render_target().logical_coordinate_system())
+        {
+            switch (logical_coordinate_system())
+            {
+            case neogfx::logical_coordinate_system::Specified:
+                break;
+            case neogfx::logical_coordinate_system::AutomaticGame:
+                if (render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui)
+                    std::swap(result.bottomLeft.y, result.topRight.y);
+                break;
+            case neogfx::logical_coordinate_system::AutomaticGui:
+                std::swap(result.bottomLeft.y, result.topRight.y);
+                break;
+            }
+        }
+        return result;
+    }
+
+    void software_rendering_context::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates)
+    {
+        iLogicalCoordinates = aCoordinates;
+        iClipRect = std::nullopt;
+        update_transformation();
+    }
+
+    point software_rendering_context::origin() const
+    {
+        return iOrigin;
+    }
+
+    void software_rendering_context::set_origin(const point& aOrigin)
+    {
+        iOrigin = aOrigin;
+    }
+
+    vec2 software_rendering_context::offset() const
+    {
+        return (iOffset != std::nullopt ? *iOffset : vec2{}) + (snap_to_pixel() ? 0.5 : 0.0);
+    }
+
+    void software_rendering_context::set_offset(const optional_vec2& aOffset)
+    {
+        iOffset = aOffset;
+        update_transformation();
+    }
+
+    bool software_rendering_context::gradient_set() const
+    {
+        return !!iGradient;
+    }
+
+    void software_rendering_context::apply_gradient(i_gradient_shader& aShader)
+    {
+        aShader.set_gradient(*this, *iGradient, iOpacity);
+    }
+
+    bool software_rendering_context::snap_to_pixel() const
+    {
+        return iSnapToPixel;
+    }
+
+    void software_rendering_context::set_snap_to_pixel(bool aSnapToPixel)
+    {
+        iSnapToPixel = aSnapToPixel;
+    }
+
+    void software_rendering_context::scissor_on(const rect& aRect)
+    {
+        iScissorRects.push_back(aRect);
+        iScissorRect = std::nullopt;
+        iClipRect = std::nullopt;
+    }
+
+    void software_rendering_context::scissor_off()
+    {
+        if (!iScissorRects.empty())
+            iScissorRects.pop_back();
+        iScissorRect = std::nullopt;
+        iClipRect = std::nullopt;
+    }
+
+    const optional_rect& software_rendering_context::scissor_rect() const
+    {
+        if (iScissorRect == std::nullopt && !iScissorRects.empty())
+        {
+            for (auto const& rect : iScissorRects)
+                if (iScissorRect != std::nullopt)
+                    iScissorRect = iScissorRect->intersection(rect);
+                else
+                    iScissorRect = rect;
+        }
+        return iScissorRect;
+    }
+
+    void software_rendering_context::set_opacity(double aOpacity)
+    {
+        iOpacity = aOpacity;
+    }
+
+    neogfx::blending_mode software_rendering_context::blending_mode() const
+    {
+        return *iBlendingMode;
+    }
+
+    void software_rendering_context::set_blending_mode(neogfx::blending_mode aBlendingMode)
+    {
+        iBlendingMode = aBlendingMode;
+    }
+
+    smoothing_mode software_rendering_context::smoothing_mode() const
+    {
+        return *iSmoothingMode;
+    }
+
+    void software_rendering_context::set_smoothing_mode(neogfx::smoothing_mode aSmoothingMode)
+    {
+        // recorded for clients; the rasteriser always samples pixel centres
+        iSmoothingMode = aSmoothingMode;
+    }
+
+    void software_rendering_context::push_logical_operation(logical_operation aLogicalOperation)
+    {
+        iLogicalOperationStack.push_back(aLogicalOperation);
+    }
+
+    void software_rendering_context::pop_logical_operation()
+    {
+        if (!iLogicalOperationStack.empty())
+            iLogicalOperationStack.pop_back();
+    }
+
+    void software_rendering_context::set_gradient(const gradient& aGradient)
+    {
+        iGradient = aGradient;
+    }
+
+    void software_rendering_context::clear_gradient()
+    {
+        iGradient = std::nullopt;
+    }
+
+    bool software_rendering_context::is_subpixel_rendering_on() const
+    {
+        return iSubpixelRendering;
+    }
+
+    void software_rendering_context::subpixel_rendering_on()
+    {
+        iSubpixelRendering = true;
+    }
+
+    void software_rendering_context::subpixel_rendering_off()
+    {
+        iSubpixelRendering = false;
+    }
+
+    void software_rendering_context::clear(const color& aColor)
+    {
+        // like glClear this honours the scissor but not blending
+        auto const& clip = clip_rect();
+        avec4u8 const value{ aColor.red(), aColor.green(), aColor.blue(), aColor.alpha() };
+        auto& target = this->target();
+        for (int32_t y = clip.y; y < clip.y + clip.cy; ++y)
+            std::fill_n(target.pixels() + static_cast<std::size_t>(y) * target.width() + clip.x, clip.cx, value);
+    }
+
+    void software_rendering_context::set_pixel(const point& aPoint, const color& aColor)
+    {
+        draw_pixel(aPoint, aColor.with_alpha(1.0));
+    }
+
+    void software_rendering_context::draw_pixel(const point& aPoint, const color& aColor)
+    {
+        fill_rect(rect{ aPoint, size{ 1.0, 1.0 } }, aColor);
+    }
+
+    void software_rendering_context::draw_line(const point& aFrom, const point& aTo, const pen& aPen)
+    {
+        auto v1 = aFrom.to_vec2();
+        auto v2 = aTo.to_vec2();
+        if (snap_to_pixel() && static_cast<int32_t>(aPen.width()) % 2 == 0)
+        {
+            v1 -= vec2{ 0.5, 0.5 };
+            v2 -= vec2{ 0.5, 0.5 };
+        }
+        if (snap_to_pixel())
+        {
+            v1 += vec2{ 0.5, 0.5 };
+            v2 += vec2{ 0.5, 0.5 };
+        }
+        stroke_segments(contour{ v1, v2 }, aPen, rect{ aFrom, aTo });
+    }
+
+    void software_rendering_context::draw_rect(const rect& aRect, const pen& aPen)
+    {
+        auto adjustedRect = aRect;
+        if (snap_to_pixel())
+        {
+            bool const oddWidth = static_cast<int32_t>(aPen.width()) % 2 == 1;
+            adjustedRect.position() -= size{ oddWidth ? 0.0 : 0.5 };
+            if (oddWidth)
+                adjustedRect = adjustedRect.with_epsilon(size{ 1.0 });
+            adjustedRect.position() += size{ 0.5 };
+        }
+        else
+            adjustedRect.inflate(size{ aPen.width() / 2.0 }.floor());
+        // the outline is a ring: outer edge one way round, inner edge the other
+        auto const outer = adjustedRect.inflated(size{ aPen.width() / 2.0 });
+        auto const inner = adjustedRect.inflated(size{ -aPen.width() / 2.0 });
+        contour_list contours;
+        contours.push_back({ outer.top_left().to_vec2(), outer.top_right().to_vec2(), outer.bottom_right().to_vec2(), outer.bottom_left().to_vec2() });
+        if (inner.cx > 0.0 && inner.cy > 0.0)
+            contours.push_back({ inner.top_left().to_vec2(), inner.bottom_left().to_vec2(), inner.bottom_right().to_vec2(), inner.top_right().to_vec2() });
+        fill(contours, paint::from(*this, aPen.color(), aRect, iOpacity));
+    }
+
+    void software_rendering_context::draw_rounded_rect(const rect& aRect, dimension aRadius, const pen& aPen)
+    {
+        auto adjustedRect = aRect;
+        if (snap_to_pixel())
+        {
+            bool const oddWidth = static_cast<int32_t>(aPen.width()) % 2 == 1;
+            adjustedRect.position() -= size{ oddWidth ? 0.0 : 0.5 };
+            if (oddWidth)
+                adjustedRect = adjustedRect.with_epsilon(size{ 1.0 });
+            adjustedRect.position() += size{ 0.5 };
+        }
+        else
+            adjustedRect.inflate(size{ aPen.width() / 2.0 }.floor());
+        contour vertices;
+        for (auto const& v : rounded_rect_vertices(adjustedRect, aRadius, mesh_type::Outline))
+            vertices.push_back(v.xy);
+        stroke(vertices, true, aPen, aRect);
+    }
+
+    void software_rendering_context::draw_circle(const point& aCenter, dimension aRadius, const pen& aPen, angle aStartAngle)
+    {
+        contour vertices;
+        for (auto const& v : circle_vertices(aCenter, aRadius, aStartAngle, mesh_type::Outline))
+            vertices.push_back(v.xy);
+        stroke(vertices, true, aPen, rect{ aCenter - point{ aRadius, aRadius }, size{ aRadius * 2.0, aRadius * 2.0 } });
+    }
+
+    void software_rendering_context::draw_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const pen& aPen)
+    {
+        contour vertices;
+        for (auto const& v : arc_vertices(aCenter, aRadius, aStartAngle, aEndAngle, aCenter, mesh_type::Outline))
+            vertices.push_back(v.xy);
+        stroke(vertices, false, aPen, rect{ aCenter - point{ aRadius, aRadius }, size{ aRadius * 2.0, aRadius * 2.0 } });
+    }
+
+    void software_rendering_context::draw_cubic_bezier(const point& aP0, const point& aP1, const point& aP2, const point& aP3, const pen& aPen)
+    {
+        // flattened on the CPU in place of the OpenGL backend's shape shader
+        auto const p0 = aP0.to_vec2();
+        auto const p1 = aP1.to_vec2();
+        auto const p2 = aP2.to_vec2();
+        auto const p3 = aP3.to_vec2();
+        auto const hullLength = (p1 - p0).magnitude() + (p2 - p1).magnitude() + (p3 - p2).magnitude();
+        auto const segments = std::max<uint32_t>(1u, static_cast<uint32_t>(std::ceil(hullLength / 4.0)));
+        contour vertices;
+        vertices.reserve(segments + 1u);
+        for (uint32_t segment = 0; segment <= segments; ++segment)
+            vertices.push_back(bezier_point(p0, p1, p2, p3, static_cast<scalar>(segment) / segments));
+        stroke(vertices, false, aPen, rect{ aP0.min(aP1.min(aP2.min(aP3))), aP0.max(aP1.max(aP2.max(aP3))) }.inflated(aPen.width()));
+    }
+
+    void software_rendering_context::draw_path(const path& aPath, const pen& aPen)
+    {
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() < 2)
+                continue;
+            contour vertices;
+            for (auto const& v : aPath.to_vertices(subPath))
+                vertices.push_back(v.xy);
+            switch (aPath.shape())
+            {
+            case path_shape::Quads:
+            case path_shape::Lines:
+                stroke_segments(vertices, aPen, aPath.bounding_rect());
+                break;
+            case path_shape::ConvexPolygon:
+                vertices.erase(vertices.begin());
+                stroke(vertices, false, aPen, aPath.bounding_rect());
+                break;
+            case path_shape::LineLoop:
+                stroke(vertices, true, aPen, aPath.bounding_rect());
+                break;
+            default:
+                stroke(vertices, false, aPen, aPath.bounding_rect());
+                break;
+            }
+        }
+    }
+
+    void software_rendering_context::draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen)
+    {
+        contour vertices;
+        vertices.reserve(aMesh.vertices.size());
+        for (auto const& v : aMesh.vertices)
+            vertices.push_back((v + aPosition).xy);
+        stroke(vertices, true, aPen, bounding_rect(aMesh));
+    }
+
+    void software_rendering_context::fill_rect(const rect& aRect, const brush& aFill)
+    {
+        if (aRect.empty())
+            return;
+        // axis-aligned fast path: no edge list, straight to spans
+        auto const p0 = to_target(aRect.top_left().to_vec2());
+        auto const p1 = to_target((aRect.top_left() + aRect.extents()).to_vec2());
+        auto const& clip = clip_rect();
+        int32_t const x0 = std::max(clip.x, static_cast<int32_t>(std::ceil(std::min(p0.x, p1.x) - 0.5)));
+        int32_t const x1 = std::min(clip.x + clip.cx, static_cast<int32_t>(std::ceil(std::max(p0.x, p1.x) - 0.5)));
+        int32_t const y0 = std::max(clip.y, static_cast<int32_t>(std::ceil(std::min(p0.y, p1.y) - 0.5)));
+        int32_t const y1 = std::min(clip.y + clip.cy, static_cast<int32_t>(std::ceil(std::max(p0.y, p1.y) - 0.5)));
+        if (x0 >= x1 || y0 >= y1)
+            return;
+        auto const fill = paint::from(*this, aFill, aRect, iOpacity);
+        for (int32_t y = y0; y < y1; ++y)
+            fill_span(y, x0, x1, fill);
+    }
+
+    void software_rendering_context::fill_rounded_rect(const rect& aRect, dimension aRadius, const brush& aFill)
+    {
+        if (aRect.empty())
+            return;
+        contour vertices;
+        for (auto const& v : rounded_rect_vertices(aRect, aRadius, mesh_type::TriangleFan))
+            vertices.push_back(v.xy);
+        fill(contour_list{ vertices }, aFill, aRect);
+    }
+
+    void software_rendering_context::fill_checker_rect(const rect& aRect, const size& aSquareSize, const brush& aFill1, const brush& aFill2)
+    {
+        for (coordinate x = 0; x < aRect.cx; x += aSquareSize.cx)
+        {
+            bool alt = ((static_cast<int32_t>(x / aSquareSize.cx) % 2) == 0);
+            for (coordinate y = 0; y < aRect.cy; y += aSquareSize.cy)
+            {
+                fill_rect(rect{ aRect.top_left() + point{ x, y }, aSquareSize }, alt ? aFill1 : aFill2);
+                alt = !alt;
+            }
+        }
+    }
+
+    void software_rendering_context::fill_circle(const point& aCenter, dimension aRadius, const brush& aFill)
+    {
+        contour vertices;
+        for (auto const& v : circle_vertices(aCenter, aRadius, 0.0, mesh_type::TriangleFan))
+            vertices.push_back(v.xy);
+        fill(contour_list{ vertices }, aFill, rect{ aCenter - point{ aRadius, aRadius }, size{ aRadius * 2.0 } });
+    }
+
+    void software_rendering_context::fill_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const brush& aFill)
+    {
+        contour vertices;
+        for (auto const& v : arc_vertices(aCenter, aRadius, aStartAngle, aEndAngle, aCenter, mesh_type::TriangleFan))
+            vertices.push_back(v.xy);
+        fill(contour_list{ vertices }, aFill, rect{ aCenter - point{ aRadius, aRadius }, size{ aRadius * 2.0 } });
+    }
+
+    void software_rendering_context::fill_path(const path& aPath, const brush& aFill)
+    {
+        contour_list contours;
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() <= 2)
+                continue;
+            contours.emplace_back();
+            for (auto const& v : aPath.to_vertices(subPath))
+                contours.back().push_back(v.xy);
+        }
+        fill(contours, aFill, aPath.bounding_rect());
+    }
+
+    void software_rendering_context::fill_shape(const game::mesh& aMesh, const vec3& aPosition, const brush& aFill)
+    {
+        // faces are wound consistently so that the union of triangles is filled exactly once per pixel
+        contour_list contours;
+        contours.reserve(aMesh.faces.size());
+        for (auto const& face : aMesh.faces)
+        {
+            contour triangle{ (aMesh.vertices[face[0]] + aPosition).xy, (aMesh.vertices[face[1]] + aPosition).xy, (aMesh.vertices[face[2]] + aPosition).xy };
+            auto const area = (triangle[1].x - triangle[0].x) * (triangle[2].y - triangle[0].y) - (triangle[2].x - triangle[0].x) * (triangle[1].y - triangle[0].y);
+            if (area < 0.0)
+                std::swap(triangle[1], triangle[2]);
+            contours.push_back(std::move(triangle));
+        }
+        auto boundingRect = bounding_rect(aMesh);
+        boundingRect.position() += point{ aPosition.x, aPosition.y };
+        fill(contours, aFill, boundingRect);
+    }
+
+    void software_rendering_context::draw_glyphs(const graphics_operation::batch& aDrawGlyphOps)
+    {
+        thread_local neolib::variable_stack<std::vector<draw_glyph>> glyphCacheStack;
+        neolib::variable_stack_context<std::vector<draw_glyph>> context{ glyphCacheStack };
+
+        auto& drawGlyphCache = glyphCacheStack.current();
+        drawGlyphCache.clear();
+
+        for (auto op = aDrawGlyphOps.first; op != aDrawGlyphOps.second; ++op)
+        {
+            auto& drawOp = static_variant_cast<const graphics_operation::draw_glyphs&>(*op);
+            vec3 pos = drawOp.point;
+            for (auto g = drawOp.begin; g != drawOp.end; ++g)
+            {
+                auto& glyph = *g;
+                drawGlyphCache.push_back(draw_glyph{ pos, &drawOp.glyphText.content(), &glyph, &drawOp.appearance, drawOp.showMnemonics });
+                pos.x += advance(glyph).cx;
+            }
+        }
+
+        if (!drawGlyphCache.empty())
+            draw_glyphs(&*drawGlyphCache.begin(), &*drawGlyphCache.begin() + drawGlyphCache.size());
+    }
+
+    void software_rendering_context::draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation, const std::optional<game::filter>& aFilter)
+    {
+        if (aFilter != std::nullopt)
+            ++iUnsupportedOperations; // filters are fragment shader effects; the mesh is drawn unfiltered
+
+        std::vector<vec2> vertices;
+        vertices.reserve(aMesh.vertices.size());
+        for (auto const& v : aMesh.vertices)
+            vertices.push_back(to_target((aTransformation * v).xy));
+
+        std::optional<paint> meshPaint;
+        if (aMaterial.color != std::nullopt)
+            meshPaint.emplace(to_vec4f(color{ aMaterial.color->rgba }, iOpacity));
+        else if (aMaterial.gradient != std::nullopt || iGradient != std::nullopt)
+        {
+            rect boundingRect;
+            if (!vertices.empty())
+            {
+                auto minimum = from_target(vertices[0]);
+                auto maximum = minimum;
+                for (auto const& v : vertices)
+                {
+                    auto const p = from_target(v);
+                    minimum = vec2{ std::min(minimum.x, p.x), std::min(minimum.y, p.y) };
+                    maximum = vec2{ std::max(maximum.x, p.x), std::max(maximum.y, p.y) };
+                }
+                boundingRect = rect{ point{ minimum }, point{ maximum } };
+            }
+            if (aMaterial.gradient != std::nullopt)
+            {
+                gradient const materialGradient{ service<i_gradient_manager>().find_gradient(aMaterial.gradient->id.cookie()) };
+                meshPaint.emplace(*this, aMaterial.gradient->boundingBox ?
+                    materialGradient.with_bounding_box(rect{ *aMaterial.gradient->boundingBox }) : materialGradient, boundingRect, iOpacity);
+            }
+            else
+                meshPaint.emplace(*this, *iGradient, boundingRect, iOpacity);
+        }
+        else
+            meshPaint.emplace(vec4f{ 1.0f, 1.0f, 1.0f, static_cast<float>(iOpacity) });
+
+        software_texture const* texels = nullptr;
+        texture_data_format dataFormat = texture_data_format::RGBA;
+        vec2 textureOrigin;
+        vec2 textureExtents;
+        bool guiTexture = false;
+        if (aMaterial.texture != std::nullopt || aMaterial.sharedTexture != std::nullopt)
+        {
+            auto const& materialTexture = (aMaterial.texture != std::nullopt ? *aMaterial.texture : *aMaterial.sharedTexture->ptr);
+            auto const& texture = *service<i_texture_manager>().find_texture(materialTexture.id.cookie());
+            texels = &static_cast<software_texture const&>(texture.native_texture());
+            dataFormat = texture.data_format();
+            textureExtents = materialTexture.extents;
+            if (materialTexture.type == texture_type::Texture)
+                textureOrigin = vec2{};
+            else if (materialTexture.subTexture == std::nullopt)
+                textureOrigin = texture.as_sub_texture().atlas_location().top_left().to_vec2();
+            else
+                textureOrigin = materialTexture.subTexture->min;
+            guiTexture = texture.is_render_target() && texture.as_render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui;
+        }
+        auto const effect = (aMaterial.shaderEffect != std::nullopt ? *aMaterial.shaderEffect : shader_effect::None);
+        auto const blendingMode = blending_mode();
+        bool const logicalXor = !iLogicalOperationStack.empty() && iLogicalOperationStack.back() == logical_operation::Xor;
+
+        edge_list edges;
+        for (auto const& face : aMesh.faces)
+        {
+            auto const& a = vertices[face[0]];
+            auto const& b = vertices[face[1]];
+            auto const& c = vertices[face[2]];
+            auto const area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+            if (area == 0.0)
+                continue;
+            edges.clear();
+            add_edges(edges, contour{ a, b, c });
+            auto& target = this->target();
+            scan_convert(edges, [&](int32_t y, int32_t x0, int32_t x1)
+            {
+                auto row = target.pixels() + static_cast<std::size_t>(y) * target.width();
+                for (int32_t x = x0; x < x1; ++x)
+                {
+                    auto color = meshPaint->at(x, y);
+                    if (texels != nullptr)
+                    {
+                        vec2 const p{ x + 0.5, y + 0.5 };
+                        auto const wa = ((b.x - p.x) * (c.y - p.y) - (c.x - p.x) * (b.y - p.y)) / area;
+                        auto const wb = ((c.x - p.x) * (a.y - p.y) - (a.x - p.x) * (c.y - p.y)) / area;
+                        auto const wc = 1.0 - wa - wb;
+                        auto uv = aMesh.uv[face[0]] * wa + aMesh.uv[face[1]] * wb + aMesh.uv[face[2]] * wc;
+                        if (guiTexture)
+                            uv.y = 1.0 - uv.y;
+                        auto const tx = std::max(0.0, std::min(textureExtents.x - 1.0, std::floor(uv.x * textureExtents.x)));
+                        auto const ty = std::max(0.0, std::min(textureExtents.y - 1.0, std::floor(uv.y * textureExtents.y)));
+                        color = shade(color, texels->texel(static_cast<int32_t>(textureOrigin.x + tx), static_cast<int32_t>(textureOrigin.y + ty)), dataFormat, effect);
+                    }
+                    blend(row[x], color, blendingMode, logicalXor);
+                }
+            });
+        }
+    }
+
+    void software_rendering_context::draw_texture(const rect& aRect, const i_texture& aTexture, const rect& aTextureRect, const optional_color& aColor, shader_effect aShaderEffect)
+    {
+        draw_texture(aRect, aTexture, aTextureRect, paint{ aColor != std::nullopt ? to_vec4f(*aColor, iOpacity) : vec4f{ 1.0f, 1.0f, 1.0f, static_cast<float>(iOpacity) } }, aShaderEffect);
+    }
+
+    subpixel_format software_rendering_context::subpixel_format() const
+    {
+        if (render_target().target_type() == render_target_type::Texture)
+            return neogfx::subpixel_format::None;
+        // use the display that the target surface mostly covers
+        auto const& basicServices = service<i_basic_services>();
+        uint32_t targetDisplay = 0u;
+        if (auto const surface = dynamic_cast<i_native_surface const*>(&render_target()))
+        {
+            rect const surfaceRect{ surface->surface_position(), surface->surface_size() };
+            scalar largestArea = 0.0;
+            for (uint32_t displayIndex = 0u; displayIndex < basicServices.display_count(); ++displayIndex)
+            {
+                auto const overlap = basicServices.display(displayIndex).desktop_rect().intersection(surfaceRect);
+                if (!overlap.empty() && overlap.width() * overlap.height() > largestArea)
+                {
+                    largestArea = overlap.width() * overlap.height();
+                    targetDisplay = displayIndex;
+                }
+            }
+        }
+        return basicServices.display(targetDisplay).subpixel_format();
+    }
+
+    void software_rendering_context::draw_glyphs(const draw_glyph* aBegin, const draw_glyph* aEnd)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+
+        bool effectsUnsupported = false;
+
+        for (int32_t pass = 1; pass <= 6; ++pass)
+        {
+            switch (pass)
+            {
+            case 1: // Paper (glyph background)
+                for (auto op = aBegin; op != aEnd; ++op)
+                {
+                    auto& drawOp = *op;
+                    auto& glyphText = *drawOp.glyphText;
+                    auto& glyph = *drawOp.glyph;
+                    if (drawOp.appearance->paper() != std::nullopt)
+                    {
+                        font const& glyphFont = glyphText.glyph_font(glyph);
+                        rect const glyphRect{ point{ drawOp.point } + glyph.offset.as<scalar>(), size{ advance(glyph).cx, glyphFont.height() } };
+                        fill_rect(glyphRect, to_brush(*drawOp.appearance->paper()));
+                    }
+                }
+                break;
+            case 2: // Special effects
+                for (auto op = aBegin; op != aEnd && !effectsUnsupported; ++op)
+                {
+                    // glow and shadow are blur filters rendered through ping-pong buffers and shaders
+                    auto& drawOp = *op;
+                    if (drawOp.appearance->effect() != std::nullopt && !drawOp.appearance->being_filtered() && !drawOp.appearance->only_calculate_effect() &&
+                        (drawOp.appearance->effect()->type() == text_effect_type::Glow || drawOp.appearance->effect()->type() == text_effect_type::Shadow))
+                        effectsUnsupported = true;
+                }
+                if (effectsUnsupported)
+                    ++iUnsupportedOperations;
+                break;
+            case 3: // Emoji render (final pass)
+                for (auto op = aBegin; op != aEnd; ++op)
+                {
+                    auto& drawOp = *op;
+                    auto& glyphText = *drawOp.glyphText;
+                    auto& glyph = *drawOp.glyph;
+
+                    if (is_whitespace(glyph) || !is_emoji(glyph))
+                        continue;
+
+                    font const& glyphFont = glyphText.glyph_font(glyph);
+                    rect const outputRect = { point{ drawOp.point } + glyph.offset.as<scalar>(), size{ advance(glyph).cx, glyphFont.height() } };
+                    auto const& emojiTexture = rendering_engine().font_manager().emoji_atlas().emoji_texture(glyph.value).as_sub_texture();
+                    auto const& ink = drawOp.appearance->ignore_emoji() ? neolib::none : drawOp.appearance->ink();
+                    draw_texture(outputRect, emojiTexture, rect{ point{}, emojiTexture.extents() },
+                        std::holds_alternative<color>(ink) || std::holds_alternative<gradient>(ink) ?
+                            paint::from(*this, static_cast<const color_or_gradient&>(ink), outputRect, iOpacity) :
+                            paint{ vec4f{ 1.0f, 1.0f, 1.0f, static_cast<float>(iOpacity) } },
+                        drawOp.appearance->ignore_emoji() ? shader_effect::None : shader_effect::Colorize);
+                }
+                break;
+            case 4: // Glyph render (outline pass)
+            case 5: // Glyph render (final pass)
+                for (auto op = aBegin; op != aEnd; ++op)
+                {
+                    auto& drawOp = *op;
+                    auto& glyphText = *drawOp.glyphText;
+                    auto& glyph = *drawOp.glyph;
+
+                    if (is_whitespace(glyph) || is_emoji(glyph))
+                        continue;
+
+                    auto const& glyphTexture = glyphText.glyph_texture(glyph);
+                    auto const& glyphFont = glyphText.glyph_font(glyph);
+
+                    auto glyphOrigin = point{
+                        drawOp.point.x + glyphTexture.placement().x,
+                        logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame ?
+                            drawOp.point.y + (glyphTexture.placement().y + -glyphFont.descender()) :
+                            drawOp.point.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.texture().extents().cy
+                    } + glyph.offset.as<scalar>();
+
+                    rect const textureRect{ point{}, glyphTexture.texture().extents() };
+
+                    if (pass == 4)
+                    {
+                        if (drawOp.appearance->effect() && drawOp.appearance->effect()->type() == text_effect_type::Outline)
+                        {
+                            auto const scanlineOffsets = static_cast<uint32_t>(drawOp.appearance->effect()->width()) * 2u + 1u;
+                            auto const offsets = scanlineOffsets * scanlineOffsets;
+                            point const offsetOrigin = drawOp.appearance->effect()->offset();
+                            for (uint32_t offset = 0; offset < offsets; ++offset)
+                            {
+                                rect const outputRect = {
+                                    glyphOrigin + offsetOrigin + point{ static_cast<coordinate>(offset % scanlineOffsets), static_cast<coordinate>(offset / scanlineOffsets) },
+                                    glyphTexture.texture().extents() };
+                                draw_texture(outputRect, glyphTexture.texture(), textureRect,
+                                    paint::from(*this, static_cast<const color_or_gradient&>(drawOp.appearance->effect()->color()), outputRect, iOpacity), shader_effect::Ignore);
+                            }
+                        }
+                        continue;
+                    }
+
+                    rect const outputRect = { glyphOrigin, glyphTexture.texture().extents() };
+                    auto const& ink = !drawOp.appearance->effect() || !drawOp.appearance->being_filtered() ?
+                        drawOp.appearance->ink() : drawOp.appearance->effect()->color();
+                    draw_texture(outputRect, glyphTexture.texture(), textureRect,
+                        paint::from(*this, static_cast<const color_or_gradient&>(ink), outputRect, iOpacity), shader_effect::Ignore);
+                }
+                break;
+            case 6: // adornments
+                {
+                    struct y_underline_metrics
+                    {
+                        scalar ypos;
+                        scalar yUnderline;
+                        scalar cyUnderline;
+                    };
+                    thread_local std::vector<y_underline_metrics> yUnderlineMetrics;
+                    yUnderlineMetrics.clear();
+                    for (int32_t adornmentPass = 1; adornmentPass <= 2; ++adornmentPass)
+                    {
+                        auto yUnderlineMetricsIter = yUnderlineMetrics.begin();
+                        for (auto op = aBegin; op != aEnd; ++op)
+                        {
+                            auto& drawOp = *op;
+                            auto& glyphText = *drawOp.glyphText;
+                            auto& glyph = *drawOp.glyph;
+                            auto const& glyphFont = glyphText.glyph_font(glyph);
+                            auto const& ink = !drawOp.appearance->effect() || !drawOp.appearance->being_filtered() ?
+                                drawOp.appearance->ink() : drawOp.appearance->effect()->color();
+                            if (underline(glyph) || (drawOp.showMnemonics && neogfx::mnemonic(glyph)))
+                            {
+                                if (adornmentPass == 1)
+                                {
+                                    auto const descender = glyphFont.descender();
+                                    auto const underlinePosition = glyphFont.native_font_face().underline_position();
+                                    auto const dy = descender - underlinePosition;
+                                    auto const yLine = (logical_coordinates().is_gui_orientation() ? glyphFont.height() - 1 + dy : -dy) + glyph.offset.as<scalar>().y;
+                                    if (yUnderlineMetrics.empty() || yUnderlineMetrics.back().ypos != drawOp.point.y)
+                                        yUnderlineMetrics.push_back(y_underline_metrics{ drawOp.point.y, yLine + drawOp.point.y, glyphFont.native_font_face().underline_thickness() });
+                                    else
+                                    {
+                                        yUnderlineMetrics.back().yUnderline = std::max(yLine + drawOp.point.y, yUnderlineMetrics.back().yUnderline);
+                                        yUnderlineMetrics.back().cyUnderline = std::max(glyphFont.native_font_face().underline_thickness(), yUnderlineMetrics.back().cyUnderline);
+                                    }
+                                }
+                                else
+                                {
+                                    if (yUnderlineMetricsIter->ypos != drawOp.point.y)
+                                        ++yUnderlineMetricsIter;
+                                    draw_line(
+                                        point{ drawOp.point.x, yUnderlineMetricsIter->yUnderline },
+                                        point{ drawOp.point.x + (drawOp.showMnemonics && neogfx::mnemonic(glyph) ? glyphText.extents(glyph).cx : advance(glyph).cx), yUnderlineMetricsIter->yUnderline },
+                                        pen{ ink, yUnderlineMetricsIter->cyUnderline });
+                                }
+                            }
+                        }
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    void software_rendering_context::draw_texture(const rect& aRect, const i_texture& aTexture, const rect& aTextureRect, const paint& aPaint, shader_effect aShaderEffect)
+    {
+        if (aRect.empty() || aTextureRect.empty())
+            return;
+        auto const p0 = to_target(aRect.top_left().to_vec2());
+        auto const p1 = to_target((aRect.top_left() + aRect.extents()).to_vec2());
+        vec2 const minimum{ std::min(p0.x, p1.x), std::min(p0.y, p1.y) };
+        vec2 const maximum{ std::max(p0.x, p1.x), std::max(p0.y, p1.y) };
+        auto const& clip = clip_rect();
+        int32_t const x0 = std::max(clip.x, static_cast<int32_t>(std::ceil(minimum.x - 0.5)));
+        int32_t const x1 = std::min(clip.x + clip.cx, static_cast<int32_t>(std::ceil(maximum.x - 0.5)));
+        int32_t const y0 = std::max(clip.y, static_cast<int32_t>(std::ceil(minimum.y - 0.5)));
+        int32_t const y1 = std::min(clip.y + clip.cy, static_cast<int32_t>(std::ceil(maximum.y - 0.5)));
+        if (x0 >= x1 || y0 >= y1)
+            return;
+
+        // nearest sampling; v runs up the target as the mesh uv of a rect does
+        auto const& texels = static_cast<software_texture const&>(aTexture.native_texture());
+        auto const dataFormat = aTexture.data_format();
+        vec2 const atlasOrigin = (aTexture.type() == texture_type::Texture ? vec2{} : aTexture.as_sub_texture().atlas_location().top_left().to_vec2());
+        bool const guiTexture = aTexture.is_render_target() && aTexture.as_render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui;
+        auto const textureHeight = aTexture.extents().cy;
+        auto const blendingMode = blending_mode();
+        bool const logicalXor = !iLogicalOperationStack.empty() && iLogicalOperationStack.back() == logical_operation::Xor;
+        auto& target = this->target();
+
+        thread_local std::vector<int32_t> columns;
+        columns.clear();
+        for (int32_t x = x0; x < x1; ++x)
+        {
+            auto const u = (x + 0.5 - minimum.x) / (maximum.x - minimum.x);
+            columns.push_back(static_cast<int32_t>(atlasOrigin.x + std::min(aTextureRect.x + aTextureRect.cx - 1.0, std::floor(aTextureRect.x + u * aTextureRect.cx))));
+        }
+        for (int32_t y = y0; y < y1; ++y)
+        {
+            auto const v = (y + 0.5 - minimum.y) / (maximum.y - minimum.y);
+            auto ty = std::min(aTextureRect.y + aTextureRect.cy - 1.0, std::floor(aTextureRect.y + v * aTextureRect.cy));
+            if (guiTexture)
+                ty = textureHeight - 1.0 - ty;
+            auto const textureRow = static_cast<int32_t>(atlasOrigin.y + ty);
+            auto row = target.pixels() + static_cast<std::size_t>(y) * target.width();
+            for (int32_t x = x0; x < x1; ++x)
+            {
+                auto const color = shade(aPaint.at(x, y), texels.texel(columns[x - x0], textureRow), dataFormat, aShaderEffect);
+                if (color[3] == 0.0f && blendingMode == neogfx::blending_mode::Default && !logicalXor)
+                    continue;
+                blend(row[x], color, blendingMode, logicalXor);
+            }
+        }
+    }
+
+    void software_rendering_context::stroke(const contour& aVertices, bool aClosed, const pen& aPen, const rect& aBoundingRect)
+    {
+        if (aVertices.size() < 2)
+            return;
+        contour_list quads;
+        quads.reserve(aVertices.size());
+        for (std::size_t i = 0; i + 1 < aVertices.size(); ++i)
+            add_segment_quad(quads, aVertices[i], aVertices[i + 1], aPen.width());
+        if (aClosed && aVertices.front() != aVertices.back())
+            add_segment_quad(quads, aVertices.back(), aVertices.front(), aPen.width());
+        fill(quads, paint::from(*this, aPen.color(), aBoundingRect, iOpacity));
+    }
+
+    void software_rendering_context::stroke_segments(const contour& aSegments, const pen& aPen, const rect& aBoundingRect)
+    {
+        contour_list quads;
+        quads.reserve(aSegments.size() / 2u);
+        for (std::size_t i = 0; i + 1 < aSegments.size(); i += 2u)
+            add_segment_quad(quads, aSegments[i], aSegments[i + 1], aPen.width());
+        fill(quads, paint::from(*this, aPen.color(), aBoundingRect, iOpacity));
+    }
+
+    void software_rendering_context::fill(const contour_list& aContours, const brush& aFill, const rect& aBoundingRect)
+    {
+        fill(aContours, paint::from(*this, aFill, aBoundingRect, iOpacity));
+    }
+
+    void software_rendering_context::fill(const contour_list& aContours, const paint& aPaint)
+    {
+        thread_local edge_list edges;
+        edges.clear();
+        for (auto const& contour : aContours)
+            add_edges(edges, contour);
+        scan_convert(edges, [&](int32_t y, int32_t x0, int32_t x1)
+        {
+            fill_span(y, x0, x1, aPaint);
+        });
+    }
+
+    void software_rendering_context::fill_span(int32_t aY, int32_t aX0, int32_t aX1, const paint& aPaint)
+    {
+        auto& target = this->target();
+        auto row = target.pixels() + static_cast<std::size_t>(aY) * target.width();
+        auto const blendingMode = blending_mode();
+        bool const logicalXor = !iLogicalOperationStack.empty() && iLogicalOperationStack.back() == logical_operation::Xor;
+        if (aPaint.solid() && !logicalXor)
+        {
+            auto const& color = aPaint.color();
+            if (blendingMode == neogfx::blending_mode::Default && color[3] <= 0.0f)
+                return;
+            if (blendingMode == neogfx::blending_mode::None || (blendingMode == neogfx::blending_mode::Default && color[3] >= 1.0f))
+            {
+                avec4u8 const value{ to_component(color[0]), to_component(color[1]), to_component(color[2]), to_component(color[3]) };
+                std::fill(row + aX0, row + aX1, value);
+                return;
+            }
+        }
+        for (int32_t x = aX0; x < aX1; ++x)
+            blend(row[x], aPaint.at(x, aY), blendingMode, logicalXor);
+    }
+
+    // Non-zero winding scanline conversion sampling pixel centres; spans are half-open [x0, x1)
+    // so shared edges of adjacent polygons are covered exactly once.
+    template <typename SpanFunction>
+    void software_rendering_context::scan_convert(edge_list& aEdges, SpanFunction aSpanFunction) const
+    {
+        if (aEdges.empty())
+            return;
+        auto const& clip = clip_rect();
+        if (clip.cx <= 0 || clip.cy <= 0)
+            return;
+        std::sort(aEdges.begin(), aEdges.end(), [](const edge& aLeft, const edge& aRight) { return aLeft.y0 < aRight.y0; });
+        scalar maxY = aEdges[0].y1;
+        for (auto const& e : aEdges)
+            maxY = std::max(maxY, e.y1);
+        int32_t const yStart = std::max(clip.y, static_cast<int32_t>(std::ceil(aEdges[0].y0 - 0.5)));
+        int32_t const yEnd = std::min(clip.y + clip.cy, static_cast<int32_t>(std::ceil(maxY - 0.5)));
+        std::vector<const edge*> active;
+        std::vector<std::pair<scalar, int32_t>> crossings;
+        auto nextEdge = aEdges.begin();
+        for (int32_t y = yStart; y < yEnd; ++y)
+        {
+            scalar const yc = y + 0.5;
+            while (nextEdge != aEdges.end() && nextEdge->y0 <= yc)
+                active.push_back(&*nextEdge++);
+            active.erase(std::remove_if(active.begin(), active.end(), [yc](const edge* e) { return e->y1 <= yc; }), active.end());
+            crossings.clear();
+            for (auto e : active)
+                crossings.emplace_back(e->x0 + (yc - e->y0) * (e->x1 - e->x0) / (e->y1 - e->y0), e->winding);
+            std::sort(crossings.begin(), crossings.end());
+            int32_t winding = 0;
+            scalar spanStart = 0.0;
+            for (auto const& crossing : crossings)
+            {
+                auto const previousWinding = winding;
+                winding += crossing.second;
+                if (previousWinding == 0 && winding != 0)
+                    spanStart = crossing.first;
+                else if (previousWinding != 0 && winding == 0)
+                {
+                    int32_t const x0 = std::max(clip.x, static_cast<int32_t>(std::ceil(spanStart - 0.5)));
+                    int32_t const x1 = std::min(clip.x + clip.cx, static_cast<int32_t>(std::ceil(crossing.first - 0.5)));
+                    if (x0 < x1)
+                        aSpanFunction(y, x0, x1);
+                }
+            }
+        }
+    }
+
+    void software_rendering_context::add_edges(edge_list& aEdges, const contour& aContour) const
+    {
+        if (aContour.size() < 3)
+            return;
+        auto previous = to_target(aContour.back());
+        for (auto const& v : aContour)
+        {
+            auto const next = to_target(v);
+            if (previous.y < next.y)
+                aEdges.push_back(edge{ previous.x, previous.y, next.x, next.y, 1 });
+            else if (previous.y > next.y)
+                aEdges.push_back(edge{ next.x, next.y, previous.x, previous.y, -1 });
+            previous = next;
+        }
+    }
+
+    vec2 software_rendering_context::to_target(const vec2& aPoint) const
+    {
+        return vec2{ aPoint.x * iScale.x + iTranslation.x, aPoint.y * iScale.y + iTranslation.y };
+    }
+
+    vec2 software_rendering_context::from_target(const vec2& aPoint) const
+    {
+        return vec2{ (aPoint.x - iTranslation.x) / iScale.x, (aPoint.y - iTranslation.y) / iScale.y };
+    }
+
+    const rect_i32& software_rendering_context::clip_rect() const
+    {
+        if (iClipRect == std::nullopt)
+        {
+            auto const extents = render_target().target_extents();
+            int32_t x0 = 0;
+            int32_t y0 = 0;
+            int32_t x1 = static_cast<int32_t>(extents.cx);
+            int32_t y1 = static_cast<int32_t>(extents.cy);
+            auto const& sr = scissor_rect();
+            if (sr != std::nullopt)
+            {
+                // same rounding as opengl_rendering_context::apply_scissor
+                auto const x = static_cast<int32_t>(std::ceil(sr->x));
+                auto const y = static_cast<int32_t>(logical_coordinates().is_gui_orientation() ? std::ceil(extents.cy - sr->cy - sr->y) : sr->y);
+                x0 = std::max(x0, x);
+                y0 = std::max(y0, y);
+                x1 = std::min(x1, x + static_cast<int32_t>(std::ceil(sr->cx)));
+                y1 = std::min(y1, y + static_cast<int32_t>(std::ceil(sr->cy)));
+            }
+            iClipRect.emplace(point_i32{ x0, y0 }, size_i32{ std::max(0, x1 - x0), std::max(0, y1 - y0) });
+        }
+        return *iClipRect;
+    }
+
+    software_texture& software_rendering_context::target() const
+    {
+        return static_cast<software_texture&>(render_target().target_texture().native_texture());
+    }
+
+    void software_rendering_context::update_transformation()
+    {
+        // as the standard vertex shader's projection, less the snap-to-pixel half offset which
+        // draw_line, draw_rect and draw_rounded_rect apply themselves
+        auto const logicalCoordinates = logical_coordinates();
+        auto const extents = render_target().target_extents();
+        auto const offset = (iOffset != std::nullopt ? *iOffset : vec2{});
+        iScale = vec2{
+            extents.cx / (logicalCoordinates.topRight.x - logicalCoordinates.bottomLeft.x),
+            extents.cy / (logicalCoordinates.topRight.y - logicalCoordinates.bottomLeft.y) };
+        iTranslation = vec2{
+            (offset.x - logicalCoordinates.bottomLeft.x) * iScale.x,
+            (offset.y - logicalCoordinates.bottomLeft.y) * iScale.y };
+    }
+}
\ No newline at end of file
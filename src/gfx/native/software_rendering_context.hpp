@@ -0,0 +1,165 @@
+// software_rendering_context.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/i_rendering_context.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/game/mesh.hpp>
+#include <neogfx/game/material.hpp>
+#include <neogfx/game/filter.hpp>
+
+namespace neogfx
+{
+    class software_texture;
+
+    // Executes the graphics operation queue on the CPU against a software_texture render target.
+    // Geometry is sampled once per pixel centre (no anti-aliasing or multisampling); blending
+    // follows the OpenGL backend's blend functions so output is comparable between the two.
+    class software_rendering_context : public i_rendering_context
+    {
+    private:
+        class paint;
+        typedef std::vector<vec2> contour;
+        typedef std::vector<contour> contour_list;
+        struct edge
+        {
+            scalar x0;
+            scalar y0;
+            scalar x1;
+            scalar y1;
+            int32_t winding;
+        };
+        typedef std::vector<edge> edge_list;
+        struct draw_glyph
+        {
+            vec3 point;
+            i_glyph_text* glyphText;
+            glyph const* glyph;
+            text_appearance const* appearance;
+            bool showMnemonics;
+        };
+    public:
+        software_rendering_context(const i_render_target& aTarget, neogfx::blending_mode aBlendingMode = neogfx::blending_mode::Default);
+        software_rendering_context(const software_rendering_context& aOther);
+        ~software_rendering_context();
+    public:
+        std::unique_ptr<i_rendering_context> clone() const override;
+    public:
+        i_rendering_engine& rendering_engine() const override;
+        const i_render_target& render_target() const override;
+        rect rendering_area(bool aConsiderScissor = true) const override;
+    public:
+        const graphics_operation::queue& queue() const override;
+        graphics_operation::queue& queue() override;
+        void enqueue(const graphics_operation::operation& aOperation) override;
+        void flush() override;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const override;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem);
+        neogfx::logical_coordinates logical_coordinates() const override;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates);
+        point origin() const;
+        void set_origin(const point& aOrigin);
+        vec2 offset() const override;
+        void set_offset(const optional_vec2& aOffset) override;
+        bool gradient_set() const override;
+        void apply_gradient(i_gradient_shader& aShader) override;
+        bool snap_to_pixel() const;
+        void set_snap_to_pixel(bool aSnapToPixel);
+        void scissor_on(const rect& aRect);
+        void scissor_off();
+        const optional_rect& scissor_rect() const;
+        void set_opacity(double aOpacity);
+        neogfx::blending_mode blending_mode() const;
+        void set_blending_mode(neogfx::blending_mode aBlendingMode);
+        neogfx::smoothing_mode smoothing_mode() const;
+        void set_smoothing_mode(neogfx::smoothing_mode aSmoothingMode);
+        void push_logical_operation(logical_operation aLogicalOperation);
+        void pop_logical_operation();
+        void set_gradient(const gradient& aGradient);
+        void clear_gradient();
+        bool is_subpixel_rendering_on() const;
+        void subpixel_rendering_on();
+        void subpixel_rendering_off();
+        void clear(const color& aColor);
+        void set_pixel(const point& aPoint, const color& aColor);
+        void draw_pixel(const point& aPoint, const color& aColor);
+        void draw_line(const point& aFrom, const point& aTo, const pen& aPen);
+        void draw_rect(const rect& aRect, const pen& aPen);
+        void draw_rounded_rect(const rect& aRect, dimension aRadius, const pen& aPen);
+        void draw_circle(const point& aCenter, dimension aRadius, const pen& aPen, angle aStartAngle);
+        void draw_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const pen& aPen);
+        void draw_cubic_bezier(const point& aP0, const point& aP1, const point& aP2, const point& aP3, const pen& aPen);
+        void draw_path(const path& aPath, const pen& aPen);
+        void draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen);
+        void fill_rect(const rect& aRect, const brush& aFill);
+        void fill_rounded_rect(const rect& aRect, dimension aRadius, const brush& aFill);
+        void fill_checker_rect(const rect& aRect, const size& aSquareSize, const brush& aFill1, const brush& aFill2);
+        void fill_circle(const point& aCenter, dimension aRadius, const brush& aFill);
+        void fill_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const brush& aFill);
+        void fill_path(const path& aPath, const brush& aFill);
+        void fill_shape(const game::mesh& aMesh, const vec3& aPosition, const brush& aFill);
+        void draw_glyphs(const graphics_operation::batch& aDrawGlyphOps);
+        void draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation, const std::optional<game::filter>& aFilter = {});
+        void draw_texture(const rect& aRect, const i_texture& aTexture, const rect& aTextureRect, const optional_color& aColor = {}, shader_effect aShaderEffect = shader_effect::None);
+    public:
+        neogfx::subpixel_format subpixel_format() const override;
+    private:
+        void draw_glyphs(const draw_glyph* aBegin, const draw_glyph* aEnd);
+        void draw_texture(const rect& aRect, const i_texture& aTexture, const rect& aTextureRect, const paint& aPaint, shader_effect aShaderEffect);
+        void stroke(const contour& aVertices, bool aClosed, const pen& aPen, const rect& aBoundingRect);
+        void stroke_segments(const contour& aSegments, const pen& aPen, const rect& aBoundingRect);
+        void fill(const contour_list& aContours, const brush& aFill, const rect& aBoundingRect);
+        void fill(const contour_list& aContours, const paint& aPaint);
+        void fill_span(int32_t aY, int32_t aX0, int32_t aX1, const paint& aPaint);
+        template <typename SpanFunction>
+        void scan_convert(edge_list& aEdges, SpanFunction aSpanFunction) const;
+        void add_edges(edge_list& aEdges, const contour& aContour) const;
+        vec2 to_target(const vec2& aPoint) const;
+        vec2 from_target(const vec2& aPoint) const;
+        const rect_i32& clip_rect() const;
+        software_texture& target() const;
+        void update_transformation();
+    private:
+        i_rendering_engine& iRenderingEngine;
+        const i_render_target& iTarget;
+        graphics_operation::queue iQueue;
+        bool iInFlush;
+        mutable std::optional<neogfx::logical_coordinate_system> iLogicalCoordinateSystem;
+        mutable std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
+        point iOrigin;
+        double iOpacity;
+        std::optional<neogfx::blending_mode> iBlendingMode;
+        std::optional<neogfx::smoothing_mode> iSmoothingMode;
+        bool iSubpixelRendering;
+        std::vector<logical_operation> iLogicalOperationStack;
+        std::vector<rect> iScissorRects;
+        mutable optional_rect iScissorRect;
+        mutable std::optional<rect_i32> iClipRect;
+        sink iSink;
+        optional_vec2 iOffset;
+        bool iSnapToPixel;
+        std::optional<gradient> iGradient;
+        vec2 iScale;
+        vec2 iTranslation;
+        uint64_t iUnsupportedOperations;
+    };
+}
\ No newline at end of file
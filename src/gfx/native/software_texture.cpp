@@ -0,0 +1,428 @@
+// software_texture.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2015, 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/i_texture_manager.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include "software_rendering_context.hpp"
+#include "software_texture.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        inline uint8_t to_texel_component(float aValue)
+        {
+            return static_cast<uint8_t>(std::round(std::max(0.0f, std::min(1.0f, aValue)) * 255.0f));
+        }
+    }
+
+    software_texture::software_texture(i_texture_manager& aManager, texture_id aId, const neogfx::size& aExtents, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat, texture_data_type aDataType, neogfx::color_space aColorSpace, const optional_color& aColor) :
+        iManager{ aManager },
+        iId{ aId },
+        iDpiScaleFactor{ aDpiScaleFactor },
+        iColorSpace{ aColorSpace },
+        iSampling{ aSampling },
+        iDataFormat{ aDataFormat },
+        iDataType{ aDataType },
+        iSize{ aExtents.ceil() },
+        iPixels(static_cast<std::size_t>(iSize.cx) * iSize.cy, aColor != std::nullopt ?
+            value_type{ aColor->red(), aColor->green(), aColor->blue(), aColor->alpha() } : value_type{}),
+        iLogicalCoordinateSystem{ neogfx::logical_coordinate_system::AutomaticGame }
+    {
+    }
+
+    software_texture::software_texture(i_texture_manager& aManager, texture_id aId, const i_image& aImage, const rect& aImagePart, texture_data_format aDataFormat, texture_data_type aDataType) :
+        iManager{ aManager },
+        iId{ aId },
+        iUri{ aImage.uri() },
+        iDpiScaleFactor{ aImage.dpi_scale_factor() },
+        iColorSpace{ aImage.color_space() },
+        iSampling{ aImage.sampling() },
+        iDataFormat{ aDataFormat },
+        iDataType{ aDataType },
+        iSize{ aImagePart.extents() },
+        iPixels(static_cast<std::size_t>(iSize.cx) * iSize.cy),
+        iLogicalCoordinateSystem{ neogfx::logical_coordinate_system::AutomaticGame }
+    {
+        switch (aImage.color_format())
+        {
+        case color_format::RGBA8:
+            {
+                size_u32 const imageExtents = aImage.extents();
+                point_u32 const imagePartOrigin = aImagePart.position();
+                const uint8_t* imageData = static_cast<const uint8_t*>(aImage.cpixels());
+                for (std::size_t y = 0; y < iSize.cy; ++y)
+                    for (std::size_t x = 0; x < iSize.cx; ++x)
+                        for (std::size_t c = 0; c < 4; ++c)
+                            iPixels[(iSize.cy - 1 - y) * iSize.cx + x][c] = imageData[(y + imagePartOrigin.y) * imageExtents.cx * 4 + (imagePartOrigin.x + x) * 4 + c];
+            }
+            break;
+        default:
+            throw unsupported_color_format();
+            break;
+        }
+    }
+
+    software_texture::~software_texture()
+    {
+    }
+
+    texture_id software_texture::id() const
+    {
+        return iId;
+    }
+
+    string const& software_texture::uri() const
+    {
+        return iUri;
+    }
+
+    texture_type software_texture::type() const
+    {
+        return texture_type::Texture;
+    }
+
+    bool software_texture::is_render_target() const
+    {
+        return true;
+    }
+
+    const i_render_target& software_texture::as_render_target() const
+    {
+        return *this;
+    }
+
+    i_render_target& software_texture::as_render_target()
+    {
+        return *this;
+    }
+
+    const i_sub_texture& software_texture::as_sub_texture() const
+    {
+        throw not_sub_texture();
+    }
+
+    dimension software_texture::dpi_scale_factor() const
+    {
+        return iDpiScaleFactor;
+    }
+
+    texture_sampling software_texture::sampling() const
+    {
+        switch (iSampling)
+        {
+        case texture_sampling::Multisample4x:
+        case texture_sampling::Multisample8x:
+        case texture_sampling::Multisample16x:
+        case texture_sampling::Multisample32x:
+            return texture_sampling::Multisample;
+        default:
+            return iSampling;
+        }
+    }
+
+    uint32_t software_texture::samples() const
+    {
+        // The rasteriser samples each pixel once whatever sampling was requested.
+        return 1u;
+    }
+
+    texture_data_format software_texture::data_format() const
+    {
+        return iDataFormat;
+    }
+
+    texture_data_type software_texture::data_type() const
+    {
+        return iDataType;
+    }
+
+    bool software_texture::is_empty() const
+    {
+        return false;
+    }
+
+    size software_texture::extents() const
+    {
+        return iSize;
+    }
+
+    size software_texture::storage_extents() const
+    {
+        return iSize;
+    }
+
+    void software_texture::set_pixels(const rect& aRect, const void* aPixelData, uint32_t aPackAlignment)
+    {
+        rect_i32 const target = aRect;
+        uint32_t const components = (iDataFormat == texture_data_format::Red ? 1u : 4u);
+        uint32_t const componentSize = (iDataType == texture_data_type::Float ? sizeof(float) : sizeof(uint8_t));
+        std::size_t const rowSize = target.cx * components * componentSize;
+        std::size_t const stride = (rowSize + aPackAlignment - 1u) / aPackAlignment * aPackAlignment;
+        auto const source = static_cast<const uint8_t*>(aPixelData);
+        for (int32_t y = 0; y < target.cy; ++y)
+        {
+            int32_t const ty = target.y + y;
+            if (ty < 0 || ty >= static_cast<int32_t>(iSize.cy))
+                continue;
+            auto const sourceRow = source + y * stride;
+            for (int32_t x = 0; x < target.cx; ++x)
+            {
+                int32_t const tx = target.x + x;
+                if (tx < 0 || tx >= static_cast<int32_t>(iSize.cx))
+                    continue;
+                auto& texel = iPixels[static_cast<std::size_t>(ty) * iSize.cx + tx];
+                auto const sourceTexel = sourceRow + x * components * componentSize;
+                for (uint32_t c = 0; c < components; ++c)
+                    texel[c] = (iDataType == texture_data_type::Float ?
+                        to_texel_component(reinterpret_cast<const float*>(sourceTexel)[c]) : sourceTexel[c]);
+                if (components == 1u)
+                {
+                    texel[1] = 0x00;
+                    texel[2] = 0x00;
+                    texel[3] = 0xFF;
+                }
+            }
+        }
+    }
+
+    void software_texture::set_pixels(const i_image& aImage)
+    {
+        set_pixels(rect{ point{}, aImage.extents() }, aImage.cpixels());
+    }
+
+    void software_texture::set_pixels(const i_image& aImage, const rect& aImagePart)
+    {
+        size_u32 const imageExtents = aImage.extents();
+        point_u32 const imagePartOrigin = aImagePart.position();
+        size_u32 const imagePartExtents = aImagePart.extents();
+        switch (aImage.color_format())
+        {
+        case color_format::RGBA8:
+            {
+                const uint8_t* imageData = static_cast<const uint8_t*>(aImage.cpixels());
+                std::vector<uint8_t> data(imagePartExtents.cx * 4 * imagePartExtents.cy);
+                for (std::size_t y = 0; y < imagePartExtents.cy; ++y)
+                    for (std::size_t x = 0; x < imagePartExtents.cx; ++x)
+                        for (std::size_t c = 0; c < 4; ++c)
+                            data[(imagePartExtents.cy - 1 - y) * imagePartExtents.cx * 4 + x * 4 + c] = imageData[(y + imagePartOrigin.y) * imageExtents.cx * 4 + (x + imagePartOrigin.x) * 4 + c];
+                auto const previousDataType = iDataType;
+                iDataType = texture_data_type::UnsignedByte;
+                set_pixels(rect{ point{}, imagePartExtents }, &data[0]);
+                iDataType = previousDataType;
+            }
+            break;
+        }
+    }
+
+    void software_texture::set_pixel(const point& aPosition, const color& aColor)
+    {
+        point_i32 const position = aPosition;
+        if (position.x >= 0 && position.y >= 0 && position.x < static_cast<int32_t>(iSize.cx) && position.y < static_cast<int32_t>(iSize.cy))
+            iPixels[static_cast<std::size_t>(position.y) * iSize.cx + position.x] = value_type{ aColor.red(), aColor.green(), aColor.blue(), aColor.alpha() };
+    }
+
+    color software_texture::get_pixel(const point& aPosition) const
+    {
+        return read_pixel(aPosition);
+    }
+
+    void* software_texture::handle() const
+    {
+        return const_cast<value_type*>(iPixels.data());
+    }
+
+    bool software_texture::is_resident() const
+    {
+        return true;
+    }
+
+    dimension software_texture::horizontal_dpi() const
+    {
+        return dpi_scale_factor() * 96.0;
+    }
+
+    dimension software_texture::vertical_dpi() const
+    {
+        return dpi_scale_factor() * 96.0;
+    }
+
+    dimension software_texture::ppi() const
+    {
+        return size{ horizontal_dpi(), vertical_dpi() }.magnitude() / std::sqrt(2.0);
+    }
+
+    bool software_texture::metrics_available() const
+    {
+        return true;
+    }
+
+    dimension software_texture::em_size() const
+    {
+        return 0.0;
+    }
+
+    std::unique_ptr<i_rendering_context> software_texture::create_graphics_context(blending_mode aBlendingMode) const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context{ *this, aBlendingMode });
+    }
+
+    int32_t software_texture::bind(const std::optional<uint32_t>&) const
+    {
+        return 0;
+    }
+
+    intptr_t software_texture::native_handle() const
+    {
+        return reinterpret_cast<intptr_t>(handle());
+    }
+
+    i_texture& software_texture::native_texture() const
+    {
+        return const_cast<software_texture&>(*this);
+    }
+
+    render_target_type software_texture::target_type() const
+    {
+        return render_target_type::Texture;
+    }
+
+    void* software_texture::target_handle() const
+    {
+        return handle();
+    }
+
+    void* software_texture::target_device_handle() const
+    {
+        return nullptr;
+    }
+
+    pixel_format_t software_texture::pixel_format() const
+    {
+        return 0;
+    }
+
+    const i_texture& software_texture::target_texture() const
+    {
+        return *this;
+    }
+
+    size software_texture::target_extents() const
+    {
+        return extents();
+    }
+
+    neogfx::logical_coordinate_system software_texture::logical_coordinate_system() const
+    {
+        return iLogicalCoordinateSystem;
+    }
+
+    void software_texture::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem)
+    {
+        iLogicalCoordinateSystem = aSystem;
+    }
+
+    logical_coordinates software_texture::logical_coordinates() const
+    {
+        if (iLogicalCoordinates != std::nullopt)
+            return *iLogicalCoordinates;
+        neogfx::logical_coordinates result;
+        switch (iLogicalCoordinateSystem)
+        {
+        case neogfx::logical_coordinate_system::Specified:
+            throw logical_coordinates_not_specified();
+            break;
+        case neogfx::logical_coordinate_system::AutomaticGui:
+            result.bottomLeft = vec2{ 0.0, extents().cy };
+            result.topRight = vec2{ extents().cx, 0.0 };
+            break;
+        case neogfx::logical_coordinate_system::AutomaticGame:
+            result.bottomLeft = vec2{ 0.0, 0.0 };
+            result.topRight = vec2{ extents().cx, extents().cy };
+            break;
+        }
+        return result;
+    }
+
+    void software_texture::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates)
+    {
+        iLogicalCoordinates = aCoordinates;
+    }
+
+    bool software_texture::target_active() const
+    {
+        return service<i_rendering_engine>().active_target() == this;
+    }
+
+    void software_texture::activate_target() const
+    {
+        if (!target_active())
+        {
+            TargetActivating.trigger();
+            service<i_rendering_engine>().activate_context(*this);
+            TargetActivated.trigger();
+        }
+    }
+
+    void software_texture::deactivate_target() const
+    {
+        if (target_active())
+        {
+            TargetDeactivating.trigger();
+            service<i_rendering_engine>().deactivate_context();
+            TargetDeactivated.trigger();
+            return;
+        }
+        throw not_active();
+    }
+
+    color_space software_texture::color_space() const
+    {
+        return iColorSpace;
+    }
+
+    color software_texture::read_pixel(const point& aPosition) const
+    {
+        auto const pixel = texel(static_cast<int32_t>(aPosition.x), static_cast<int32_t>(aPosition.y));
+        return color{ pixel[0], pixel[1], pixel[2], pixel[3] };
+    }
+
+    uint32_t software_texture::width() const
+    {
+        return iSize.cx;
+    }
+
+    uint32_t software_texture::height() const
+    {
+        return iSize.cy;
+    }
+
+    software_texture::value_type* software_texture::pixels() const
+    {
+        return iPixels.data();
+    }
+
+    software_texture::value_type software_texture::texel(int32_t aX, int32_t aY) const
+    {
+        if (aX < 0 || aY < 0 || aX >= static_cast<int32_t>(iSize.cx) || aY >= static_cast<int32_t>(iSize.cy))
+            return value_type{};
+        return iPixels[static_cast<std::size_t>(aY) * iSize.cx + aX];
+    }
+}
\ No newline at end of file
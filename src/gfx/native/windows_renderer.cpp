@@ -411,6 +411,7 @@ namespace neogfx
         void renderer::render_now()
         {
             service<i_surface_manager>().render_surfaces();
+            next_frame();
         }
 
         bool renderer::use_rendering_priority() const
@@ -34,6 +34,7 @@
 */
 
 #include <neogfx/neogfx.hpp>
+#include <numeric>
 #include <neogfx/gfx/rect_pack.hpp>
 
 namespace neogfx
@@ -71,19 +72,344 @@ namespace neogfx
         return iChildren[0]->insert(aElementSize);
     }
 
-    rect_pack::rect_pack(const size& aDimensions) :
-        iRoot{ rect{ point{}, aDimensions }, iAllocator }
+    bool rect_pack::node::remove(const neogfx::rect& aRect)
     {
+        if (is_leaf())
+        {
+            if (!iInUse || iRect != aRect)
+                return false;
+            iInUse = false;
+            return true;
+        }
+        auto& child = *iChildren[iChildren[0]->rect().contains(aRect) ? 0 : 1];
+        if (!child.remove(aRect))
+            return false;
+        // collapse the split so the space can again be allocated as a whole
+        if (iChildren[0]->is_leaf() && !iChildren[0]->iInUse && iChildren[1]->is_leaf() && !iChildren[1]->iInUse)
+            destroy_children();
+        return true;
+    }
+
+    std::size_t rect_pack::node::free_leaf_count() const
+    {
+        if (is_leaf())
+            return iInUse ? 0u : 1u;
+        return iChildren[0]->free_leaf_count() + iChildren[1]->free_leaf_count();
+    }
+
+    namespace
+    {
+        inline bool overlaps(const rect& aLhs, const rect& aRhs)
+        {
+            return aLhs.x < aRhs.x + aRhs.cx && aRhs.x < aLhs.x + aLhs.cx &&
+                aLhs.y < aRhs.y + aRhs.cy && aRhs.y < aLhs.y + aLhs.cy;
+        }
+
+        inline bool encloses(const rect& aOuter, const rect& aInner)
+        {
+            return aInner.x >= aOuter.x && aInner.y >= aOuter.y &&
+                aInner.x + aInner.cx <= aOuter.x + aOuter.cx && aInner.y + aInner.cy <= aOuter.y + aOuter.cy;
+        }
+    }
+
+    rect_pack::rect_pack(const size& aDimensions, rect_pack_algorithm aAlgorithm) :
+        iAlgorithm{ aAlgorithm },
+        iDimensions{ aDimensions },
+        iUsedArea{ 0.0 },
+        iRoot{ rect{ point{}, aDimensions }, iAllocator },
+        iFreedSinceRebuild{ 0.0 }
+    {
+        if (iAlgorithm == rect_pack_algorithm::MaxRects)
+            iFreeRects.push_back(rect{ point{}, aDimensions });
+        else if (iAlgorithm == rect_pack_algorithm::Skyline)
+            skyline_reset();
+    }
+
+    rect_pack_algorithm rect_pack::algorithm() const
+    {
+        return iAlgorithm;
+    }
+
+    const size& rect_pack::dimensions() const
+    {
+        return iDimensions;
+    }
+
+    dimension rect_pack::used_area() const
+    {
+        return iUsedArea;
+    }
+
+    scalar rect_pack::occupancy() const
+    {
+        auto const area = iDimensions.cx * iDimensions.cy;
+        return area != 0.0 ? iUsedArea / area : 0.0;
+    }
+
+    std::size_t rect_pack::free_rect_count() const
+    {
+        switch (iAlgorithm)
+        {
+        case rect_pack_algorithm::MaxRects:
+            return iFreeRects.size();
+        case rect_pack_algorithm::Skyline:
+            return iSkyline.size();
+        default:
+            return iRoot.free_leaf_count();
+        }
     }
 
     bool rect_pack::insert(const size& aElementSize, rect& aResult)
     {
-        auto result = iRoot.insert(aElementSize);
-        if (result != nullptr)
+        bool inserted = false;
+        if (iAlgorithm == rect_pack_algorithm::MaxRects)
+            inserted = max_rects_insert(aElementSize, aResult);
+        else if (iAlgorithm == rect_pack_algorithm::Skyline)
+            inserted = skyline_insert(aElementSize, aResult);
+        else
         {
-            aResult = result->rect();
-            return true;
+            auto result = iRoot.insert(aElementSize);
+            if (result != nullptr)
+            {
+                aResult = result->rect();
+                inserted = true;
+            }
+        }
+        if (inserted)
+            iUsedArea += aElementSize.cx * aElementSize.cy;
+        return inserted;
+    }
+
+    void rect_pack::remove(const rect& aRect)
+    {
+        if (iAlgorithm == rect_pack_algorithm::MaxRects)
+        {
+            auto existing = std::find(iUsedRects.begin(), iUsedRects.end(), aRect);
+            if (existing == iUsedRects.end())
+                return;
+            *existing = iUsedRects.back();
+            iUsedRects.pop_back();
+            iFreedSinceRebuild += aRect.cx * aRect.cy;
+            max_rects_merge(aRect);
+        }
+        else if (iAlgorithm == rect_pack_algorithm::Skyline)
+        {
+            if (iUsedArea - aRect.cx * aRect.cy <= 0.0)
+                skyline_reset();
+        }
+        else if (!iRoot.remove(aRect))
+            return;
+        iUsedArea = std::max(iUsedArea - aRect.cx * aRect.cy, 0.0);
+    }
+
+    std::size_t rect_pack::insert(const std::vector<size>& aElementSizes, std::vector<optional_rect>& aResults)
+    {
+        thread_local std::vector<std::size_t> order;
+        order.resize(aElementSizes.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t aLhs, std::size_t aRhs)
+        {
+            return std::forward_as_tuple(aElementSizes[aLhs].cy, aElementSizes[aLhs].cx) > std::forward_as_tuple(aElementSizes[aRhs].cy, aElementSizes[aRhs].cx);
+        });
+        aResults.assign(aElementSizes.size(), std::nullopt);
+        std::size_t inserted = 0u;
+        for (auto index : order)
+        {
+            rect result;
+            if (insert(aElementSizes[index], result))
+            {
+                aResults[index] = result;
+                ++inserted;
+            }
+        }
+        return inserted;
+    }
+
+    bool rect_pack::max_rects_insert(const size& aElementSize, rect& aResult)
+    {
+        auto best = iFreeRects.end();
+        auto bestShortSide = std::numeric_limits<dimension>::max();
+        auto bestLongSide = std::numeric_limits<dimension>::max();
+        for (auto freeRect = iFreeRects.begin(); freeRect != iFreeRects.end(); ++freeRect)
+        {
+            if (freeRect->cx < aElementSize.cx || freeRect->cy < aElementSize.cy)
+                continue;
+            auto const leftoverX = freeRect->cx - aElementSize.cx;
+            auto const leftoverY = freeRect->cy - aElementSize.cy;
+            auto const shortSide = std::min(leftoverX, leftoverY);
+            auto const longSide = std::max(leftoverX, leftoverY);
+            if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+            {
+                best = freeRect;
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+            }
+        }
+        if (best == iFreeRects.end())
+        {
+            // freed space may only be usable once recombined with its neighbours; the rebuild is
+            // costly so it is deferred until a worthwhile amount of space has been freed
+            auto const elementArea = aElementSize.cx * aElementSize.cy;
+            auto const pageArea = iDimensions.cx * iDimensions.cy;
+            if (iFreedSinceRebuild == 0.0 || pageArea - iUsedArea < elementArea ||
+                iFreedSinceRebuild < std::min(std::max(elementArea, pageArea * RebuildThreshold), iUsedArea))
+                return false;
+            max_rects_rebuild();
+            return max_rects_insert(aElementSize, aResult);
+        }
+        aResult = rect{ best->top_left(), aElementSize };
+        iUsedRects.push_back(aResult);
+        max_rects_split(aResult);
+        return true;
+    }
+
+    void rect_pack::max_rects_split(const rect& aUsed)
+    {
+        thread_local free_list remainders;
+        remainders.clear();
+        for (std::size_t index = 0u; index < iFreeRects.size();)
+        {
+            auto const freeRect = iFreeRects[index];
+            if (!overlaps(freeRect, aUsed))
+            {
+                ++index;
+                continue;
+            }
+            if (aUsed.x > freeRect.x)
+                remainders.push_back(rect{ point{ freeRect.x, freeRect.y }, size{ aUsed.x - freeRect.x, freeRect.cy } });
+            if (aUsed.x + aUsed.cx < freeRect.x + freeRect.cx)
+                remainders.push_back(rect{ point{ aUsed.x + aUsed.cx, freeRect.y }, size{ freeRect.x + freeRect.cx - (aUsed.x + aUsed.cx), freeRect.cy } });
+            if (aUsed.y > freeRect.y)
+                remainders.push_back(rect{ point{ freeRect.x, freeRect.y }, size{ freeRect.cx, aUsed.y - freeRect.y } });
+            if (aUsed.y + aUsed.cy < freeRect.y + freeRect.cy)
+                remainders.push_back(rect{ point{ freeRect.x, aUsed.y + aUsed.cy }, size{ freeRect.cx, freeRect.y + freeRect.cy - (aUsed.y + aUsed.cy) } });
+            iFreeRects[index] = iFreeRects.back();
+            iFreeRects.pop_back();
+        }
+        // a surviving free rectangle cannot lie within a remainder (it would already have been pruned
+        // against the rectangle the remainder came from) so only the remainders need pruning
+        auto const survivors = iFreeRects.size();
+        for (std::size_t index = 0u; index < remainders.size(); ++index)
+        {
+            auto const& remainder = remainders[index];
+            bool redundant = std::any_of(iFreeRects.begin(), iFreeRects.begin() + survivors, [&](const rect& aFree) { return encloses(aFree, remainder); });
+            for (std::size_t other = 0u; !redundant && other < remainders.size(); ++other)
+                redundant = other != index && encloses(remainders[other], remainder) && (remainders[other] != remainder || other < index);
+            if (!redundant)
+                iFreeRects.push_back(remainder);
+        }
+    }
+
+    void rect_pack::max_rects_merge(rect aFreed)
+    {
+        // grow the freed rectangle by absorbing free rectangles that share a complete edge with it
+        for (bool merged = true; merged;)
+        {
+            merged = false;
+            for (std::size_t index = 0u; index < iFreeRects.size(); ++index)
+            {
+                auto const& freeRect = iFreeRects[index];
+                bool const sameColumn = freeRect.x == aFreed.x && freeRect.cx == aFreed.cx &&
+                    (freeRect.y + freeRect.cy == aFreed.y || aFreed.y + aFreed.cy == freeRect.y);
+                bool const sameRow = freeRect.y == aFreed.y && freeRect.cy == aFreed.cy &&
+                    (freeRect.x + freeRect.cx == aFreed.x || aFreed.x + aFreed.cx == freeRect.x);
+                if (!sameColumn && !sameRow)
+                    continue;
+                aFreed = rect{ point{ std::min(freeRect.x, aFreed.x), std::min(freeRect.y, aFreed.y) },
+                    sameColumn ? size{ aFreed.cx, freeRect.cy + aFreed.cy } : size{ freeRect.cx + aFreed.cx, aFreed.cy } };
+                iFreeRects[index] = iFreeRects.back();
+                iFreeRects.pop_back();
+                merged = true;
+                break;
+            }
+        }
+        iFreeRects.erase(std::remove_if(iFreeRects.begin(), iFreeRects.end(), [&](const rect& aFree) { return encloses(aFreed, aFree); }), iFreeRects.end());
+        if (std::none_of(iFreeRects.begin(), iFreeRects.end(), [&](const rect& aFree) { return encloses(aFree, aFreed); }))
+            iFreeRects.push_back(aFreed);
+    }
+
+    void rect_pack::max_rects_rebuild()
+    {
+        iFreeRects.clear();
+        iFreeRects.push_back(rect{ point{}, iDimensions });
+        for (auto const& used : iUsedRects)
+            max_rects_split(used);
+        iFreedSinceRebuild = 0.0;
+    }
+
+    bool rect_pack::skyline_insert(const size& aElementSize, rect& aResult)
+    {
+        std::optional<std::size_t> best;
+        coordinate bestY = 0.0;
+        auto bestBottom = std::numeric_limits<coordinate>::max();
+        auto bestWidth = std::numeric_limits<dimension>::max();
+        for (std::size_t segment = 0u; segment < iSkyline.size(); ++segment)
+        {
+            coordinate y;
+            if (!skyline_fit(segment, aElementSize, y))
+                continue;
+            auto const bottom = y + aElementSize.cy;
+            if (bottom < bestBottom || (bottom == bestBottom && iSkyline[segment].width < bestWidth))
+            {
+                best = segment;
+                bestY = y;
+                bestBottom = bottom;
+                bestWidth = iSkyline[segment].width;
+            }
+        }
+        if (best == std::nullopt)
+            return false;
+        aResult = rect{ point{ iSkyline[*best].x, bestY }, aElementSize };
+        iSkyline.insert(std::next(iSkyline.begin(), *best), skyline_segment{ aResult.x, bestBottom, aElementSize.cx });
+        // trim the segments now lying beneath the new one
+        for (auto segment = *best + 1u; segment < iSkyline.size();)
+        {
+            auto const previousRight = iSkyline[segment - 1u].x + iSkyline[segment - 1u].width;
+            auto& current = iSkyline[segment];
+            if (current.x >= previousRight)
+                break;
+            auto const overlap = previousRight - current.x;
+            if (current.width <= overlap)
+            {
+                iSkyline.erase(std::next(iSkyline.begin(), segment));
+                continue;
+            }
+            current.x += overlap;
+            current.width -= overlap;
+            break;
+        }
+        for (std::size_t segment = 0u; segment + 1u < iSkyline.size();)
+        {
+            if (iSkyline[segment].y == iSkyline[segment + 1u].y)
+            {
+                iSkyline[segment].width += iSkyline[segment + 1u].width;
+                iSkyline.erase(std::next(iSkyline.begin(), segment + 1u));
+            }
+            else
+                ++segment;
         }
-        return false;
+        return true;
+    }
+
+    bool rect_pack::skyline_fit(std::size_t aSegment, const size& aElementSize, coordinate& aY) const
+    {
+        if (iSkyline[aSegment].x + aElementSize.cx > iDimensions.cx)
+            return false;
+        aY = iSkyline[aSegment].y;
+        auto remaining = aElementSize.cx;
+        for (auto segment = aSegment; remaining > 0.0; ++segment)
+        {
+            aY = std::max(aY, iSkyline[segment].y);
+            if (aY + aElementSize.cy > iDimensions.cy)
+                return false;
+            remaining -= iSkyline[segment].width;
+        }
+        return true;
+    }
+
+    void rect_pack::skyline_reset()
+    {
+        iSkyline.clear();
+        iSkyline.push_back(skyline_segment{ 0.0, 0.0, iDimensions.cx });
     }
 }
\ No newline at end of file
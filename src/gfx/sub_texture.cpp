@@ -201,4 +201,11 @@ namespace neogfx
     {
         return iAtlasLocation;
     }
+
+    void sub_texture::relocate(i_texture& aAtlasTexture, const rect& aAtlasLocation)
+    {
+        iAtlasTexture = &aAtlasTexture;
+        iAtlasLocation = aAtlasLocation;
+        iStorageExtents = aAtlasTexture.storage_extents();
+    }
 }
\ No newline at end of file
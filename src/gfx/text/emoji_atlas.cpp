@@ -82,18 +82,32 @@ namespace neogfx
         catch (...)
         {
         }
+        build_lookup();
     }
 
     bool emoji_atlas::is_emoji(char32_t aCodePoint) const
     {
-        std::u32string str;
-        str += aCodePoint;
-        return is_emoji(str);
+        auto const block = aCodePoint >> CodePointBlockBits;
+        if (block >= iCodePointBlockIndex.size())
+            return false;
+        return iCodePointBlocks[iCodePointBlockIndex[block]][aCodePoint & ((1u << CodePointBlockBits) - 1u)];
     }
 
     bool emoji_atlas::is_emoji(const std::u32string& aCodePoints) const
     {
-        return iEmojiMap.find(aCodePoints) != iEmojiMap.end();
+        return is_emoji(aCodePoints.data(), aCodePoints.data() + aCodePoints.size());
+    }
+
+    bool emoji_atlas::is_emoji(char32_t const* aBegin, char32_t const* aEnd) const
+    {
+        if (aEnd - aBegin == 1)
+            return is_emoji(*aBegin);
+        return aBegin != aEnd && walk_sequence(aBegin, aEnd, false) == static_cast<std::size_t>(aEnd - aBegin);
+    }
+
+    std::size_t emoji_atlas::match_emoji(char32_t const* aBegin, char32_t const* aEnd) const
+    {
+        return walk_sequence(aBegin, aEnd, true);
     }
 
     emoji_atlas::emoji_id emoji_atlas::emoji(char32_t aCodePoint, dimension aDesiredSize) const
@@ -123,4 +137,76 @@ namespace neogfx
     {
         return iTextureAtlas->sub_texture(aId);
     }
+
+    void emoji_atlas::build_lookup()
+    {
+        iCodePointBlockIndex.assign((0x10FFFFu >> CodePointBlockBits) + 1u, 0u);
+        iCodePointBlocks.assign(1u, code_point_block{});
+        for (auto const& e : iEmojis)
+        {
+            if (e.first.size() != 1u || e.first[0] > 0x10FFFFu)
+                continue;
+            auto const block = e.first[0] >> CodePointBlockBits;
+            if (iCodePointBlockIndex[block] == 0u)
+            {
+                iCodePointBlockIndex[block] = static_cast<uint16_t>(iCodePointBlocks.size());
+                iCodePointBlocks.emplace_back();
+            }
+            iCodePointBlocks[iCodePointBlockIndex[block]].set(e.first[0] & ((1u << CodePointBlockBits) - 1u));
+        }
+        iSequenceNodes.assign(1u, sequence_node{ 0u, 0u, false });
+        iSequenceEdges.clear();
+        build_sequence_node(0u, iEmojis.begin(), iEmojis.end(), 0u);
+    }
+
+    void emoji_atlas::build_sequence_node(uint32_t aNode, emojis::const_iterator aFirst, emojis::const_iterator aLast, std::size_t aDepth)
+    {
+        // keys are sorted so those sharing the prefix leading to this node form a contiguous range
+        if (aFirst != aLast && aFirst->first.size() == aDepth)
+        {
+            iSequenceNodes[aNode].terminal = true;
+            ++aFirst;
+        }
+        std::vector<std::pair<emojis::const_iterator, emojis::const_iterator>> children;
+        for (auto child = aFirst; child != aLast;)
+        {
+            auto const codePoint = child->first[aDepth];
+            auto next = std::next(child);
+            while (next != aLast && next->first[aDepth] == codePoint)
+                ++next;
+            children.emplace_back(child, next);
+            child = next;
+        }
+        auto const firstEdge = static_cast<uint32_t>(iSequenceEdges.size());
+        iSequenceNodes[aNode].firstEdge = firstEdge;
+        iSequenceNodes[aNode].edgeCount = static_cast<uint32_t>(children.size());
+        for (auto const& child : children)
+        {
+            iSequenceEdges.push_back(sequence_edge{ child.first->first[aDepth], static_cast<uint32_t>(iSequenceNodes.size()) });
+            iSequenceNodes.push_back(sequence_node{ 0u, 0u, false });
+        }
+        for (std::size_t i = 0u; i < children.size(); ++i)
+            build_sequence_node(iSequenceEdges[firstEdge + i].node, children[i].first, children[i].second, aDepth + 1u);
+    }
+
+    std::size_t emoji_atlas::walk_sequence(char32_t const* aBegin, char32_t const* aEnd, bool aLongest) const
+    {
+        // returns the length of the longest terminal match if aLongest is set, otherwise the length of
+        // the whole input if it reaches a terminal node (or zero)
+        std::size_t result = 0u;
+        uint32_t node = 0u;
+        for (auto next = aBegin; next != aEnd; ++next)
+        {
+            auto const& n = iSequenceNodes[node];
+            auto const edgesBegin = iSequenceEdges.begin() + n.firstEdge;
+            auto const edgesEnd = edgesBegin + n.edgeCount;
+            auto const edge = std::lower_bound(edgesBegin, edgesEnd, *next, [](sequence_edge const& aEdge, char32_t aCodePoint) { return aEdge.codePoint < aCodePoint; });
+            if (edge == edgesEnd || edge->codePoint != *next)
+                return result;
+            node = edge->node;
+            if (iSequenceNodes[node].terminal && (aLongest || next + 1 == aEnd))
+                result = static_cast<std::size_t>(next + 1 - aBegin);
+        }
+        return result;
+    }
 }
\ No newline at end of file
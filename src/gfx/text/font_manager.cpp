@@ -166,15 +166,82 @@ namespace neogfx
         typedef std::vector<cluster> cluster_map_t;
         typedef std::tuple<const char32_t*, const char32_t*, text_direction, bool, hb_script_t> glyph_run;
         typedef std::vector<glyph_run> run_list;
+    private:
+        // Script and direction itemisation is a function of the text and the fonts selected for it so
+        // the key need only hold those plus the context state that alters shaping. The fonts are held
+        // (rather than just their ids) so that a cached id cannot be reused by a different font.
+        struct shaped_text_key
+        {
+            std::u32string text;
+            std::vector<std::pair<std::u32string::size_type, font>> fonts; // font changes: (start, font)
+            bool subpixel;
+            char32_t passwordMask;
+            char32_t mnemonic;
+            bool operator==(const shaped_text_key& aOther) const
+            {
+                if (text != aOther.text || fonts.size() != aOther.fonts.size() ||
+                    subpixel != aOther.subpixel || passwordMask != aOther.passwordMask || mnemonic != aOther.mnemonic)
+                    return false;
+                for (std::size_t i = 0; i < fonts.size(); ++i)
+                    if (fonts[i].first != aOther.fonts[i].first || fonts[i].second.id() != aOther.fonts[i].second.id())
+                        return false;
+                return true;
+            }
+        };
+        struct shaped_text_key_hash
+        {
+            std::size_t operator()(const shaped_text_key& aKey) const
+            {
+                std::size_t result = std::hash<std::u32string>{}(aKey.text);
+                auto combine = [&result](std::size_t aValue) { result ^= aValue + 0x9e3779b9u + (result << 6) + (result >> 2); };
+                for (auto const& f : aKey.fonts)
+                {
+                    combine(f.first);
+                    combine(std::hash<font_id>{}(f.second.id()));
+                }
+                combine(aKey.subpixel ? 1u : 0u);
+                combine(aKey.passwordMask);
+                combine(aKey.mnemonic);
+                return result;
+            }
+        };
+        typedef std::list<const shaped_text_key*> shaped_text_lru;
+        struct shaped_text
+        {
+            glyph_text glyphs;
+            std::size_t bytes;
+            shaped_text_lru::iterator lru;
+        };
+        typedef std::unordered_map<shaped_text_key, shaped_text, shaped_text_key_hash> shaped_text_cache;
+    public:
+        static constexpr std::size_t DefaultCacheBudget = 4u * 1024u * 1024u; // bytes
+        static constexpr std::size_t MaximumCachedTextLength = 4096u; // code points
+    public:
+        glyph_text_factory();
     public:
         glyph_text create_glyph_text(font const& aFont) override;
         glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, i_font_selector const& aFontSelector) override;
         glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector) override;
+    public:
+        glyph_text_cache_stats cache_stats() const override;
+        void set_cache_budget(std::size_t aBytes) override;
+        void clear_cache() override;
+    private:
+        glyph_text shape(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector);
+        void trim_cache();
     private:
         cluster_map_t iClusterMap;
         std::vector<character_type> iTextDirections;
+        std::vector<text_category> iCategories;
         std::u32string iCodePointsBuffer;
         run_list iRuns;
+        shaped_text_key iCacheKey;
+        shaped_text_cache iCache;
+        shaped_text_lru iCacheLru;
+        std::size_t iCacheBytes;
+        std::size_t iCacheBudget;
+        uint64_t iCacheHits;
+        uint64_t iCacheMisses;
     };
 
     class glyph_shapes
@@ -376,6 +443,14 @@ namespace neogfx
         result_type iResults;
     };
 
+    glyph_text_factory::glyph_text_factory() :
+        iCacheBytes{ 0u },
+        iCacheBudget{ DefaultCacheBudget },
+        iCacheHits{ 0u },
+        iCacheMisses{ 0u }
+    {
+    }
+
     glyph_text glyph_text_factory::create_glyph_text(font const& aFont)
     {
         return *make_ref<glyph_text_content>(aFont);
@@ -402,7 +477,81 @@ namespace neogfx
         } });
     }
 
-    glyph_text glyph_text_factory::to_glyph_text(i_graphics_context const& aContext, char32_t const*  aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector)
+    glyph_text glyph_text_factory::to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector)
+    {
+        auto const length = static_cast<std::size_t>(aUtf32End - aUtf32Begin);
+        if (length == 0u || length > MaximumCachedTextLength || iCacheBudget == 0u)
+            return shape(aContext, aUtf32Begin, aUtf32End, aFontSelector);
+
+        auto& key = iCacheKey;
+        key.text.assign(aUtf32Begin, aUtf32End);
+        key.fonts.clear();
+        for (std::size_t i = 0u; i < length; ++i)
+        {
+            auto const f = aFontSelector.select_font(i);
+            if (key.fonts.empty() || key.fonts.back().second.id() != f.id())
+                key.fonts.emplace_back(i, f);
+        }
+        key.subpixel = aContext.is_subpixel_rendering_on();
+        key.passwordMask = aContext.password() ? neolib::utf8_to_utf32(aContext.password_mask())[0] : U'\0';
+        key.mnemonic = aContext.mnemonic_set() ? static_cast<char32_t>(aContext.mnemonic()) : U'\0';
+
+        auto existing = iCache.find(key);
+        if (existing != iCache.end())
+        {
+            ++iCacheHits;
+            iCacheLru.splice(iCacheLru.begin(), iCacheLru, existing->second.lru);
+            // callers are free to modify what they are given so hand out a copy
+            auto refCopy = make_ref<glyph_text_content>(static_cast<glyph_text_content const&>(existing->second.glyphs.content()));
+            return *refCopy;
+        }
+        ++iCacheMisses;
+
+        auto result = shape(aContext, aUtf32Begin, aUtf32End, aFontSelector);
+        auto& content = static_cast<glyph_text_content&>(result.content());
+        for (auto const& g : content)
+            content.cache_glyph_font(g.font);
+        auto const bytes = key.text.size() * sizeof(char32_t) + key.fonts.size() * sizeof(key.fonts[0]) + content.size() * sizeof(glyph) + sizeof(shaped_text_key) + sizeof(shaped_text);
+        if (bytes > iCacheBudget)
+            return result;
+        auto entry = iCache.emplace(key, shaped_text{ *make_ref<glyph_text_content>(static_cast<glyph_text_content const&>(content)), bytes, {} }).first;
+        iCacheLru.push_front(&entry->first);
+        entry->second.lru = iCacheLru.begin();
+        iCacheBytes += bytes;
+        trim_cache();
+        return result;
+    }
+
+    glyph_text_cache_stats glyph_text_factory::cache_stats() const
+    {
+        return glyph_text_cache_stats{ iCache.size(), iCacheBytes, iCacheBudget, iCacheHits, iCacheMisses };
+    }
+
+    void glyph_text_factory::set_cache_budget(std::size_t aBytes)
+    {
+        iCacheBudget = aBytes;
+        trim_cache();
+    }
+
+    void glyph_text_factory::clear_cache()
+    {
+        iCacheLru.clear();
+        iCache.clear();
+        iCacheBytes = 0u;
+    }
+
+    void glyph_text_factory::trim_cache()
+    {
+        while (iCacheBytes > iCacheBudget && !iCacheLru.empty())
+        {
+            auto oldest = iCache.find(*iCacheLru.back());
+            iCacheBytes -= oldest->second.bytes;
+            iCacheLru.pop_back();
+            iCache.erase(oldest);
+        }
+    }
+
+    glyph_text glyph_text_factory::shape(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector)
     {
         auto refResult = make_ref<glyph_text_content>(aFontSelector.select_font(0));
         auto& result = *refResult;
@@ -425,7 +574,10 @@ namespace neogfx
         auto& runs = iRuns;
         runs.clear();
         auto const& emojiAtlas = service<i_font_manager>().emoji_atlas();
-        text_category previousCategory = get_text_category(emojiAtlas, codePoints, codePoints + codePointCount);
+        auto& categories = iCategories;
+        categories.resize(codePointCount);
+        get_text_categories(emojiAtlas, codePoints, codePoints + codePointCount, categories.data());
+        text_category previousCategory = categories[0];
         if (aContext.mnemonic_set() && codePoints[0] == static_cast<char32_t>(aContext.mnemonic()))
             previousCategory = text_category::Mnemonic;
         text_direction previousDirection = (previousCategory != text_category::RTL ? text_direction::LTR : text_direction::RTL);
@@ -469,7 +621,7 @@ namespace neogfx
             }
 
             hb_unicode_funcs_t* unicodeFuncs = static_cast<native_font_face::hb_handle*>(currentFont.native_font_face().aux_handle())->unicodeFuncs;
-            text_category currentCategory = get_text_category(emojiAtlas, codePoints + codePointIndex, codePoints + codePointCount);
+            text_category currentCategory = categories[codePointIndex];
             if (aContext.mnemonic_set() && codePoints[codePointIndex] == static_cast<char32_t>(aContext.mnemonic()))
                 currentCategory = text_category::Mnemonic;
             text_direction currentDirection = previousDirection;
@@ -563,7 +715,7 @@ namespace neogfx
                 {
                     for (std::size_t j = codePointIndex + 1; j <= lastCodePointIndex; ++j)
                     {
-                        text_direction nextDirection = bidi_check(get_text_category(emojiAtlas, codePoints + j, codePoints + codePointCount), get_text_direction(emojiAtlas, codePoints + j, codePoints + codePointCount, currentDirection));
+                        text_direction nextDirection = bidi_check(categories[j], get_text_direction(categories[j], currentDirection));
                         if (nextDirection == text_direction::RTL)
                             break;
                         else if (nextDirection == text_direction::LTR || (j == lastCodePointIndex && currentLineHasLTR))
@@ -751,10 +903,12 @@ namespace neogfx
                             absorbNext = true;
                             break;
                         }
-                        else if (service<i_font_manager>().emoji_atlas().is_emoji(sequence + ch))
-                            sequence += ch;
-                        else
+                        sequence.push_back(ch);
+                        if (!emojiAtlas.is_emoji(sequence.data(), sequence.data() + sequence.size()))
+                        {
+                            sequence.pop_back();
                             break;
+                        }
                     }
                     if (sequence.size() > 1 && service<i_font_manager>().emoji_atlas().is_emoji(sequence))
                     {
@@ -782,7 +936,7 @@ namespace neogfx
 
     font_manager::font_manager() :
         iGlyphTextFactory{ std::make_unique<neogfx::glyph_text_factory>() },
-        iGlyphAtlas{ size{1024.0, 1024.0} },
+        iGlyphAtlas{ size{1024.0, 1024.0}, rect_pack_algorithm::Skyline },
         iEmojiAtlas{}
     {
         FT_Error error = FT_Init_FreeType(&iFontLib);
@@ -22,11 +22,12 @@
 #include <neogfx/neogfx.hpp>
 #include <neogfx/gfx/texture_atlas.hpp>
 #include <neogfx/gfx/image.hpp>
+#include <neogfx/gfx/graphics_context.hpp>
 
 namespace neogfx
 {
-    texture_atlas::texture_atlas(const size& aPageSize) :
-        iTextureManager{ service<i_texture_manager>() }, iPageSize{ aPageSize }
+    texture_atlas::texture_atlas(const size& aPageSize, rect_pack_algorithm aAlgorithm) :
+        iTextureManager{ service<i_texture_manager>() }, iPageSize{ aPageSize }, iAlgorithm{ aAlgorithm }, iRelocationEnabled{ false }
     {
     }
 
@@ -80,15 +81,58 @@ namespace neogfx
         auto iterEntry = iEntries.find(aSubTexture.atlas_id());
         if (iterEntry == iEntries.end() || &aSubTexture != &iterEntry->second.second)
             throw sub_texture_not_found();
-        auto rectEntry = iterEntry->second.second.atlas_location();
-        auto space = iterEntry->second.first->second.used.find(rectEntry);
-        if (space != iterEntry->second.first->second.used.end())
-            iterEntry->second.first->second.used.erase(space);
-        iterEntry->second.first->second.freed.insert(rectEntry);
+        iterEntry->second.first->second.remove(iterEntry->second.second.atlas_location() + point{ -1.0, -1.0 } + size{ 2.0, 2.0 });
         iTextureManager.remove_sub_texture(aSubTexture);
         iEntries.erase(iterEntry);
     }
 
+    uint32_t texture_atlas::page_count() const
+    {
+        return static_cast<uint32_t>(iPages.size());
+    }
+
+    texture_atlas_page_stats texture_atlas::page_stats(uint32_t aPageIndex) const
+    {
+        auto const& page = *std::next(iPages.begin(), aPageIndex);
+        return texture_atlas_page_stats{
+            page.second.pack.dimensions(),
+            page.second.pack.used_area(),
+            page.second.pack.occupancy(),
+            page.second.count,
+            static_cast<uint32_t>(page.second.pack.free_rect_count()) };
+    }
+
+    bool texture_atlas::relocation_enabled() const
+    {
+        return iRelocationEnabled;
+    }
+
+    void texture_atlas::enable_relocation(bool aEnable)
+    {
+        iRelocationEnabled = aEnable;
+    }
+
+    uint32_t texture_atlas::compact(scalar aMaximumOccupancy)
+    {
+        // repacking appends pages so only visit those that existed on entry
+        std::vector<pages::iterator> existingPages;
+        existingPages.reserve(iPages.size());
+        for (auto iterPage = iPages.begin(); iterPage != iPages.end(); ++iterPage)
+            existingPages.push_back(iterPage);
+        uint32_t result = 0u;
+        for (auto iterPage : existingPages)
+        {
+            if (iterPage->second.count == 0u)
+            {
+                iPages.erase(iterPage);
+                ++result;
+            }
+            else if (iRelocationEnabled && iterPage->second.pack.occupancy() < aMaximumOccupancy && iterPage->first.is_render_target() && repack_page(iterPage))
+                ++result;
+        }
+        return result;
+    }
+
     const size& texture_atlas::page_size() const
     {
         return iPageSize;
@@ -96,7 +140,7 @@ namespace neogfx
 
     texture_atlas::pages::iterator texture_atlas::create_page(dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat)
     {
-        return iPages.insert(iPages.end(), page{ texture{ page_size(), aDpiScaleFactor, aSampling, aDataFormat }, fragments{ page_size() } });
+        return iPages.insert(iPages.end(), page{ texture{ page_size(), aDpiScaleFactor, aSampling, aDataFormat }, fragments{ page_size(), iAlgorithm } });
     }
 
     std::pair<texture_atlas::pages::iterator, rect> texture_atlas::allocate_space(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat)
@@ -113,4 +157,48 @@ namespace neogfx
         iPages.erase(iterPage);
         throw texture_too_big_for_atlas();
     }
+
+    bool texture_atlas::repack_page(pages::iterator aPage)
+    {
+        std::vector<entries::iterator> residents;
+        for (auto iterEntry = iEntries.begin(); iterEntry != iEntries.end(); ++iterEntry)
+            if (iterEntry->second.first == aPage)
+                residents.push_back(iterEntry);
+        // tallest first packs most densely
+        std::sort(residents.begin(), residents.end(), [](entries::iterator aLhs, entries::iterator aRhs)
+        {
+            auto const& lhs = aLhs->second.second.atlas_location();
+            auto const& rhs = aRhs->second.second.atlas_location();
+            return std::forward_as_tuple(lhs.cy, lhs.cx) > std::forward_as_tuple(rhs.cy, rhs.cx);
+        });
+        auto newPage = create_page(aPage->first.dpi_scale_factor(), aPage->first.sampling(), aPage->first.data_format());
+        std::vector<rect> destinations;
+        destinations.reserve(residents.size());
+        for (auto const& resident : residents)
+        {
+            rect destination;
+            if (!newPage->second.insert(resident->second.second.atlas_location().extents() + size{ 2.0, 2.0 }, destination))
+            {
+                iPages.erase(newPage);
+                return false;
+            }
+            destinations.push_back(destination);
+        }
+        {
+            newPage->first.as_render_target().set_logical_coordinate_system(logical_coordinate_system::AutomaticGui);
+            graphics_context gc{ newPage->first };
+            scoped_render_target srt{ gc };
+            scoped_blending_mode sbm{ gc, blending_mode::Blit };
+            for (std::size_t index = 0u; index < residents.size(); ++index)
+                gc.draw_texture(destinations[index].top_left(), aPage->first,
+                    residents[index]->second.second.atlas_location() + point{ -1.0, -1.0 } + size{ 2.0, 2.0 });
+        }
+        for (std::size_t index = 0u; index < residents.size(); ++index)
+        {
+            residents[index]->second.first = newPage;
+            residents[index]->second.second.relocate(newPage->first, destinations[index] + point{ 1.0, 1.0 } + size{ -2.0, -2.0 });
+        }
+        iPages.erase(aPage);
+        return true;
+    }
 }
\ No newline at end of file
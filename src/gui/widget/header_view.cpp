@@ -19,11 +19,8 @@
 
 #include <neogfx/neogfx.hpp>
 #include <neolib/task/timer.hpp>
-#include <neolib/core/lifetime.hpp>
-#include <neolib/task/thread.hpp>
 #include <neogfx/app/i_app.hpp>
 #include <neogfx/app/action.hpp>
-#include <neogfx/app/event_processing_context.hpp>
 #include <neogfx/gfx/graphics_context.hpp>
 #include <neogfx/gui/layout/i_layout.hpp>
 #include <neogfx/gui/widget/header_view.hpp>
@@ -53,56 +50,40 @@ namespace neogfx
         header_view& iParent;
     };
 
+    // Section widths come from the presentation model's column widths (which honour its width strategy and only
+    // measure rows added or changed since they were last requested) so updates are coalesced rather than scanning
+    // every row.
     class header_view::updater : public neolib::callback_timer
     {
     public:
         updater(header_view& aParent) :
             neolib::callback_timer{ service<i_async_task>(), [this, &aParent](neolib::callback_timer&)
             {
-                destroyed_flag destroyed{ *this };
-                destroyed_flag surfaceDestroyed{ aParent.surface() };
-                if (destroyed || surfaceDestroyed)
-                    return;
                 if (!aParent.has_presentation_model())
                 {
                     again();
                     return;
                 }
-                for (auto& sw : aParent.iSectionWidths)
-                {
-                    sw.calculated = 0.0;
-                    sw.max = 0.0;
-                }
-                if (iRow == 0)
+                if (std::exchange(iUpdateButtons, false))
                     aParent.update_buttons();
-                uint64_t since = neolib::thread::program_elapsed_ms();
-                event_processing_context epc{ service<i_async_task>(), "neogfx::header_view::updater" };
-                graphics_context gc{ aParent, graphics_context::type::Unattached };
-                for (uint32_t c = 0; c < 1000 && iRow < aParent.presentation_model().rows(); ++c, ++iRow)
-                {
-                    aParent.update_from_row(iRow, gc);
-                    if (c % 25 == 0 && neolib::thread::program_elapsed_ms() - since > 20)
-                    {
-                        aParent.iOwner.header_view_updated(aParent, header_view_update_reason::FullUpdate);
-                        service<i_app>().process_events(epc);
-                        if (destroyed || surfaceDestroyed)
-                            return;
-                        since = neolib::thread::program_elapsed_ms();
-                    }
-                }
-                if (iRow == aParent.presentation_model().rows())
-                    aParent.iOwner.header_view_updated(aParent, header_view_update_reason::FullUpdate);
                 else
-                    again();
+                    aParent.update_section_widths();
             }, std::chrono::milliseconds{ 10 } },
-            iRow{ 0 }
+            iUpdateButtons{ true }
         {
         }
         ~updater()
         {
             cancel();
         }
-        uint32_t iRow;
+    public:
+        void request(bool aUpdateButtons)
+        {
+            iUpdateButtons = iUpdateButtons || aUpdateButtons;
+            again_if();
+        }
+    private:
+        bool iUpdateButtons;
     };
 
     header_view::header_view(i_header_view_owner& aOwner, header_view_type aType) :
@@ -174,8 +155,7 @@ namespace neogfx
             iSectionWidths.resize(presentation_model().columns());
             presentation_model().set_item_model(model());
         }
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(true);
         update();
     }
 
@@ -210,15 +190,16 @@ namespace neogfx
         iPresentationModel = aPresentationModel;
         if (has_presentation_model())
         {
-            presentation_model().column_info_changed([this](item_presentation_model_index::column_type aColumnIndex) { column_info_changed(aColumnIndex); });
-            presentation_model().item_model_changed([this](const i_item_model& aItemModel) { item_model_changed(aItemModel); });
-            presentation_model().item_added([this](item_presentation_model_index const& aItemIndex) { item_added(aItemIndex); });
-            presentation_model().item_changed([this](item_presentation_model_index const& aItemIndex) { item_changed(aItemIndex); });
-            presentation_model().item_removed([this](item_presentation_model_index const& aItemIndex) { item_removed(aItemIndex); });
-            presentation_model().items_sorting([this]() { items_sorting(); });
-            presentation_model().items_sorted([this]() { items_sorted(); });
-            presentation_model().items_filtering([this]() { items_filtering(); });
-            presentation_model().items_filtered([this]() { items_filtered(); });
+            iPresentationModelSink += presentation_model().column_info_changed([this](item_presentation_model_index::column_type aColumnIndex) { column_info_changed(aColumnIndex); });
+            iPresentationModelSink += presentation_model().item_model_changed([this](const i_item_model& aItemModel) { item_model_changed(aItemModel); });
+            iPresentationModelSink += presentation_model().item_added([this](item_presentation_model_index const& aItemIndex) { item_added(aItemIndex); });
+            iPresentationModelSink += presentation_model().item_changed([this](item_presentation_model_index const& aItemIndex) { item_changed(aItemIndex); });
+            iPresentationModelSink += presentation_model().item_removed([this](item_presentation_model_index const& aItemIndex) { item_removed(aItemIndex); });
+            iPresentationModelSink += presentation_model().items_sorting([this]() { items_sorting(); });
+            iPresentationModelSink += presentation_model().items_sorted([this]() { items_sorted(); });
+            iPresentationModelSink += presentation_model().items_filtering([this]() { items_filtering(); });
+            iPresentationModelSink += presentation_model().items_filtered([this]() { items_filtered(); });
+            iPresentationModelSink += presentation_model().visual_appearance_changed([this]() { request_update(false); });
             if (has_model())
                 presentation_model().set_item_model(model());
         }
@@ -234,47 +215,38 @@ namespace neogfx
         if (iExpandLastColumn != aExpandLastColumn)
         {
             iExpandLastColumn = aExpandLastColumn;
-            iUpdater.reset();
-            iUpdater.reset(new updater(*this));
+            request_update(true);
         }
     }
 
     void header_view::column_info_changed(item_presentation_model_index::column_type)
     {
         update_buttons();
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(true);
     }
 
     void header_view::item_model_changed(const i_item_model&)
     {
         iSectionWidths.resize(presentation_model().columns());
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(true);
     }
 
     void header_view::item_added(item_presentation_model_index const&)
     {
         iSectionWidths.resize(presentation_model().columns());
-        /* todo : optimize (don't do full update) */
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(false);
     }
 
     void header_view::item_changed(item_presentation_model_index const&)
     {
         iSectionWidths.resize(presentation_model().columns());
-        /* todo : optimize (don't do full update) */
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(false);
     }
 
     void header_view::item_removed(item_presentation_model_index const&)
     {
         iSectionWidths.resize(presentation_model().columns());
-        /* todo : optimize (don't do full update) */
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(false);
     }
 
     void header_view::items_sorting()
@@ -283,8 +255,7 @@ namespace neogfx
 
     void header_view::items_sorted()
     {
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(false);
     }
 
     void header_view::items_filtering()
@@ -293,8 +264,7 @@ namespace neogfx
 
     void header_view::items_filtered()
     {
-        iUpdater.reset();
-        iUpdater.reset(new updater(*this));
+        request_update(false);
     }
 
     dimension header_view::separator_width() const
@@ -394,10 +364,7 @@ namespace neogfx
         iSink += service<i_app>().current_style_changed([this](style_aspect aAspect)
         {
             if ((aAspect & (style_aspect::Geometry | style_aspect::Font)) != style_aspect::None)
-            {
-                iUpdater.reset();
-                iUpdater.reset(new updater(*this));
-            }
+                request_update(true);
         });
     }
 
@@ -504,30 +471,42 @@ namespace neogfx
                 button.enable(false);
             }
         }
-        bool updated = false;
-        graphics_context gc{ *this, graphics_context::type::Unattached };
-        for (uint32_t col = 0; col < presentation_model().columns(); ++col)
-            updated = update_section_width(col, size{ iSectionWidths[col].max }, gc) || updated;
-        if (updated)
-            layout_items();
-        iOwner.header_view_updated(*this, header_view_update_reason::FullUpdate);
+        update_section_widths();
+    }
+
+    void header_view::request_update(bool aUpdateButtons)
+    {
+        if (!iUpdater)
+            iUpdater.reset(new updater(*this));
+        else
+            iUpdater->request(aUpdateButtons);
     }
 
-    void header_view::update_from_row(uint32_t aRow, i_graphics_context& aGc)
+    void header_view::update_section_widths()
     {
+        if (!has_presentation_model())
+            return;
+        if (iSectionWidths.size() != presentation_model().columns() || layout().count() < presentation_model().columns())
+        {
+            update_buttons();
+            return;
+        }
         bool updated = false;
-        for (uint32_t col = 0; col < presentation_model().columns(item_presentation_model_index{ aRow }); ++col)
-            updated = update_section_width(col, presentation_model().cell_extents(item_presentation_model_index{ aRow, col }, aGc) + presentation_model().cell_padding(*this).size() * 2.0, aGc) || updated;
+        graphics_context gc{ *this, graphics_context::type::Unattached };
+        for (uint32_t col = 0; col < presentation_model().columns(); ++col)
+            updated = update_section_width(col, gc) || updated;
         if (updated)
             layout_items();
+        iOwner.header_view_updated(*this, header_view_update_reason::FullUpdate);
     }
 
-    bool header_view::update_section_width(uint32_t aColumn, const size& aCellExtents, i_graphics_context& aGc)
+    bool header_view::update_section_width(uint32_t aColumn, i_graphics_context& aGc)
     {
-        dimension headingWidth = presentation_model().column_heading_extents(aColumn, aGc).cx + presentation_model().cell_padding(*this).size().cx * 2.0;
+        dimension const padding = presentation_model().cell_padding(*this).size().cx * 2.0;
+        dimension const headingWidth = presentation_model().column_heading_extents(aColumn, aGc).cx + padding;
+        dimension const cellWidth = presentation_model().column_width(aColumn, aGc, false) + padding;
         dimension oldSectionWidth = iSectionWidths[aColumn].calculated;
-        iSectionWidths[aColumn].max = std::max(iSectionWidths[aColumn].max, units_converter(*this).to_device_units(aCellExtents.cx));
-        iSectionWidths[aColumn].calculated = std::max(iSectionWidths[aColumn].calculated, units_converter(*this).to_device_units(std::max(headingWidth, aCellExtents.cx)));
+        iSectionWidths[aColumn].calculated = units_converter(*this).to_device_units(std::max(headingWidth, cellWidth));
         if (section_width(aColumn) != oldSectionWidth || layout().get_widget_at(aColumn).minimum_size().cx != section_width(aColumn, true))
         {
             layout().get_widget_at(aColumn).set_fixed_size({}, false);
@@ -150,12 +150,20 @@ namespace neogfx
             iPresentationModelSink += presentation_model().item_expanded([this](item_presentation_model_index const& aItemIndex) { invalidate_item(aItemIndex); });
             iPresentationModelSink += presentation_model().item_collapsed([this](item_presentation_model_index const& aItemIndex) { invalidate_item(aItemIndex); });
             iPresentationModelSink += presentation_model().item_toggled([this](item_presentation_model_index const& aItemIndex) { update(cell_rect(aItemIndex, cell_part::Background)); });
+            iPresentationModelSink += presentation_model().row_moved([this](item_presentation_model_index::row_type, item_presentation_model_index::row_type) { update(); });
             iPresentationModelSink += presentation_model().items_sorting([this]() { items_sorting(); });
             iPresentationModelSink += presentation_model().items_sorted([this]() { items_sorted(); });
             iPresentationModelSink += presentation_model().items_filtering([this]() { items_filtering(); });
             iPresentationModelSink += presentation_model().items_filtered([this]() { items_filtered(); });
+            iPresentationModelSink += presentation_model().visual_appearance_changed([this]()
+            {
+                update_scrollbar_visibility();
+                update();
+                measure_column_widths();
+            });
         }
         presentation_model_changed();
+        measure_column_widths();
         update();
     }
 
@@ -582,6 +590,12 @@ namespace neogfx
     bool item_view::key_pressed(scan_code_e aScanCode, key_code_e aKeyCode, key_modifiers_e aKeyModifiers)
     {
         bool handled = true;
+        if (aScanCode == ScanCode_A && (aKeyModifiers & KeyModifier_CTRL) != KeyModifier_NONE && editing() == std::nullopt &&
+            selection_model().mode() == item_selection_mode::ExtendedSelection)
+        {
+            selection_model().select_all();
+            return true;
+        }
         if (selection_model().has_current_index())
         {
             item_presentation_model_index currentIndex = selection_model().current_index();
@@ -668,7 +682,15 @@ namespace neogfx
             if (aScanCode == ScanCode_SPACE)
                 select(newIndex, aKeyModifiers);
             else if (newIndex != currentIndex)
-                select(newIndex, item_selection_operation::None);
+            {
+                if ((aKeyModifiers & KeyModifier_SHIFT) != KeyModifier_NONE && selection_model().mode() == item_selection_mode::ExtendedSelection)
+                    select(newIndex, aKeyModifiers);
+                else
+                {
+                    iSelectionAnchor = std::nullopt;
+                    select(newIndex, item_selection_operation::None);
+                }
+            }
         }
         else
         {
@@ -790,13 +812,16 @@ namespace neogfx
 
     void item_view::item_model_changed(const i_item_model&)
     {
+        iSelectionAnchor = std::nullopt;
         update_scrollbar_visibility();
         update();
+        measure_column_widths();
     }
 
     void item_view::item_added(item_presentation_model_index const& aItemIndex)
     {
         invalidate_item(aItemIndex);
+        measure_column_widths();
     }
 
     void item_view::item_changed(item_presentation_model_index const& aItemIndex)
@@ -822,6 +847,7 @@ namespace neogfx
             select(presentation_model().from_item_model_index(*iSavedModelIndex));
         iSavedModelIndex = std::nullopt;
         update();
+        measure_column_widths();
     }
 
     void item_view::items_filtering()
@@ -835,6 +861,7 @@ namespace neogfx
             select(item_presentation_model_index{});
         update_scrollbar_visibility();
         update();
+        measure_column_widths();
     }
 
     void item_view::presentation_model_added(i_item_presentation_model&)
@@ -1383,6 +1410,23 @@ namespace neogfx
             iHoverCell = std::nullopt;
     }
 
+    void item_view::measure_column_widths()
+    {
+        if (!has_presentation_model() || presentation_model().width_strategy() != i_item_presentation_model::column_width_strategy::Progressive)
+            return;
+        if (iColumnWidthMeasurer)
+        {
+            iColumnWidthMeasurer->again();
+            return;
+        }
+        iColumnWidthMeasurer.emplace(service<i_async_task>(), [this](neolib::callback_timer& aTimer)
+        {
+            graphics_context gc{ *this, graphics_context::type::Unattached };
+            if (has_presentation_model() && presentation_model().measure_column_widths(gc, 250u))
+                aTimer.again();
+        }, std::chrono::milliseconds{ 10 });
+    }
+
     void item_view::update_hover(const optional_point& aPosition)
     {
         auto oldHoverCell = iHoverCell;
@@ -1424,6 +1468,18 @@ namespace neogfx
 
     void item_view::select(item_presentation_model_index const& aItemIndex, key_modifiers_e aKeyModifiers)
     {
+        if ((aKeyModifiers & KeyModifier_SHIFT) != KeyModifier_NONE && selection_model().mode() == item_selection_mode::ExtendedSelection)
+        {
+            // extend from the anchor (the current index when the range was started) as a single range operation
+            if (iSelectionAnchor == std::nullopt || !presentation_model().has_item_model_index(*iSelectionAnchor))
+                iSelectionAnchor = presentation_model().to_item_model_index(
+                    selection_model().has_current_index() ? selection_model().current_index() : aItemIndex);
+            selection_model().set_current_index(aItemIndex);
+            selection_model().select(presentation_model().from_item_model_index(*iSelectionAnchor), aItemIndex,
+                (aKeyModifiers & KeyModifier_CTRL) != KeyModifier_NONE ? item_selection_operation::Select : item_selection_operation::ClearAndSelect);
+            return;
+        }
+        iSelectionAnchor = std::nullopt;
         select(aItemIndex, to_selection_operation(aKeyModifiers));
     }
 
@@ -29,7 +29,8 @@ namespace neogfx
     list_view::list_view(bool aCreateDefaultModels, frame_style aFrameStyle, neogfx::scrollbar_style aScrollbarStyle) :
         item_view{ aFrameStyle, aScrollbarStyle },
         iLayout{ *this },
-        iSpacer{ iLayout }
+        iSpacer{ iLayout },
+        iUniformRowHeights{ false }
     {
         layout().set_size_policy(size_constraint::Expanding);
         layout().set_padding(neogfx::padding{});
@@ -44,7 +45,8 @@ namespace neogfx
     list_view::list_view(i_widget& aParent, bool aCreateDefaultModels, frame_style aFrameStyle, neogfx::scrollbar_style aScrollbarStyle) :
         item_view{ aParent, aFrameStyle, aScrollbarStyle },
         iLayout{ *this },
-        iSpacer{ iLayout }
+        iSpacer{ iLayout },
+        iUniformRowHeights{ false }
     {
         layout().set_size_policy(size_constraint::Expanding);
         layout().set_padding(neogfx::padding{});
@@ -59,7 +61,8 @@ namespace neogfx
     list_view::list_view(i_layout& aLayout, bool aCreateDefaultModels, frame_style aFrameStyle, neogfx::scrollbar_style aScrollbarStyle) :
         item_view{ aLayout, aFrameStyle, aScrollbarStyle },
         iLayout{ *this },
-        iSpacer{ iLayout }
+        iSpacer{ iLayout },
+        iUniformRowHeights{ false }
     {
         layout().set_size_policy(size_constraint::Expanding);
         layout().set_padding(neogfx::padding{});
@@ -80,6 +83,25 @@ namespace neogfx
         return true;
     }
 
+    bool list_view::uniform_row_heights() const
+    {
+        return iUniformRowHeights;
+    }
+
+    void list_view::set_uniform_row_heights(bool aUniformRowHeights)
+    {
+        if (iUniformRowHeights != aUniformRowHeights)
+        {
+            iUniformRowHeights = aUniformRowHeights;
+            if (has_presentation_model())
+            {
+                presentation_model().set_uniform_row_heights(iUniformRowHeights);
+                update_scrollbar_visibility();
+                update();
+            }
+        }
+    }
+
     void list_view::model_changed()
     {
         update_scrollbar_visibility();
@@ -87,6 +109,8 @@ namespace neogfx
 
     void list_view::presentation_model_changed()
     {
+        if (iUniformRowHeights)
+            presentation_model().set_uniform_row_heights(true);
         update_scrollbar_visibility();
     }
 
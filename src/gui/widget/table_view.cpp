@@ -29,7 +29,8 @@ namespace neogfx
         item_view{ aFrameStyle, aScrollbarStyle },
         iLayout{ *this },
         iColumnHeader{ iLayout, *this },
-        iSpacer{ iLayout }
+        iSpacer{ iLayout },
+        iUniformRowHeights{ false }
     {
         layout().set_padding(neogfx::padding{});
         if (aCreateDefaultModels)
@@ -44,7 +45,8 @@ namespace neogfx
         item_view{ aParent, aFrameStyle, aScrollbarStyle },
         iLayout{ *this },
         iColumnHeader{ iLayout, *this },
-        iSpacer{ iLayout }
+        iSpacer{ iLayout },
+        iUniformRowHeights{ false }
     {
         layout().set_padding(neogfx::padding{});
         if (aCreateDefaultModels)
@@ -59,7 +61,8 @@ namespace neogfx
         item_view{ aLayout, aFrameStyle, aScrollbarStyle },
         iLayout{ *this },
         iColumnHeader{ iLayout, *this },
-        iSpacer{ iLayout }
+        iSpacer{ iLayout },
+        iUniformRowHeights{ false }
     {
         layout().set_padding(neogfx::padding{});
         if (aCreateDefaultModels)
@@ -79,6 +82,25 @@ namespace neogfx
         return true;
     }
 
+    bool table_view::uniform_row_heights() const
+    {
+        return iUniformRowHeights;
+    }
+
+    void table_view::set_uniform_row_heights(bool aUniformRowHeights)
+    {
+        if (iUniformRowHeights != aUniformRowHeights)
+        {
+            iUniformRowHeights = aUniformRowHeights;
+            if (has_presentation_model())
+            {
+                presentation_model().set_uniform_row_heights(iUniformRowHeights);
+                update_scrollbar_visibility();
+                update();
+            }
+        }
+    }
+
     const header_view& table_view::column_header() const
     {
         return iColumnHeader;
@@ -98,6 +120,8 @@ namespace neogfx
     void table_view::presentation_model_changed()
     {
         column_header().set_presentation_model(presentation_model());
+        if (iUniformRowHeights)
+            presentation_model().set_uniform_row_heights(true);
         update_scrollbar_visibility();
     }
 
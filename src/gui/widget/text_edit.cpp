@@ -239,10 +239,16 @@ namespace neogfx
     class text_edit::multiple_text_changes
     {
     public:
-        multiple_text_changes(text_edit& aOwner) : 
+        multiple_text_changes(text_edit& aOwner, bool aTyping = false) : 
             iOwner(aOwner)
         {
-            ++iOwner.iSuppressTextChangedNotification;
+            if (iOwner.iSuppressTextChangedNotification++ == 0u)
+            {
+                iOwner.iUndoGroupOpen = false;
+                // only typing may coalesce into a preceding typing step
+                if (!aTyping && !iOwner.iUndoStack.empty())
+                    iOwner.iUndoStack.back().typing = false;
+            }
         }
         ~multiple_text_changes()
         {
@@ -262,6 +268,11 @@ namespace neogfx
         framed_scrollable_widget{ aType == MultiLine ? scrollbar_style::Normal : scrollbar_style::Invisible, aFrameStyle },
         iType{ aType },
         iPersistDefaultStyle{ false },
+        iUndoPosition{ 0u },
+        iUndoMemory{ 0u },
+        iUndoing{ false },
+        iUndoGroupOpen{ false },
+        iShapingEnd{ 0u },
         iGlyphColumns{ 1 },
         iCursorAnimationStartTime{ neolib::thread::program_elapsed_ms() },
         iTabStopHint{ "0000" },
@@ -272,7 +283,8 @@ namespace neogfx
         }, std::chrono::milliseconds{ 16 } },
         iSuppressTextChangedNotification{ 0u },
         iWantedToNotfiyTextChanged{ 0u },
-        iOutOfMemory{ false }
+        iOutOfMemory{ false },
+        iLazyWrapping{ false }
     {
         init();
     }
@@ -281,6 +293,11 @@ namespace neogfx
         framed_scrollable_widget{ aParent, aType == MultiLine ? scrollbar_style::Normal : scrollbar_style::Invisible, aFrameStyle },
         iType{ aType },
         iPersistDefaultStyle{ false },
+        iUndoPosition{ 0u },
+        iUndoMemory{ 0u },
+        iUndoing{ false },
+        iUndoGroupOpen{ false },
+        iShapingEnd{ 0u },
         iGlyphColumns{ 1 },
         iCursorAnimationStartTime{ neolib::thread::program_elapsed_ms() },
         iTabStopHint{ "0000" },
@@ -291,7 +308,8 @@ namespace neogfx
         }, std::chrono::milliseconds{ 16 } },
         iSuppressTextChangedNotification{ 0u },
         iWantedToNotfiyTextChanged{ 0u },
-        iOutOfMemory{ false }
+        iOutOfMemory{ false },
+        iLazyWrapping{ false }
     {
         init();
     }
@@ -300,6 +318,11 @@ namespace neogfx
         framed_scrollable_widget{ aLayout, aType == MultiLine ? scrollbar_style::Normal : scrollbar_style::Invisible, aFrameStyle },
         iType{ aType },
         iPersistDefaultStyle{ false },
+        iUndoPosition{ 0u },
+        iUndoMemory{ 0u },
+        iUndoing{ false },
+        iUndoGroupOpen{ false },
+        iShapingEnd{ 0u },
         iGlyphColumns{ 1 },
         iCursorAnimationStartTime{ neolib::thread::program_elapsed_ms() },
         iTabStopHint{ "0000" },
@@ -310,7 +333,8 @@ namespace neogfx
         }, std::chrono::milliseconds{ 16 } },
         iSuppressTextChangedNotification{ 0u },
         iWantedToNotfiyTextChanged{ 0u },
-        iOutOfMemory{ false }
+        iOutOfMemory{ false },
+        iLazyWrapping{ false }
     {
         init();
     }
@@ -408,15 +432,12 @@ namespace neogfx
             scoped_scissor scissor2{ aGc, columnClipRect };
             auto const& columnRectSansPadding = column_rect(columnIndex);
             auto const& lines = column.lines();
-            auto line = std::lower_bound(lines.begin(), lines.end(), glyph_line{ {}, {}, {}, vertical_scrollbar().position(), {} },
-                [](const glyph_line& left, const glyph_line& right) { return left.ypos < right.ypos; });
-            if (line != lines.begin() && (line == lines.end() || line->ypos > vertical_scrollbar().position()))
-                --line;
+            auto line = column.line_at(vertical_scrollbar().position());
             if (line == lines.end())
                 continue;
-            auto y = line->ypos;
-            for (auto paintLine = line; paintLine != lines.end(); y += (paintLine++)->extents.cy)
+            for (auto paintLine = line; paintLine != lines.end(); ++paintLine)
             {
+                auto const y = column.ypos(paintLine);
                 point linePos = columnRectSansPadding.top_left() + point{ -horizontal_scrollbar().position(), y - vertical_scrollbar().position() };
                 if (linePos.y + paintLine->extents.cy < columnRectSansPadding.top() || linePos.y + paintLine->extents.cy < update_rect().top())
                     continue;
@@ -688,7 +709,7 @@ namespace neogfx
             else
                 return framed_scrollable_widget::text_input(aText);
         }
-        multiple_text_changes mtc{ *this };
+        multiple_text_changes mtc{ *this, cursor().position() == cursor().anchor() };
         delete_any_selection();
         insert_text(aText, next_style(), true);
         return true;
@@ -772,12 +793,12 @@ namespace neogfx
 
     bool text_edit::can_undo() const
     {
-        return iPreviousText != iText;
+        return iUndoPosition > 0u;
     }
 
     bool text_edit::can_redo() const
     {
-        return iPreviousText != iText;
+        return iUndoPosition < iUndoStack.size();
     }
 
     bool text_edit::can_cut() const
@@ -807,21 +828,34 @@ namespace neogfx
 
     void text_edit::undo(i_clipboard&)
     {
-        // todo: more intelligent undo
-        iText.swap(iPreviousText);
-        iUtf8TextCache = std::nullopt;
-
-        refresh_paragraph(iText.begin(), 0);
-        update();
-        cursor().set_position(iText.size());
-        if (iPreviousText != iText)
-            notify_text_changed();
+        if (!can_undo())
+            return;
+        auto const& step = iUndoStack[--iUndoPosition];
+        {
+            neolib::scoped_flag sf{ iUndoing };
+            multiple_text_changes mtc{ *this };
+            for (auto e = step.edits.rbegin(); e != step.edits.rend(); ++e)
+                apply_edit(*e, true);
+        }
+        cursor().set_anchor(step.cursorAnchor);
+        cursor().set_position(step.cursorPosition, false);
+        make_cursor_visible(true);
     }
 
-    void text_edit::redo(i_clipboard& aClipboard)
+    void text_edit::redo(i_clipboard&)
     {
-        // todo: more intelligent redo
-        undo(aClipboard);
+        if (!can_redo())
+            return;
+        auto const& step = iUndoStack[iUndoPosition++];
+        {
+            neolib::scoped_flag sf{ iUndoing };
+            multiple_text_changes mtc{ *this };
+            for (auto const& e : step.edits)
+                apply_edit(e, false);
+        }
+        auto const& last = step.edits.back();
+        cursor().set_position(last.position + (last.type == edit_type::Insert ? last.text.size() : 0u));
+        make_cursor_visible(true);
     }
 
     void text_edit::cut(i_clipboard& aClipboard)
@@ -990,7 +1024,7 @@ namespace neogfx
                 if (currentPosition.line != currentPosition.column->lines().begin())
                 {
                     auto const columnRectSansPadding = column_rect(column_index(*currentPosition.column));
-                    cursor().set_position(from_glyph(glyphs().begin() + document_hit_test(point{ *iCursorHint.x, std::prev(currentPosition.line)->ypos } +columnRectSansPadding.top_left(), false)).first, aMoveAnchor);
+                    cursor().set_position(from_glyph(glyphs().begin() + document_hit_test(point{ *iCursorHint.x, currentPosition.column->ypos(std::prev(currentPosition.line)) } +columnRectSansPadding.top_left(), false)).first, aMoveAnchor);
                 }
             }
             break;
@@ -1001,7 +1035,7 @@ namespace neogfx
                 {
                     auto const columnRectSansPadding = column_rect(column_index(*currentPosition.column));
                     if (std::next(currentPosition.line) != currentPosition.column->lines().end())
-                        cursor().set_position(from_glyph(glyphs().begin() + document_hit_test(point{ *iCursorHint.x, std::next(currentPosition.line)->ypos } + columnRectSansPadding.top_left(), false)).first, aMoveAnchor);
+                        cursor().set_position(from_glyph(glyphs().begin() + document_hit_test(point{ *iCursorHint.x, currentPosition.column->ypos(std::next(currentPosition.line)) } + columnRectSansPadding.top_left(), false)).first, aMoveAnchor);
                     else if (currentPosition.lineEnd != glyphs().end() && is_line_breaking_whitespace(*currentPosition.lineEnd))
                         cursor().set_position(iText.size(), aMoveAnchor);
                 }
@@ -1166,6 +1200,7 @@ namespace neogfx
         // todo: optimize this (by changing style in-place)
         std::u32string part;
         part.assign(iText.begin() + aStart, iText.begin() + aEnd);
+        multiple_text_changes mtc{ *this };
         delete_text(aStart, aEnd);
         insert_text(aStart, neolib::utf32_to_utf8(part), aStyle);
     }
@@ -1202,6 +1237,18 @@ namespace neogfx
         }
     }
 
+    void text_edit::scrollbar_updated(const i_scrollbar& aScrollbar, i_scrollbar::update_reason_e aReason)
+    {
+        framed_scrollable_widget::scrollbar_updated(aScrollbar, aReason);
+        if (aScrollbar.type() == scrollbar_type::Vertical && !iLazyWrapping && estimated_lines_in_view())
+        {
+            neolib::scoped_flag sf{ iLazyWrapping };
+            wrap_estimated_lines_in_view();
+            vertical_scrollbar().set_maximum(iTextExtents.cy);
+            update();
+        }
+    }
+
     std::size_t text_edit::column_index(const column_info& aColumn) const
     {
         return static_cast<const glyph_column*>(&aColumn) - static_cast<const glyph_column*>(&column(0));
@@ -1236,7 +1283,7 @@ namespace neogfx
         glyph_lines::const_iterator line;
         for (; column != iGlyphColumns.end(); ++column)
         {
-            line = std::lower_bound(column->lines().begin(), column->lines().end(), glyph_line{ {}, { aGlyphPosition, glyphs().begin() + aGlyphPosition }, {}, 0.0, {} },
+            line = std::lower_bound(column->lines().begin(), column->lines().end(), glyph_line{ {}, { aGlyphPosition, glyphs().begin() + aGlyphPosition }, {}, {} },
                 [](const glyph_line& left, const glyph_line& right) { return left.lineStart.first < right.lineStart.first; });
             if (line != column->lines().end())
                 break;
@@ -1301,13 +1348,13 @@ namespace neogfx
                 {
                     auto iterGlyph = glyphs().begin() + aGlyphPosition;
                     auto const& glyph = aGlyphPosition < lineEnd ? *iterGlyph : *(iterGlyph - 1);
-                    point linePos{ glyph.x - line->lineStart.second->x, line->ypos };
+                    point linePos{ glyph.x - line->lineStart.second->x, column->ypos(line) };
                     if (placeCursorToRight)
                         linePos.x += advance(glyph).cx;
                     return position_info{ iterGlyph, column, line, glyphs().begin() + lineStart, glyphs().begin() + lineEnd, linePos + alignmentAdjust };
                 }
                 else
-                    return position_info{ line->lineStart.second, column, line, glyphs().begin() + lineStart, glyphs().begin() + lineEnd, point{ 0.0, line->ypos } + alignmentAdjust };
+                    return position_info{ line->lineStart.second, column, line, glyphs().begin() + lineStart, glyphs().begin() + lineEnd, point{ 0.0, column->ypos(line) } + alignmentAdjust };
             }
         }
         point pos;
@@ -1320,7 +1367,7 @@ namespace neogfx
                 pos.x = columnRectSansPadding.cx;
             else if ((Alignment & alignment::Horizontal) == alignment::Center)
                 pos.x = columnRectSansPadding.cx / 2.0;
-            pos.y = lines.back().ypos + lines.back().extents.cy;
+            pos.y = column->ypos(std::prev(lines.end())) + lines.back().extents.cy;
         }
         return position_info{ glyphs().end(), column, lines.end(), glyphs().end(), glyphs().end(), pos };
     }
@@ -1348,14 +1395,11 @@ namespace neogfx
         point adjustedPosition = (aAdjustForScrollPosition ? aPosition + point{ horizontal_scrollbar().position(), vertical_scrollbar().position() } : aPosition) - columnRectSansPadding.top_left();
         adjustedPosition = adjustedPosition.max(point{});
         auto const& lines = column.lines();
-        auto line = std::lower_bound(lines.begin(), lines.end(), glyph_line{ {}, {}, {}, adjustedPosition.y, {} },
-            [](const glyph_line& left, const glyph_line& right) { return left.ypos < right.ypos; });
-        if (line == lines.end() && !lines.empty() && adjustedPosition.y < lines.back().ypos + lines.back().extents.cy)
-            --line;
+        auto line = column.line_at(adjustedPosition.y);
+        if (line != lines.end() && std::next(line) == lines.end() && adjustedPosition.y >= column.ypos(line) + line->extents.cy)
+            line = lines.end();
         if (line != lines.end())
         {
-            if (line != lines.begin() && adjustedPosition.y < line->ypos)
-                --line;
             delta alignmentAdjust;
             auto textDirection = glyph_text_direction(lines.back().lineStart.second, lines.back().lineEnd.second);
             if (((Alignment & alignment::Horizontal) == alignment::Left && textDirection == text_direction::RTL) ||
@@ -1412,10 +1456,12 @@ namespace neogfx
     {
         cursor().set_position(0);
         iText.clear();
+        clear_undo_history();
         glyphs().clear();
         iGlyphParagraphs.clear();
+        iShapingEnd = 0u;
         for (std::size_t i = 0; i < iGlyphColumns.size(); ++i)
-            iGlyphColumns[i].lines().clear();
+            iGlyphColumns[i].clear_lines();
     }
 
     std::string const& text_edit::text() const
@@ -1477,13 +1523,12 @@ namespace neogfx
         auto eraseEnd = iText.begin() + aEnd;
         auto eraseAmount = eraseEnd - eraseBegin;
 
-        iPreviousText = iText;
+        record_edit(edit_type::Delete, aStart, eraseBegin, eraseEnd);
         iUtf8TextCache = std::nullopt;
 
         refresh_paragraph(iText.erase(eraseBegin, eraseEnd), -eraseAmount);
         update();
-        if (iPreviousText != iText)
-            notify_text_changed();
+        notify_text_changed();
     }
 
     std::pair<text_edit::position_type, text_edit::position_type> text_edit::related_glyphs(position_type aGlyphPosition) const
@@ -1683,11 +1728,15 @@ namespace neogfx
         if (!accept)
             return 0;
 
-        iPreviousText = iText;
         iUtf8TextCache = std::nullopt;
 
-        if (aClearFirst)
+        bool changed = false;
+        if (aClearFirst && !iText.empty())
+        {
+            record_edit(edit_type::Delete, 0u, iText.begin(), iText.end());
             iText.clear();
+            changed = true;
+        }
 
         std::u32string text = neolib::utf8_to_utf32(aText);
         if (iNormalizedTextBuffer.capacity() < text.size())
@@ -1704,14 +1753,22 @@ namespace neogfx
                 eos = eol;
         }
         auto s = (&aStyle != &iDefaultStyle || iPersistDefaultStyle ? iStyles.insert(style(*this, aStyle)).first : iStyles.end());
+        auto const tagData = (s != iStyles.end() ? document_text::tag_type::tag_data{ static_cast<style_list::const_iterator>(s) } : document_text::tag_type::tag_data{ nullptr });
         auto insertionPoint = iText.begin() + aPosition;
-        insertionPoint = iText.insert(s != iStyles.end() ? document_text::tag_type::tag_data{ static_cast<style_list::const_iterator>(s) } : document_text::tag_type::tag_data{ nullptr },
-            insertionPoint, iNormalizedTextBuffer.begin(), iNormalizedTextBuffer.begin() + eos);
-        refresh_paragraph(insertionPoint, eos);
+        insertionPoint = iText.insert(tagData, insertionPoint, iNormalizedTextBuffer.begin(), iNormalizedTextBuffer.begin() + eos);
+        if (eos != 0u)
+        {
+            record_edit(edit_type::Insert, insertionPoint - iText.begin(), insertionPoint, insertionPoint + eos, document_text::tag_type{ tagData });
+            changed = true;
+        }
+        if (aClearFirst)
+            refresh_paragraph(iText.begin(), 0);
+        else
+            refresh_paragraph(insertionPoint, eos);
         update();
         if (aMoveCursor)
             cursor().set_position(insertionPoint - iText.begin() + eos);
-        if (iPreviousText != iText)
+        if (changed)
             notify_text_changed();
         return eos;
     }
@@ -1725,6 +1782,138 @@ namespace neogfx
         }
     }
 
+    void text_edit::record_edit(edit_type aType, position_type aPosition, document_text::const_iterator aBegin, document_text::const_iterator aEnd, std::optional<document_text::tag_type> const& aStyle)
+    {
+        if (iUndoing)
+            return;
+        auto const length = static_cast<document_text::size_type>(aEnd - aBegin);
+        if (length == 0u)
+            return;
+        auto edit_size = [](edit const& aEdit)
+        {
+            return aEdit.text.size() * sizeof(char32_t) + aEdit.styles.size() * sizeof(aEdit.styles[0]);
+        };
+        auto add_style = [](edit& aEdit, document_text::size_type aLength, document_text::tag_type const& aTag, bool aAtFront)
+        {
+            auto& styles = aEdit.styles;
+            if (!styles.empty() && (aAtFront ? styles.front() : styles.back()).second == aTag)
+                (aAtFront ? styles.front() : styles.back()).first += aLength;
+            else if (aAtFront)
+                styles.emplace(styles.begin(), aLength, aTag);
+            else
+                styles.emplace_back(aLength, aTag);
+        };
+        auto is_whitespace = [](char32_t aCharacter)
+        {
+            return aCharacter == U' ' || aCharacter == U'\t' || aCharacter == U'\n';
+        };
+        // anything beyond the undo position can no longer be redone
+        while (iUndoStack.size() > iUndoPosition)
+        {
+            for (auto const& e : iUndoStack.back().edits)
+                iUndoMemory -= edit_size(e);
+            iUndoStack.pop_back();
+        }
+        bool const grouped = (iSuppressTextChangedNotification > 0u);
+        bool const typing = (length == 1u);
+        bool coalesced = false;
+        if (grouped && iUndoGroupOpen && !iUndoStack.empty())
+        {
+            iUndoStack.back().typing = false;
+            iUndoStack.back().edits.push_back(edit{ aType, aPosition });
+        }
+        else if (typing && !iUndoStack.empty() && iUndoStack.back().typing && iUndoStack.back().edits.back().type == aType)
+        {
+            auto& previous = iUndoStack.back().edits.back();
+            auto const character = *aBegin;
+            if (aType == edit_type::Insert && aPosition == previous.position + previous.text.size() &&
+                (is_whitespace(character) || !is_whitespace(previous.text.back())))
+            {
+                iUndoMemory -= edit_size(previous);
+                previous.text.push_back(character);
+                add_style(previous, 1u, aStyle ? *aStyle : iText.tag(aBegin), false);
+                iUndoMemory += edit_size(previous);
+                coalesced = true;
+            }
+            else if (aType == edit_type::Delete && aPosition + 1u == previous.position)
+            {
+                iUndoMemory -= edit_size(previous);
+                previous.text.insert(previous.text.begin(), character);
+                previous.position = aPosition;
+                add_style(previous, 1u, iText.tag(aBegin), true);
+                iUndoMemory += edit_size(previous);
+                coalesced = true;
+            }
+            else if (aType == edit_type::Delete && aPosition == previous.position)
+            {
+                iUndoMemory -= edit_size(previous);
+                previous.text.push_back(character);
+                add_style(previous, 1u, iText.tag(aBegin), false);
+                iUndoMemory += edit_size(previous);
+                coalesced = true;
+            }
+            if (!coalesced)
+                iUndoStack.push_back(undo_step{ { edit{ aType, aPosition } }, cursor().position(), cursor().anchor(), typing });
+        }
+        else
+            iUndoStack.push_back(undo_step{ { edit{ aType, aPosition } }, cursor().position(), cursor().anchor(), typing });
+        if (!coalesced)
+        {
+            auto& newEdit = iUndoStack.back().edits.back();
+            newEdit.text.assign(aBegin, aEnd);
+            if (aStyle)
+                newEdit.styles.emplace_back(length, *aStyle);
+            else
+                for (auto c = aBegin; c != aEnd; ++c)
+                    add_style(newEdit, 1u, iText.tag(c), false);
+            iUndoMemory += edit_size(newEdit);
+            iUndoPosition = iUndoStack.size();
+        }
+        iUndoGroupOpen = grouped;
+        // oldest steps are forgotten first; a single step larger than the limit is not kept at all
+        while (iUndoMemory > UndoMemoryLimit && !iUndoStack.empty())
+        {
+            for (auto const& e : iUndoStack.front().edits)
+                iUndoMemory -= edit_size(e);
+            iUndoStack.pop_front();
+            --iUndoPosition;
+            iUndoGroupOpen = false;
+        }
+    }
+
+    void text_edit::apply_edit(edit const& aEdit, bool aRevert)
+    {
+        iUtf8TextCache = std::nullopt;
+        if ((aEdit.type == edit_type::Insert) != aRevert)
+        {
+            auto insertionPoint = aEdit.position;
+            auto source = aEdit.text.begin();
+            for (auto const& run : aEdit.styles)
+            {
+                iText.insert(document_text::tag_type::tag_data{ run.second.style() }, iText.begin() + insertionPoint, source, source + run.first);
+                insertionPoint += run.first;
+                source += run.first;
+            }
+            refresh_paragraph(iText.begin() + aEdit.position, static_cast<std::ptrdiff_t>(aEdit.text.size()));
+        }
+        else
+        {
+            auto eraseBegin = iText.begin() + aEdit.position;
+            auto eraseEnd = eraseBegin + aEdit.text.size();
+            refresh_paragraph(iText.erase(eraseBegin, eraseEnd), -static_cast<std::ptrdiff_t>(aEdit.text.size()));
+        }
+        update();
+        notify_text_changed();
+    }
+
+    void text_edit::clear_undo_history()
+    {
+        iUndoStack.clear();
+        iUndoPosition = 0u;
+        iUndoMemory = 0u;
+        iUndoGroupOpen = false;
+    }
+
     void text_edit::notify_text_changed()
     {
         if (!iSuppressTextChangedNotification)
@@ -1772,19 +1961,92 @@ namespace neogfx
 
     void text_edit::refresh_paragraph(document_text::const_iterator aWhere, ptrdiff_t aDelta)
     {
-        /* simple (naive) implementation just to get things moving (so just refresh everything) ... */
-        (void)aWhere;
         graphics_context gc{ *this, graphics_context::type::Unattached };
         if (password())
             gc.set_password(true, PasswordMask.value().empty() ? "\xE2\x97\x8F"_s : PasswordMask);
-        glyphs().clear();
-        iGlyphParagraphs.clear();
         iCharacterToParagraphCache.clear();
         iCharacterToParagraphCacheLastAccess.reset();
         iGlyphToParagraphCache.clear();
         iGlyphToParagraphCacheLastAccess.reset();
+        // (begin, 0) requests a complete refresh (font, style, password or column changes); column
+        // delimiters carry state across paragraphs so multi-column documents are always refreshed in full
+        if ((aWhere == iText.begin() && aDelta == 0) || columns() > 1 || iGlyphParagraphs.empty())
+        {
+            glyphs().clear();
+            iGlyphParagraphs.clear();
+            iShapingEnd = 0u;
+            // large documents are shaped a batch at a time so that the first page appears at once and
+            // the rest streams in without blocking the UI
+            if (iText.size() > BackgroundShapingThreshold && columns() == 1)
+            {
+                shape_next_batch(gc);
+                shape_in_background();
+            }
+            else
+            {
+                shape_paragraphs(gc, iText.begin(), iText.end(), iGlyphParagraphs.end(), 0);
+                iShapingEnd = iText.size();
+            }
+            refresh_columns();
+            return;
+        }
+        // only the paragraphs touched by the edit are reshaped; paragraph indices are relative so
+        // those that follow need no adjustment
+        auto const where = static_cast<position_type>(aWhere - iText.begin());
+        auto const oldSize = static_cast<position_type>(static_cast<ptrdiff_t>(iText.size()) - aDelta);
+        auto const removed = static_cast<position_type>(aDelta < 0 ? -aDelta : 0);
+        if (iShapingEnd < oldSize)
+        {
+            // background shaping still in progress: edits confined to unshaped text need nothing
+            // doing now; edits reaching it discard the shaped paragraphs they touch for reshaping
+            if (where >= iShapingEnd)
+            {
+                refresh_columns();
+                return;
+            }
+            if (where + removed + 1u >= iShapingEnd)
+            {
+                auto first = iGlyphParagraphs.find_by_foreign_index(glyph_paragraph_index{ where, 0 }, [](const glyph_paragraph_index& aLhs, const glyph_paragraph_index& aRhs) { return aLhs.characters() < aRhs.characters(); }).first;
+                if (first == iGlyphParagraphs.end())
+                    first = std::prev(iGlyphParagraphs.end());
+                iShapingEnd = first->first.text_start_index();
+                glyphs().container().erase(glyphs().container().begin() + first->first.start_index(), glyphs().container().end());
+                while (first != iGlyphParagraphs.end())
+                    first = iGlyphParagraphs.erase(first);
+                shape_in_background();
+                refresh_columns();
+                return;
+            }
+            iShapingEnd = static_cast<position_type>(static_cast<ptrdiff_t>(iShapingEnd) + aDelta);
+        }
+        else
+            iShapingEnd = iText.size();
+        auto paragraph_at = [&](position_type aOldPosition)
+        {
+            if (aOldPosition >= oldSize)
+                return std::prev(iGlyphParagraphs.end());
+            auto gp = iGlyphParagraphs.find_by_foreign_index(glyph_paragraph_index{ aOldPosition, 0 }, [](const glyph_paragraph_index& aLhs, const glyph_paragraph_index& aRhs) { return aLhs.characters() < aRhs.characters(); }).first;
+            return gp != iGlyphParagraphs.end() ? gp : std::prev(iGlyphParagraphs.end());
+        };
+        auto first = paragraph_at(where);
+        // removing a paragraph's newline joins it to the paragraph that follows
+        auto last = paragraph_at(where + removed);
+        auto const textStart = first->first.text_start_index();
+        auto const textEnd = static_cast<position_type>(static_cast<ptrdiff_t>(last->first.text_end_index()) + aDelta);
+        auto const glyphStart = first->first.start_index();
+        auto const glyphEnd = last->first.end_index();
+        glyphs().container().erase(glyphs().container().begin() + glyphStart, glyphs().container().begin() + glyphEnd);
+        auto before = std::next(last);
+        for (auto p = first; p != before;)
+            p = iGlyphParagraphs.erase(p);
+        shape_paragraphs(gc, iText.begin() + textStart, iText.begin() + textEnd, before, glyphStart);
+        refresh_columns();
+    }
+
+    void text_edit::shape_paragraphs(i_graphics_context const& aGc, document_text::const_iterator aBegin, document_text::const_iterator aEnd, glyph_paragraphs::const_iterator aBefore, document_glyphs::size_type aGlyphPosition)
+    {
         std::u32string paragraphBuffer;
-        auto paragraphStart = iText.begin();
+        auto paragraphStart = aBegin;
         auto iterColumn = iGlyphColumns.begin();
         neolib::vecarray<std::u32string::size_type, 16, -1> columnDelimiters;
         auto fs = [this, &paragraphStart, &columnDelimiters](std::u32string::size_type aSourceIndex)
@@ -1799,7 +2061,8 @@ namespace neogfx
                 columnStyle.character().font() != std::nullopt ? columnStyle : iDefaultStyle;
             return style.character().font() != std::nullopt ? *style.character().font() : font();
         };
-        for (auto iterChar = iText.begin(); iterChar != iText.end(); ++iterChar)
+        neolib::vecarray<glyph_paragraphs::iterator, 16, -1> newParagraphs;
+        for (auto iterChar = aBegin; iterChar != aEnd; ++iterChar)
         {
             auto& column = *(iterColumn);
             auto ch = *iterChar;
@@ -1810,39 +2073,42 @@ namespace neogfx
                 continue;
             }
             bool newLine = (ch == U'\n');
-            if (newLine || iterChar == iText.end() - 1)
+            if (newLine || iterChar == aEnd - 1)
             {
                 paragraphBuffer.assign(paragraphStart, iterChar + 1);
-                auto gt = gc.to_glyph_text(paragraphBuffer.begin(), paragraphBuffer.end(), fs);
+                auto gt = aGc.to_glyph_text(paragraphBuffer.begin(), paragraphBuffer.end(), fs);
                 if (gt.cbegin() != gt.cend())
                 {
-                    auto paragraphGlyphs = glyphs().container().insert(glyphs().container().end(), gt.cbegin(), gt.cend());
+                    glyphs().container().insert(glyphs().container().begin() + aGlyphPosition, gt.cbegin(), gt.cend());
+                    aGlyphPosition += gt.size();
                     for (auto& newGlyph : gt)
                         glyphs().cache_glyph_font(newGlyph.font);
-                    auto newParagraph = iGlyphParagraphs.insert(iGlyphParagraphs.end(),
+                    auto newParagraph = iGlyphParagraphs.insert(aBefore,
                         std::make_pair(
                             glyph_paragraph{ *this },
                             glyph_paragraph_index{
-                                static_cast<std::size_t>((iterChar + 1) - iText.begin()) - static_cast<std::size_t>(paragraphStart - iText.begin()),
-                                glyphs().size() - static_cast<std::size_t>(paragraphGlyphs - glyphs().container().begin()) }),
+                                static_cast<std::size_t>((iterChar + 1) - paragraphStart),
+                                gt.size() }),
                                 glyph_paragraphs::skip_type{ glyph_paragraph_index{}, glyph_paragraph_index{} });
                     newParagraph->first.set_self(newParagraph);
+                    newParagraphs.push_back(newParagraph);
                 }
                 paragraphStart = iterChar + 1;
                 columnDelimiters.clear();
             }
         }
-        for (auto p = iGlyphParagraphs.begin(); p != iGlyphParagraphs.end(); ++p)
+        for (auto p : newParagraphs)
         {
             auto& paragraph = *p;
             if (paragraph.first.start() == paragraph.first.end())
                 continue;
             coordinate x = 0.0;
             iterColumn = iGlyphColumns.begin();
+            auto const textStart = paragraph.first.text_start_index();
             for (auto iterGlyph = paragraph.first.start(); iterGlyph != paragraph.first.end(); ++iterGlyph)
             {
                 auto& glyph = *iterGlyph;
-                if (iText[glyph.source.first] == iterColumn->delimiter() && iterColumn + 1 != iGlyphColumns.end())
+                if (iText[textStart + glyph.source.first] == iterColumn->delimiter() && iterColumn + 1 != iGlyphColumns.end())
                 {
                     glyph.advance = size{};
                     ++iterColumn;
@@ -1865,7 +2131,71 @@ namespace neogfx
                 x += advance(glyph).cx;
             }
         }
+    }
+
+    bool text_edit::shape_next_batch(i_graphics_context const& aGc)
+    {
+        if (iShapingEnd >= iText.size())
+            return true;
+        auto const batchStart = iText.begin() + iShapingEnd;
+        auto batchEnd = batchStart + std::min<document_text::size_type>(ShapingBatchSize, iText.size() - iShapingEnd);
+        batchEnd = std::find(batchEnd - 1, iText.end(), U'\n');
+        if (batchEnd != iText.end())
+            ++batchEnd;
+        shape_paragraphs(aGc, batchStart, batchEnd, iGlyphParagraphs.end(), glyphs().size());
+        iShapingEnd = static_cast<document_text::size_type>(batchEnd - iText.begin());
+        return iShapingEnd >= iText.size();
+    }
+
+    void text_edit::shape_in_background()
+    {
+        if (iShaper)
+        {
+            iShaper->again_if();
+            return;
+        }
+        iShaper.emplace(service<i_async_task>(), [this](neolib::callback_timer& aShaper)
+        {
+            if (!shaping())
+                return;
+            graphics_context gc{ *this, graphics_context::type::Unattached };
+            if (password())
+                gc.set_password(true, PasswordMask.value().empty() ? "\xE2\x97\x8F"_s : PasswordMask);
+            // shape for a time slice then publish what has been shaped so far
+            auto const sliceEnd = neolib::thread::program_elapsed_ms() + 10u;
+            while (!shape_next_batch(gc) && neolib::thread::program_elapsed_ms() < sliceEnd)
+                ;
+            iCharacterToParagraphCache.clear();
+            iCharacterToParagraphCacheLastAccess.reset();
+            iGlyphToParagraphCache.clear();
+            iGlyphToParagraphCacheLastAccess.reset();
+            if (shaping())
+                aShaper.again();
+            refresh_columns();
+            ShapingProgress.trigger(iText.empty() ? 1.0 : static_cast<double>(iShapingEnd) / iText.size());
+        }, std::chrono::milliseconds{ 1 });
+    }
+
+    bool text_edit::shaping() const
+    {
+        return iShapingEnd < iText.size();
+    }
+
+    void text_edit::complete_shaping()
+    {
+        if (!shaping())
+            return;
+        graphics_context gc{ *this, graphics_context::type::Unattached };
+        if (password())
+            gc.set_password(true, PasswordMask.value().empty() ? "\xE2\x97\x8F"_s : PasswordMask);
+        while (!shape_next_batch(gc))
+            ;
+        iCharacterToParagraphCache.clear();
+        iCharacterToParagraphCacheLastAccess.reset();
+        iGlyphToParagraphCache.clear();
+        iGlyphToParagraphCacheLastAccess.reset();
         refresh_columns();
+        ShapingProgress.trigger(1.0);
     }
 
     void text_edit::refresh_columns()
@@ -1878,124 +2208,38 @@ namespace neogfx
     {
         try
         {
-            /* simple (naive) implementation just to get things moving... */
             iOutOfMemory = false;
             for (auto& column : iGlyphColumns)
-                column.lines().clear();
+                column.clear_lines();
             point pos{};
             dimension availableWidth = column_rect(0).width(); // todo: columns
             dimension availableHeight = column_rect(0).height();
             bool showVerticalScrollbar = false;
             bool showHorizontalScrollbar = false;
             iTextExtents = size{};
+            // paragraphs further than this many pages from the viewport are given an estimated height
+            // rather than being wrapped; they are wrapped properly once scrolled near
+            scalar const LazyWrapMargin = 1.0;
+            auto const lazyWrapTop = vertical_scrollbar().position() - availableHeight * LazyWrapMargin;
+            auto const lazyWrapBottom = vertical_scrollbar().position() + availableHeight * (1.0 + LazyWrapMargin);
             uint32_t pass = 1;
             auto iterColumn = iGlyphColumns.begin();
             for (auto p = iGlyphParagraphs.begin(); p != iGlyphParagraphs.end();)
             {
                 auto& column = *iterColumn;
-                auto& lines = column.lines();
                 auto& paragraph = *p;
-                auto paragraphStart = paragraph.first.start();
-                auto paragraphEnd = paragraph.first.end();
-                if (paragraphStart == paragraphEnd || is_line_breaking_whitespace(*paragraphStart))
+                auto const* wrapping = &wrap_paragraph(paragraph.first, availableWidth, true);
+                if (wrapping->estimated)
                 {
-                    auto lineStart = paragraphStart;
-                    auto lineEnd = lineStart;
-                    auto const& glyph = *lineStart;
-                    auto const& glyphFont = glyphs().glyph_font(glyph);
-                    auto height = paragraph.first.height(lineStart, lineEnd);
-                    lines.push_back(
-                        glyph_line{
-                            { p - iGlyphParagraphs.begin(), p },
-                            { lineStart - glyphs().begin(), lineStart },
-                            { lineEnd - glyphs().begin(), lineEnd },
-                            pos.y,
-                            { 0.0, height } });
-                    pos.y += glyphFont.height();
-                }
-                else if (WordWrap && (paragraphEnd - 1)->x + advance(*(paragraphEnd - 1)).cx > availableWidth)
-                {
-                    auto insertionPoint = lines.end();
-                    bool first = true;
-                    auto next = paragraph.first.start();
-                    auto lineStart = next;
-                    auto lineEnd = paragraphEnd;
-                    coordinate offset = 0.0;
-                    while (next != paragraphEnd)
-                    {
-                        auto split = std::lower_bound(next, paragraphEnd, paragraph_positioned_glyph{ offset + availableWidth });
-                        if (split != next && (split != paragraphEnd || (split - 1)->x + advance(*(split - 1)).cx >= offset + availableWidth))
-                            --split;
-                        if (split == next)
-                            ++split;
-                        if (split != paragraphEnd)
-                        {
-                            std::pair<document_glyphs::iterator, document_glyphs::iterator> wordBreak = word_break(lineStart, split, paragraphEnd);
-                            lineEnd = wordBreak.first;
-                            next = wordBreak.second;
-                            if (wordBreak.first == wordBreak.second)
-                            {
-                                while (lineEnd != lineStart && (lineEnd - 1)->source == wordBreak.first->source)
-                                    --lineEnd;
-                                next = lineEnd;
-                            }
-                        }
-                        else
-                            next = paragraphEnd;
-                        dimension x = (split != glyphs().end() ? split->x : (lineStart != lineEnd ? glyphs().back().x + advance(glyphs().back()).cx : 0.0));
-                        auto height = paragraph.first.height(lineStart, lineEnd);
-                        if (lineEnd != lineStart && is_line_breaking_whitespace(*(lineEnd - 1)))
-                            --lineEnd;
-                        bool rtl = false;
-                        if (!first &&
-                            insertionPoint->lineStart != insertionPoint->lineEnd &&
-                            lineStart != lineEnd &&
-                            direction(*insertionPoint->lineStart.second) == text_direction::RTL &&
-                            direction(*(lineEnd - 1)) == text_direction::RTL)
-                            rtl = true; // todo: is this sufficient for multi-line RTL text?
-                        if (!rtl)
-                            insertionPoint = lines.end();
-                        insertionPoint = lines.insert(insertionPoint,
-                            glyph_line{
-                                { p - iGlyphParagraphs.begin(), p },
-                                { lineStart - glyphs().begin(), lineStart },
-                                { lineEnd - glyphs().begin(), lineEnd },
-                                pos.y,
-                                { x - offset, height } });
-                        if (rtl)
-                        {
-                            auto ypos = (insertionPoint + 1)->ypos;
-                            for (auto i = insertionPoint; i != lines.end(); ++i)
-                            {
-                                i->ypos = ypos;
-                                ypos += i->extents.cy;
-                            }
-                        }
-                        pos.y += height;
-                        iTextExtents.cx = std::max(iTextExtents.cx, x - offset);
-                        lineStart = next;
-                        if (lineStart != paragraphEnd)
-                            offset = lineStart->x;
-                        lineEnd = paragraphEnd;
-                        first = false;
-                    }
+                    auto const& estimate = wrapping->lines.back();
+                    if (pos.y <= lazyWrapBottom && pos.y + estimate.advance >= lazyWrapTop)
+                        wrapping = &wrap_paragraph(paragraph.first, availableWidth, false);
                 }
-                else
+                for (auto const& line : wrapping->lines)
                 {
-                    auto lineStart = paragraphStart;
-                    auto lineEnd = paragraphEnd;
-                    auto height = paragraph.first.height(lineStart, lineEnd);
-                    if (lineEnd != lineStart && is_line_breaking_whitespace(*(lineEnd - 1)))
-                        --lineEnd;
-                    lines.push_back(
-                        glyph_line{
-                            { p - iGlyphParagraphs.begin(), p },
-                            { lineStart - glyphs().begin(), lineStart },
-                            { lineEnd - glyphs().begin(), lineEnd },
-                            pos.y,
-                            { (lineEnd - 1)->x + advance(*(lineEnd - 1)).cx, height} });
-                    pos.y += lines.back().extents.cy;
-                    iTextExtents.cx = std::max(iTextExtents.cx, lines.back().extents.cx);
+                    column.append_line(to_glyph_line(p, line, wrapping->estimated), line.advance);
+                    pos.y += line.advance;
+                    iTextExtents.cx = std::max(iTextExtents.cx, line.extents.cx);
                 }
                 if (p + 1 == iGlyphParagraphs.end() && !glyphs().empty() && is_line_breaking_whitespace(glyphs().back()))
                     pos.y += font().height();
@@ -2003,7 +2247,7 @@ namespace neogfx
                 {
                     if (pass <= 3)
                     {
-                        lines.clear();
+                        column.clear_lines();
                         pos = point{};
                         iTextExtents = size{};
                         p = iGlyphParagraphs.begin();
@@ -2043,11 +2287,168 @@ namespace neogfx
         catch (std::bad_alloc)
         {
             for (auto& column : iGlyphColumns)
-                column.lines().clear();
+                column.clear_lines();
             iOutOfMemory = true;
         }
     }
 
+    text_edit::glyph_paragraph::line_wrap const& text_edit::wrap_paragraph(glyph_paragraph& aParagraph, dimension aAvailableWidth, bool aEstimate)
+    {
+        auto& existing = aParagraph.wrapping();
+        if (existing && existing->availableWidth == aAvailableWidth && existing->wordWrap == word_wrap() && (!existing->estimated || aEstimate))
+            return *existing;
+        existing = glyph_paragraph::line_wrap{ aAvailableWidth, word_wrap(), false };
+        auto& lines = existing->lines;
+        auto paragraphStart = aParagraph.start();
+        auto paragraphEnd = aParagraph.end();
+        auto relative = [&](document_glyphs::iterator aGlyph)
+        {
+            return static_cast<document_glyphs::size_type>(aGlyph - paragraphStart);
+        };
+        if (paragraphStart == paragraphEnd || is_line_breaking_whitespace(*paragraphStart))
+        {
+            auto lineStart = paragraphStart;
+            auto lineEnd = lineStart;
+            auto const& glyph = *lineStart;
+            auto const& glyphFont = glyphs().glyph_font(glyph);
+            auto height = aParagraph.height(lineStart, lineEnd);
+            lines.push_back(glyph_paragraph::wrapped_line{ 0, 0, { 0.0, height }, glyphFont.height() });
+        }
+        else if (WordWrap && (paragraphEnd - 1)->x + advance(*(paragraphEnd - 1)).cx > aAvailableWidth && aEstimate)
+        {
+            auto lineEnd = paragraphEnd;
+            auto const lineCount = std::ceil(((paragraphEnd - 1)->x + advance(*(paragraphEnd - 1)).cx) / std::max(aAvailableWidth, 1.0));
+            auto const height = aParagraph.height(paragraphStart, paragraphEnd) * lineCount;
+            if (is_line_breaking_whitespace(*(lineEnd - 1)))
+                --lineEnd;
+            existing->estimated = true;
+            lines.push_back(glyph_paragraph::wrapped_line{ 0, relative(lineEnd), { aAvailableWidth, height }, height });
+        }
+        else if (WordWrap && (paragraphEnd - 1)->x + advance(*(paragraphEnd - 1)).cx > aAvailableWidth)
+        {
+            auto insertionPoint = lines.end();
+            bool first = true;
+            auto next = paragraphStart;
+            auto lineStart = next;
+            auto lineEnd = paragraphEnd;
+            coordinate offset = 0.0;
+            while (next != paragraphEnd)
+            {
+                auto split = std::lower_bound(next, paragraphEnd, paragraph_positioned_glyph{ offset + aAvailableWidth });
+                if (split != next && (split != paragraphEnd || (split - 1)->x + advance(*(split - 1)).cx >= offset + aAvailableWidth))
+                    --split;
+                if (split == next)
+                    ++split;
+                if (split != paragraphEnd)
+                {
+                    std::pair<document_glyphs::iterator, document_glyphs::iterator> wordBreak = word_break(lineStart, split, paragraphEnd);
+                    lineEnd = wordBreak.first;
+                    next = wordBreak.second;
+                    if (wordBreak.first == wordBreak.second)
+                    {
+                        while (lineEnd != lineStart && (lineEnd - 1)->source == wordBreak.first->source)
+                            --lineEnd;
+                        next = lineEnd;
+                    }
+                }
+                else
+                    next = paragraphEnd;
+                dimension x = (split != glyphs().end() ? split->x : (lineStart != lineEnd ? glyphs().back().x + advance(glyphs().back()).cx : 0.0));
+                auto height = aParagraph.height(lineStart, lineEnd);
+                if (lineEnd != lineStart && is_line_breaking_whitespace(*(lineEnd - 1)))
+                    --lineEnd;
+                bool rtl = false;
+                if (!first &&
+                    insertionPoint->lineStart != insertionPoint->lineEnd &&
+                    lineStart != lineEnd &&
+                    direction(*(paragraphStart + insertionPoint->lineStart)) == text_direction::RTL &&
+                    direction(*(lineEnd - 1)) == text_direction::RTL)
+                    rtl = true; // todo: is this sufficient for multi-line RTL text?
+                if (!rtl)
+                    insertionPoint = lines.end();
+                insertionPoint = lines.insert(insertionPoint,
+                    glyph_paragraph::wrapped_line{ relative(lineStart), relative(lineEnd), { x - offset, height }, height });
+                lineStart = next;
+                if (lineStart != paragraphEnd)
+                    offset = lineStart->x;
+                lineEnd = paragraphEnd;
+                first = false;
+            }
+        }
+        else
+        {
+            auto lineStart = paragraphStart;
+            auto lineEnd = paragraphEnd;
+            auto height = aParagraph.height(lineStart, lineEnd);
+            if (lineEnd != lineStart && is_line_breaking_whitespace(*(lineEnd - 1)))
+                --lineEnd;
+            lines.push_back(glyph_paragraph::wrapped_line{ relative(lineStart), relative(lineEnd), { (lineEnd - 1)->x + advance(*(lineEnd - 1)).cx, height }, height });
+        }
+        return *existing;
+    }
+
+    text_edit::glyph_line text_edit::to_glyph_line(glyph_paragraphs::const_iterator aParagraph, glyph_paragraph::wrapped_line const& aLine, bool aEstimated) const
+    {
+        auto const paragraphStartIndex = aParagraph->first.start_index();
+        auto const lineStart = paragraphStartIndex + aLine.lineStart;
+        auto const lineEnd = paragraphStartIndex + aLine.lineEnd;
+        return glyph_line{
+            { static_cast<glyph_paragraphs::size_type>(aParagraph - iGlyphParagraphs.begin()), aParagraph },
+            { lineStart, glyphs().begin() + lineStart },
+            { lineEnd, glyphs().begin() + lineEnd },
+            aLine.extents,
+            aEstimated };
+    }
+
+    bool text_edit::estimated_lines_in_view() const
+    {
+        if (iGlyphColumns.empty())
+            return false;
+        auto const& column = iGlyphColumns[0];
+        auto const& lines = column.lines();
+        auto const top = vertical_scrollbar().position();
+        auto const bottom = top + column_rect(0).height();
+        for (auto line = column.line_at(top); line != lines.end() && column.ypos(line) < bottom; ++line)
+            if (line->estimated)
+                return true;
+        return false;
+    }
+
+    void text_edit::wrap_estimated_lines_in_view()
+    {
+        // the same margin as refresh_lines(); only the estimated lines found are replaced so the
+        // cost depends on what is wrapped rather than on the size of the document
+        scalar const LazyWrapMargin = 1.0;
+        auto& column = iGlyphColumns[0];
+        auto const& lines = column.lines();
+        auto const availableHeight = column_rect(0).height();
+        auto const top = vertical_scrollbar().position() - availableHeight * LazyWrapMargin;
+        auto const bottom = vertical_scrollbar().position() + availableHeight * (1.0 + LazyWrapMargin);
+        auto const oldHeight = column.height();
+        thread_local glyph_lines newLines;
+        thread_local std::vector<dimension> newAdvances;
+        for (auto line = column.line_at(top); line != lines.end() && column.ypos(line) < bottom;)
+        {
+            if (!line->estimated)
+            {
+                ++line;
+                continue;
+            }
+            auto p = iGlyphParagraphs.begin() + line->paragraph.first;
+            auto const& wrapping = wrap_paragraph(p->first, p->first.wrapping()->availableWidth, false);
+            newLines.clear();
+            newAdvances.clear();
+            for (auto const& wrappedLine : wrapping.lines)
+            {
+                newLines.push_back(to_glyph_line(p, wrappedLine, false));
+                newAdvances.push_back(wrappedLine.advance);
+                iTextExtents.cx = std::max(iTextExtents.cx, wrappedLine.extents.cx);
+            }
+            line = column.replace_line(line, newLines, newAdvances);
+        }
+        iTextExtents.cy += column.height() - oldHeight;
+    }
+
     void text_edit::animate()
     {
         if (neolib::service<neolib::i_power>().green_mode_active())
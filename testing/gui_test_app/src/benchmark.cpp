@@ -0,0 +1,378 @@
+﻿#include <neogfx/neogfx.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <thread>
+#include <neolib/core/random.hpp>
+#include <neogfx/gfx/rect_pack.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/text/text_category_map.hpp>
+#include <neogfx/gui/widget/text_edit.hpp>
+#include <neogfx/gui/widget/item_model.hpp>
+#include <neogfx/gui/widget/item_presentation_model.hpp>
+#include <neogfx/gui/widget/item_selection_model.hpp>
+#include <neogfx/game/ecs.hpp>
+#include <neogfx/game/clock.hpp>
+#include <neogfx/game/time.hpp>
+#include <neogfx/game/game_world.hpp>
+#include <neogfx/game/rigid_body.hpp>
+#include <neogfx/game/simple_physics.hpp>
+#include <neogfx/game/collision_detector.hpp>
+#include <neogfx/game/mesh_filter.hpp>
+#include <neogfx/game/box_collider.hpp>
+#include <neogfx/game/standard_archetypes.hpp>
+
+namespace ng = neogfx;
+
+namespace
+{
+    template <typename Operation>
+    double time_ms(Operation aOperation)
+    {
+        auto const start = std::chrono::high_resolution_clock::now();
+        aOperation();
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // the binary search of the range table that the two-stage text category table replaced
+    ng::text_category binary_search_text_category(char32_t aCodePoint)
+    {
+        auto const rangeEnd = std::upper_bound(
+            std::begin(ng::detail::text_category_MAP), std::end(ng::detail::text_category_MAP), aCodePoint,
+            [](char32_t aLhs, ng::detail::text_category_MAP_VALUE_TYPE const& aRhs) { return aLhs < aRhs.first; });
+        return rangeEnd != std::begin(ng::detail::text_category_MAP) ? std::prev(rangeEnd)->second : ng::detail::text_category_MAP[0].second;
+    }
+}
+
+// Times the selection operations an item view performs (select all, shift-click range, ctrl-click toggle) on
+// a large sorted table along with sorted inserts into it whilst it has a fragmented selection.
+std::string benchmark_selection(std::uint32_t aRows)
+{
+    std::ostringstream result;
+
+    ng::item_model itemModel;
+    itemModel.set_column_name(0, "Value");
+    itemModel.reserve(aRows);
+    for (std::uint32_t row = 0; row < aRows; ++row)
+        itemModel.insert_item(itemModel.end(), ng::item_cell_data{ row * 2u });
+    ng::item_presentation_model presentationModel{ itemModel, true };
+    ng::item_selection_model selectionModel{ presentationModel, ng::item_selection_mode::ExtendedSelection };
+
+    result << "Selection benchmark (" << aRows << " rows)" << std::endl;
+
+    result << "  select all: " << time_ms([&]() { selectionModel.select_all(); }) << " ms" << std::endl;
+    result << "  clear: " << time_ms([&]() { selectionModel.clear(ng::item_presentation_model_index{ 0u }); }) << " ms" << std::endl;
+
+    std::uint32_t const ranges = 1000u;
+    result << "  shift range (x" << ranges << "): " << time_ms([&]()
+    {
+        for (std::uint32_t i = 0; i < ranges; ++i)
+            selectionModel.select(
+                ng::item_presentation_model_index{ i },
+                ng::item_presentation_model_index{ aRows - 1u - i },
+                ng::item_selection_operation::ClearAndSelect);
+    }) << " ms" << std::endl;
+
+    std::uint32_t const toggles = std::min(aRows / 2u, 100000u);
+    result << "  ctrl toggle (x" << toggles << "): " << time_ms([&]()
+    {
+        for (std::uint32_t i = 0; i < toggles; ++i)
+            selectionModel.select(ng::item_presentation_model_index{ i * 2u }, ng::item_selection_operation::Toggle);
+    }) << " ms" << std::endl;
+
+    std::size_t selected = 0u;
+    result << "  is_selected (x" << aRows << "): " << time_ms([&]()
+    {
+        for (std::uint32_t row = 0; row < aRows; ++row)
+            if (selectionModel.is_selected(ng::item_presentation_model_index{ row }))
+                ++selected;
+    }) << " ms (" << selected << " selected)" << std::endl;
+
+    std::uint32_t const inserts = 1000u;
+    result << "  sorted insert (x" << inserts << "): " << time_ms([&]()
+    {
+        for (std::uint32_t i = 0; i < inserts; ++i)
+            itemModel.insert_item(itemModel.end(), ng::item_cell_data{ (i * 7919u) % (aRows * 2u) + 1u });
+    }) << " ms" << std::endl;
+
+    return result.str();
+}
+
+// Sorts a large table on a string column in each direction, again when already in order and then with parallel
+// sort key evaluation. Half of the strings share a long prefix so that comparisons can't all be decided by the
+// leading characters.
+std::string benchmark_sort(std::uint32_t aRows)
+{
+    std::ostringstream result;
+
+    neolib::basic_random<std::uint32_t> prng{ 42 };
+    ng::item_model itemModel;
+    itemModel.set_column_name(0, "Name");
+    itemModel.reserve(aRows);
+    for (std::uint32_t row = 0; row < aRows; ++row)
+    {
+        std::string name = (row % 2u == 0u ? "Customer Account " : "");
+        for (std::uint32_t length = prng(8u) + 8u; length > 0u; --length)
+            name += static_cast<char>(prng(1u) == 0u ? 'a' + prng(25u) : 'A' + prng(25u));
+        itemModel.insert_item(itemModel.end(), ng::item_cell_data{ std::move(name) });
+    }
+    ng::item_presentation_model presentationModel{ itemModel };
+
+    result << "Sort benchmark (" << aRows << " rows)" << std::endl;
+
+    result << "  ascending: " << time_ms([&]() { presentationModel.sort_by(0, ng::i_item_presentation_model::sort_direction::Ascending); }) << " ms" << std::endl;
+    result << "  descending: " << time_ms([&]() { presentationModel.sort_by(0, ng::i_item_presentation_model::sort_direction::Descending); }) << " ms" << std::endl;
+    result << "  descending (already sorted): " << time_ms([&]() { presentationModel.sort_by(0, ng::i_item_presentation_model::sort_direction::Descending); }) << " ms" << std::endl;
+
+    // item_model reads are thread safe so sort keys can also be extracted on the thread pool
+    presentationModel.set_parallel_evaluation(true);
+    result << "  ascending (parallel evaluation): " << time_ms([&]() { presentationModel.sort_by(0, ng::i_item_presentation_model::sort_direction::Ascending); }) << " ms" << std::endl;
+
+    return result.str();
+}
+
+// Steps simple_physics over the same bodies serially and then with parallel integration limited to an increasing
+// number of threads, reporting integrated bodies per second for each.
+std::string benchmark_physics(std::uint32_t aBodies, std::uint32_t aSteps)
+{
+    std::ostringstream result;
+
+    ng::game::ecs ecs{ ng::game::ecs_flags::Default | ng::game::ecs_flags::NoThreads };
+    auto& physics = ecs.system<ng::game::simple_physics>();
+    physics.yield_after(std::chrono::duration<double, std::milli>{ 60000.0 });
+
+    ng::game::sprite_archetype const body{ "Body" };
+    neolib::basic_random<ng::scalar> prng;
+    for (std::uint32_t i = 0; i < aBodies; ++i)
+        ecs.create_entity(body, ng::game::rigid_body
+        {
+            { prng(800.0), prng(800.0), 0.0 }, 1.0,
+            { prng(2.0) - 1.0, prng(2.0) - 1.0, 0.0 }
+        });
+
+    std::uint64_t stepsTaken = 0u;
+    ng::sink sink;
+    sink += ecs.system<ng::game::game_world>().PhysicsApplied([&](ng::game::step_time) { ++stepsTaken; });
+
+    auto run = [&]()
+    {
+        // wind the world clock back so that a single apply() catches up by (at least) aSteps steps
+        {
+            ng::game::shared_component_scoped_lock<ng::game::clock> lockClock{ ecs };
+            auto& worldClock = ecs.shared_component<ng::game::clock>()[0];
+            worldClock.time = ecs.system<ng::game::time>().system_time() - static_cast<decltype(worldClock.time)>(aSteps) * worldClock.timestep;
+        }
+        stepsTaken = 0u;
+        auto const ms = time_ms([&]() { physics.apply(); });
+        return ms > 0.0 ? static_cast<double>(stepsTaken) * aBodies / (ms / 1000.0) : 0.0;
+    };
+
+    result << "Physics benchmark (" << aBodies << " bodies, " << aSteps << " steps)" << std::endl;
+
+    physics.disable_parallel_integration();
+    result << "  serial: " << static_cast<std::uint64_t>(run()) << " bodies/s" << std::endl;
+
+    std::size_t const maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1u; ; threads = std::min(threads * 2u, maxThreads))
+    {
+        physics.enable_parallel_integration(threads);
+        result << "  parallel (" << threads << " thread(s)): " << static_cast<std::uint64_t>(run()) << " bodies/s" << std::endl;
+        if (threads == maxThreads)
+            break;
+    }
+    physics.disable_parallel_integration();
+
+    return result.str();
+}
+
+// Compares the collision detector's broadphase algorithms on the same moving colliders, first spread uniformly
+// over the world and then packed into a few dense clusters, reporting the time per detection cycle and the
+// number of colliding pairs found (which should agree between the algorithms).
+std::string benchmark_broadphase(std::uint32_t aColliders, std::uint32_t aCycles)
+{
+    std::ostringstream result;
+
+    result << "Broadphase benchmark (" << aColliders << " colliders, " << aCycles << " cycles)" << std::endl;
+
+    ng::scalar const worldSize = 4000.0;
+    ng::scalar const halfExtent = 4.0;
+    ng::game::mesh square;
+    square.vertices = { { -halfExtent, -halfExtent, 0.0 }, { halfExtent, -halfExtent, 0.0 }, { halfExtent, halfExtent, 0.0 }, { -halfExtent, halfExtent, 0.0 } };
+    square.faces = { { 0u, 1u, 2u }, { 0u, 2u, 3u } };
+    ng::game::sprite_archetype const body{ "Collider" };
+
+    for (bool clustered : { false, true })
+    {
+        for (auto algorithm : { ng::game::broadphase_algorithm::PartitionTree, ng::game::broadphase_algorithm::AabbTree })
+        {
+            ng::game::ecs ecs{ ng::game::ecs_flags::Default | ng::game::ecs_flags::NoThreads };
+            auto& detector = ecs.system<ng::game::collision_detector>();
+            detector.set_broadphase(algorithm);
+
+            // same seed for both algorithms so that they see identical worlds
+            neolib::basic_random<ng::scalar> prng{ 42 };
+            std::vector<ng::vec3> clusters;
+            for (int i = 0; i < 16; ++i)
+                clusters.push_back(ng::vec3{ prng(worldSize), prng(worldSize), 0.0 });
+            for (std::uint32_t i = 0; i < aColliders; ++i)
+            {
+                ng::vec3 position;
+                if (!clustered)
+                    position = ng::vec3{ prng(worldSize), prng(worldSize), 0.0 };
+                else
+                    position = clusters[i % clusters.size()] + ng::vec3{ prng(200.0) - 100.0, prng(200.0) - 100.0, 0.0 };
+                ecs.create_entity(body, ng::game::mesh_filter{ {}, square }, ng::game::rigid_body{ position, 1.0 }, ng::game::box_collider_2d{ 0x1ull });
+            }
+
+            std::uint64_t pairs = 0u;
+            ng::sink sink;
+            detector.Collision.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
+            sink += detector.Collision([&](ng::game::entity_id, ng::game::entity_id) { ++pairs; });
+
+            detector.run_cycle();
+            pairs = 0u;
+            double ms = 0.0;
+            for (std::uint32_t cycle = 0; cycle < aCycles; ++cycle)
+            {
+                for (auto& rigidBody : ecs.component<ng::game::rigid_body>().component_data())
+                    rigidBody.position += ng::vec3{ prng(2.0) - 1.0, prng(2.0) - 1.0, 0.0 };
+                ms += time_ms([&]() { detector.run_cycle(); });
+            }
+
+            result << "  " << (clustered ? "clustered" : "uniform") << ", " <<
+                (algorithm == ng::game::broadphase_algorithm::AabbTree ? "AABB tree" : "partition tree") << ": " <<
+                ms / aCycles << " ms/cycle, " << pairs / aCycles << " pairs/cycle" << std::endl;
+        }
+    }
+
+    return result.str();
+}
+
+// Packs the same stream of glyph sized rectangles into a page with each rect_pack algorithm, inserting them one
+// at a time and then as a single batch, reporting the time taken, how many fitted and the page occupancy.
+std::string benchmark_rect_pack(ng::size const& aPageExtents, std::uint32_t aElements)
+{
+    std::ostringstream result;
+
+    neolib::basic_random<ng::scalar> prng{ 42 };
+    std::vector<ng::size> elements;
+    elements.reserve(aElements);
+    for (std::uint32_t i = 0; i < aElements; ++i)
+        elements.push_back(ng::size{ std::floor(prng(44.0)) + 4.0, std::floor(prng(58.0)) + 6.0 });
+
+    result << "Rect pack benchmark (" << aPageExtents.cx << "x" << aPageExtents.cy << " page, " << aElements << " elements)" << std::endl;
+
+    for (auto algorithm : { ng::rect_pack_algorithm::Guillotine, ng::rect_pack_algorithm::MaxRects, ng::rect_pack_algorithm::Skyline })
+    {
+        std::string const name = (algorithm == ng::rect_pack_algorithm::Guillotine ? "Guillotine" :
+            algorithm == ng::rect_pack_algorithm::MaxRects ? "MaxRects" : "Skyline");
+        {
+            ng::rect_pack pack{ aPageExtents, algorithm };
+            std::size_t fitted = 0u;
+            auto const ms = time_ms([&]()
+            {
+                ng::rect placement;
+                for (auto const& element : elements)
+                    if (pack.insert(element, placement))
+                        ++fitted;
+            });
+            result << "  " << name << ", single: " << ms << " ms, " << fitted << " fitted, " << pack.occupancy() * 100.0 << "% occupancy" << std::endl;
+        }
+        {
+            ng::rect_pack pack{ aPageExtents, algorithm };
+            std::vector<ng::optional_rect> placements;
+            std::size_t fitted = 0u;
+            auto const ms = time_ms([&]() { fitted = pack.insert(elements, placements); });
+            result << "  " << name << ", batch: " << ms << " ms, " << fitted << " fitted, " << pack.occupancy() * 100.0 << "% occupancy" << std::endl;
+        }
+    }
+
+    return result.str();
+}
+
+// Inserts single characters at positions spread through a large document, timing each insert_text() call along
+// with the reshaping of the edited paragraph that it performs, after first timing the shaping of the whole document.
+std::string benchmark_text_edit(std::uint32_t aParagraphs, std::uint32_t aInserts)
+{
+    std::ostringstream result;
+
+    std::string text;
+    for (std::uint32_t paragraph = 0; paragraph < aParagraphs; ++paragraph)
+        text += "Paragraph " + std::to_string(paragraph) + ": the quick brown fox jumps over the lazy dog.\n";
+
+    ng::text_edit edit;
+    edit.resize(ng::size{ 640.0, 480.0 });
+
+    result << "Text edit benchmark (" << aParagraphs << " paragraphs, " << aInserts << " inserts)" << std::endl;
+
+    std::size_t length = 0u;
+    result << "  set text and shape: " << time_ms([&]()
+    {
+        length = edit.set_text(text);
+        edit.complete_shaping();
+    }) << " ms" << std::endl;
+
+    double const ms = time_ms([&]()
+    {
+        for (std::uint32_t i = 0; i < aInserts; ++i)
+        {
+            edit.insert_text(static_cast<ng::text_edit::position_type>((static_cast<std::uint64_t>(i) * 7919u) % length), "x");
+            ++length;
+        }
+    });
+    result << "  single character insert (x" << aInserts << "): " << ms << " ms (" << ms / aInserts << " ms/insert)" << std::endl;
+
+    return result.str();
+}
+
+// Checks that the two-stage text category table agrees with a binary search of the range table for every code
+// point and then compares the two on Latin, CJK and Arabic text, with get_text_categories() (which also consults
+// the emoji atlas) for reference.
+std::string benchmark_text_category(std::uint32_t aCharacters)
+{
+    std::ostringstream result;
+
+    result << "Text category benchmark (" << aCharacters << " characters)" << std::endl;
+
+    auto const& table = ng::detail::text_category_table::instance();
+    std::uint32_t mismatches = 0u;
+    for (char32_t ch = 0u; ch <= 0x10FFFDu; ++ch)
+        if (table[ch] != binary_search_text_category(ch))
+        {
+            if (++mismatches <= 10u)
+                result << "  U+" << std::hex << std::uppercase << static_cast<std::uint32_t>(ch) << std::dec << ": table disagrees with binary search" << std::endl;
+        }
+    result << "  agreement (U+0000-U+10FFFD): " << (mismatches == 0u ? "pass" : "FAIL, " + std::to_string(mismatches) + " mismatch(es)") << std::endl;
+
+    auto const& emojiAtlas = ng::service<ng::i_font_manager>().emoji_atlas();
+    std::u32string const latin = U"The quick brown fox jumps over the lazy dog, 0123456789. ";
+    std::u32string const cjk = U"\u6211\u80FD\u541E\u4E0B\u73BB\u7483\u800C\u4E0D\u4F24\u8EAB\u4F53\u3002\u3053\u3093\u306B\u3061\u306F\u4E16\u754C\uAC00\uB098\uB2E4 ";
+    std::u32string const arabic = U"\u0623\u0633\u062A\u0637\u064A\u0639 \u0623\u0646 \u0622\u0643\u0644 \u0627\u0644\u0632\u062C\u0627\u062C \u0648\u0647\u0630\u0627 \u0644\u0627 \u064A\u0624\u0644\u0645\u0646\u064A. ";
+    for (auto const& sample : { std::make_pair("Latin", &latin), std::make_pair("CJK", &cjk), std::make_pair("Arabic", &arabic) })
+    {
+        std::u32string text;
+        text.reserve(aCharacters);
+        while (text.size() < aCharacters)
+            text += sample.second->substr(0, aCharacters - text.size());
+        std::vector<ng::text_category> categories(text.size());
+        auto const binarySearch = time_ms([&]()
+        {
+            for (std::size_t i = 0; i < text.size(); ++i)
+                categories[i] = binary_search_text_category(text[i]);
+        });
+        auto const twoStage = time_ms([&]()
+        {
+            for (std::size_t i = 0; i < text.size(); ++i)
+                categories[i] = table[text[i]];
+        });
+        auto const withEmoji = time_ms([&]()
+        {
+            ng::get_text_categories(emojiAtlas, text.data(), text.data() + text.size(), categories.data());
+        });
+        result << "  " << sample.first << ": binary search " << binarySearch << " ms, two-stage table " << twoStage <<
+            " ms, get_text_categories " << withEmoji << " ms" << std::endl;
+    }
+
+    return result.str();
+}
\ No newline at end of file
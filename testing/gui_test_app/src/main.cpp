@@ -1,5 +1,7 @@
 ﻿#include <neolib/neolib.hpp>
+#include <algorithm>
 #include <csignal>
+#include <iostream>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <neolib/core/random.hpp>
@@ -219,6 +221,14 @@ private:
 };
 
 ng::game::i_ecs& create_game(ng::i_layout& aLayout);
+std::string benchmark_selection(std::uint32_t aRows);
+std::string benchmark_sort(std::uint32_t aRows);
+std::string benchmark_physics(std::uint32_t aBodies, std::uint32_t aSteps);
+std::string benchmark_broadphase(std::uint32_t aColliders, std::uint32_t aCycles);
+std::string benchmark_rect_pack(ng::size const& aPageExtents, std::uint32_t aElements);
+std::string benchmark_text_edit(std::uint32_t aParagraphs, std::uint32_t aInserts);
+std::string benchmark_text_category(std::uint32_t aCharacters);
+std::string test_golden_pixels(std::uint32_t& aFailures);
 
 void signal_handler(int signal)
 {
@@ -259,10 +269,25 @@ int main(int argc, char* argv[])
     egregious this function is a special case: it is test code which mostly just creates widgets. 
     Most of this code is about to disappear into code auto-generated by the neoGFX resource compiler! */
 
+    // --headless-test runs the render tests before any window is created (so it also works with --software
+    // whose renderer cannot create windows) and exits with the number of failed checks; it is removed from
+    // the command line before the app parses its options.
+    auto const isHeadlessTest = [](char const* aArg) { return std::string{ aArg } == "--headless-test"; };
+    bool const headlessTest = std::any_of(argv + 1, argv + argc, isHeadlessTest);
+    if (headlessTest)
+        argc = static_cast<int>(std::remove_if(argv + 1, argv + argc, isHeadlessTest) - argv);
+
     test::main_app app{ argc, argv, "neoGFX Test App (Pre-Release)" };
 
     try
     {
+        if (headlessTest)
+        {
+            std::uint32_t failures = 0u;
+            std::cout << test_golden_pixels(failures) << std::flush;
+            return static_cast<int>(failures);
+        }
+
         app.register_style(ng::style("Keypad"));
         app.change_style("Keypad");
         app.current_style().palette().set_color(ng::color_role::Theme, ng::color::Black);
@@ -830,6 +855,40 @@ int main(int argc, char* argv[])
                 tableView2.column_header().show();
         });
 
+        window.buttonBenchmarkSelection.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_selection(1000000u), true);
+        });
+        window.buttonBenchmarkPhysics.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_physics(100000u, 100u), true);
+        });
+        window.buttonBenchmarkBroadphase.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_broadphase(20000u, 50u), true);
+        });
+        window.buttonBenchmarkRectPack.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_rect_pack(ng::size{ 1024.0, 1024.0 }, 2000u), true);
+        });
+        window.buttonBenchmarkTextEdit.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_text_edit(5000u, 1000u), true);
+        });
+        window.buttonBenchmarkTextCategory.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_text_category(10000000u), true);
+        });
+        window.buttonBenchmarkSort.clicked([&window]()
+        {
+            window.textEdit.append_text(benchmark_sort(1000000u), true);
+        });
+        window.buttonGoldenPixelTest.clicked([&window]()
+        {
+            std::uint32_t failures = 0u;
+            window.textEdit.append_text(test_golden_pixels(failures), true);
+        });
+
         my_item_model itemModel;
         #ifdef NDEBUG
         itemModel.reserve(500);
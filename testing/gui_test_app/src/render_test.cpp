@@ -0,0 +1,139 @@
+﻿#include <neogfx/neogfx.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <neogfx/gfx/texture.hpp>
+#include <neogfx/gfx/graphics_context.hpp>
+#include <neogfx/gui/widget/image_widget.hpp>
+
+namespace ng = neogfx;
+
+namespace
+{
+    ng::size const targetExtents{ 16.0, 8.0 };
+
+    struct golden_pixel
+    {
+        ng::scalar x;
+        ng::color expected;
+        bool checkAlpha;
+    };
+
+    // Pixels are probed on the middle row and every case varies only horizontally so results don't depend
+    // on the vertical orientation of the render target.
+    template <typename Draw>
+    void check(std::ostringstream& aResult, uint32_t& aFailures, std::string const& aName, Draw aDraw, std::initializer_list<golden_pixel> aPixels)
+    {
+        ng::texture target{ targetExtents, 1.0, ng::texture_sampling::Normal };
+        try
+        {
+            ng::graphics_context gc{ target };
+            gc.set_blending_mode(ng::blending_mode::None);
+            gc.fill_rect(ng::rect{ ng::point{}, targetExtents }, ng::color{ 0, 0, 0, 255 });
+            aDraw(gc);
+            gc.flush();
+        }
+        catch (std::exception& e)
+        {
+            ++aFailures;
+            aResult << "  " << aName << ": FAIL (" << e.what() << ")" << std::endl;
+            return;
+        }
+        bool passed = true;
+        for (auto const& pixel : aPixels)
+        {
+            auto const actual = target.get_pixel(ng::point{ pixel.x, std::floor(targetExtents.cy / 2.0) });
+            auto const matches = [](ng::color::view_component aActual, ng::color::view_component aExpected)
+            {
+                return std::abs(static_cast<int>(aActual) - static_cast<int>(aExpected)) <= 2;
+            };
+            if (!matches(actual.red(), pixel.expected.red()) || !matches(actual.green(), pixel.expected.green()) ||
+                !matches(actual.blue(), pixel.expected.blue()) || (pixel.checkAlpha && !matches(actual.alpha(), pixel.expected.alpha())))
+            {
+                passed = false;
+                aResult << "  " << aName << ": pixel " << pixel.x << " is " << actual.to_string() << ", expected " << pixel.expected.to_string() << std::endl;
+            }
+        }
+        if (!passed)
+            ++aFailures;
+        aResult << "  " << aName << ": " << (passed ? "pass" : "FAIL") << std::endl;
+    }
+}
+
+// Renders small fills, scissored fills, blended fills and a widget paint into a texture using the active renderer
+// (run the test app with --software --headless-test to check the software renderer) and compares probed pixels
+// with known values; aFailures is incremented for each failed check.
+std::string test_golden_pixels(uint32_t& aFailures)
+{
+    std::ostringstream result;
+    uint32_t failures = 0u;
+
+    result << "Golden pixel test" << std::endl;
+
+    check(result, failures, "fill", [](ng::graphics_context& aGc)
+    {
+        aGc.fill_rect(ng::rect{ ng::point{}, ng::size{ 8.0, targetExtents.cy } }, ng::color{ 255, 0, 0, 255 });
+        aGc.fill_rect(ng::rect{ ng::point{ 8.0, 0.0 }, ng::size{ 4.0, targetExtents.cy } }, ng::color{ 0, 255, 0, 255 });
+    },
+    {
+        { 0.0, ng::color{ 255, 0, 0, 255 }, true },
+        { 7.0, ng::color{ 255, 0, 0, 255 }, true },
+        { 8.0, ng::color{ 0, 255, 0, 255 }, true },
+        { 11.0, ng::color{ 0, 255, 0, 255 }, true },
+        { 12.0, ng::color{ 0, 0, 0, 255 }, true },
+        { 15.0, ng::color{ 0, 0, 0, 255 }, true }
+    });
+
+    check(result, failures, "scissor", [](ng::graphics_context& aGc)
+    {
+        aGc.scissor_on(ng::rect{ ng::point{ 4.0, 0.0 }, ng::size{ 8.0, targetExtents.cy } });
+        aGc.fill_rect(ng::rect{ ng::point{}, targetExtents }, ng::color{ 0, 0, 255, 255 });
+        aGc.scissor_off();
+    },
+    {
+        { 3.0, ng::color{ 0, 0, 0, 255 }, true },
+        { 4.0, ng::color{ 0, 0, 255, 255 }, true },
+        { 11.0, ng::color{ 0, 0, 255, 255 }, true },
+        { 12.0, ng::color{ 0, 0, 0, 255 }, true }
+    });
+
+    check(result, failures, "blending", [](ng::graphics_context& aGc)
+    {
+        aGc.fill_rect(ng::rect{ ng::point{}, targetExtents }, ng::color{ 255, 255, 255, 255 });
+        aGc.fill_rect(ng::rect{ ng::point{}, ng::size{ 8.0, targetExtents.cy } }, ng::color{ 255, 0, 0, 128 });
+        aGc.set_blending_mode(ng::blending_mode::Default);
+        aGc.fill_rect(ng::rect{ ng::point{ 8.0, 0.0 }, ng::size{ 8.0, targetExtents.cy } }, ng::color{ 255, 0, 0, 128 });
+    },
+    {
+        { 4.0, ng::color{ 255, 0, 0, 128 }, true },
+        { 12.0, ng::color{ 255, 127, 127, 255 }, false }
+    });
+
+    // The widget is painted directly so this needs no surface and can run before any window exists.
+    ng::texture image{ ng::size{ 8.0, 8.0 }, 1.0, ng::texture_sampling::Normal };
+    {
+        ng::graphics_context gc{ image };
+        gc.set_blending_mode(ng::blending_mode::None);
+        gc.fill_rect(ng::rect{ ng::point{}, ng::size{ 4.0, 8.0 } }, ng::color{ 255, 0, 0, 255 });
+        gc.fill_rect(ng::rect{ ng::point{ 4.0, 0.0 }, ng::size{ 4.0, 8.0 } }, ng::color{ 0, 255, 0, 255 });
+        gc.flush();
+    }
+    check(result, failures, "widget paint", [&](ng::graphics_context& aGc)
+    {
+        ng::image_widget widget{ image, ng::aspect_ratio::Keep, ng::cardinal::Center };
+        widget.resize(targetExtents);
+        widget.paint(aGc);
+    },
+    {
+        { 3.0, ng::color{ 0, 0, 0, 255 }, true },
+        { 4.0, ng::color{ 255, 0, 0, 255 }, true },
+        { 7.0, ng::color{ 255, 0, 0, 255 }, true },
+        { 8.0, ng::color{ 0, 255, 0, 255 }, true },
+        { 11.0, ng::color{ 0, 255, 0, 255 }, true },
+        { 12.0, ng::color{ 0, 0, 0, 255 }, true }
+    });
+
+    result << (failures == 0u ? "All golden pixel checks passed" : std::to_string(failures) + " golden pixel check(s) failed") << std::endl;
+    aFailures += failures;
+    return result.str();
+}
\ No newline at end of file